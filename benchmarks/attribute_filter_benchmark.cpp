@@ -0,0 +1,101 @@
+// Range filter on a numeric attribute: DocumentFilter over the attribute index against
+// a predicate looking the attribute up for every posting
+
+#include <chrono>
+#include <execution>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+const int DOCUMENT_COUNT = 200000;
+const int DOCUMENT_LENGTH = 20;
+const int VOCABULARY_SIZE = 20000;
+const int QUERY_COUNT = 200;
+const int64_t DATE_COUNT = 1000000;
+
+string GenerateWord(mt19937& generator) {
+    uniform_int_distribution<int> length(2, 10);
+    uniform_int_distribution<int> letter('a', 'z');
+    string word(length(generator), ' ');
+    for (char& c : word) {
+        c = static_cast<char>(letter(generator));
+    }
+    return word;
+}
+
+template <typename Func>
+double MeasureMicroseconds(Func func) {
+    const auto start = chrono::steady_clock::now();
+    func();
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator(42);
+    vector<string> vocabulary;
+    vector<double> weights;
+    for (int i = 0; i < VOCABULARY_SIZE; ++i) {
+        vocabulary.push_back(GenerateWord(generator));
+        weights.push_back(1.0 / (i + 1));
+    }
+    discrete_distribution<int> word_index(weights.begin(), weights.end());
+    uniform_int_distribution<int64_t> any_date(0, DATE_COUNT - 1);
+
+    IndexOptions options;
+    options.attributes = {{"date"s, AttributeType::INTEGER}};
+    SearchServer server(""s, options);
+    vector<int64_t> dates(DOCUMENT_COUNT);
+    for (int id = 0; id < DOCUMENT_COUNT; ++id) {
+        string document;
+        for (int j = 0; j < DOCUMENT_LENGTH; ++j) {
+            document += vocabulary[word_index(generator)] + " "s;
+        }
+        dates[id] = any_date(generator);
+        server.AddDocument(id, document, DocumentStatus::ACTUAL, {id % 10}, {{"date"s, dates[id]}});
+    }
+    // Frequent words, so that every query visits tens of thousands of postings
+    vector<string> queries;
+    uniform_int_distribution<int> frequent_word(0, 20);
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        queries.push_back(vocabulary[frequent_word(generator)] + " "s + vocabulary[frequent_word(generator)]);
+    }
+
+    cout << "selectivity | DocumentFilter, us | predicate, us | results equal" << endl;
+    for (const double selectivity : {0.001, 0.01, 0.1, 0.5}) {
+        const int64_t min_date = DATE_COUNT - static_cast<int64_t>(DATE_COUNT * selectivity);
+        const DocumentFilter filter = DocumentFilter(DocumentStatus::ACTUAL).AttributeAtLeast("date"s, min_date);
+        const auto predicate = [&dates, min_date](int document_id, DocumentStatus status, int) {
+            return status == DocumentStatus::ACTUAL && dates[document_id] >= min_date;
+        };
+        bool are_equal = true;
+        for (const string& query : queries) {
+            const vector<Document> filtered = server.FindTopDocuments(execution::seq, query, filter);
+            const vector<Document> predicated = server.FindTopDocuments(execution::seq, query, predicate);
+            are_equal = are_equal && filtered.size() == predicated.size();
+            for (size_t i = 0; are_equal && i < filtered.size(); ++i) {
+                are_equal = filtered[i].id == predicated[i].id;
+            }
+        }
+        const double filter_time = MeasureMicroseconds([&] {
+            for (const string& query : queries) {
+                server.FindTopDocuments(execution::seq, query, filter);
+            }
+        });
+        const double predicate_time = MeasureMicroseconds([&] {
+            for (const string& query : queries) {
+                server.FindTopDocuments(execution::seq, query, predicate);
+            }
+        });
+        cout << selectivity << " | " << filter_time / QUERY_COUNT << " | " << predicate_time / QUERY_COUNT << " | "
+             << (are_equal ? "yes" : "no") << endl;
+    }
+}
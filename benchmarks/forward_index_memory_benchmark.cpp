@@ -0,0 +1,120 @@
+// Heap usage of the index: the per-document word maps of the original layout
+// against the forward index of SearchServer, measured with mallinfo2
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+const int DOCUMENT_COUNT = 20000;
+const int DOCUMENT_LENGTH = 60;
+const int VOCABULARY_SIZE = 50000;
+
+string GenerateWord(mt19937& generator) {
+    uniform_int_distribution<int> length(3, 10);
+    uniform_int_distribution<int> letter('a', 'z');
+    string word(length(generator), ' ');
+    for (char& c : word) {
+        c = static_cast<char>(letter(generator));
+    }
+    return word;
+}
+
+#ifdef __GLIBC__
+size_t GetHeapUsage() {
+    return mallinfo2().uordblks;
+}
+#endif
+
+// Index structures of the layout before the forward index
+struct MapIndex {
+    struct DocumentData {
+        int rating;
+        DocumentStatus status;
+    };
+
+    map<string, map<int, double>> word_to_document_freqs;
+    map<int, map<string, double>> id_to_word_freqs;
+    map<int, DocumentData> documents;
+    set<int> document_ids;
+
+    void AddDocument(int document_id, const string& document) {
+        const vector<string_view> words = SplitIntoWords(document);
+        const double inv_word_count = 1.0 / words.size();
+        for (const string_view word : words) {
+            word_to_document_freqs[string(word)][document_id] += inv_word_count;
+            id_to_word_freqs[document_id][string(word)] += inv_word_count;
+        }
+        documents.emplace(document_id, DocumentData{1, DocumentStatus::ACTUAL});
+        document_ids.insert(document_id);
+    }
+};
+
+void PrintUsage(const string& name, size_t bytes) {
+    cout << name << ": " << bytes / 1e6 << " MB, " << bytes / DOCUMENT_COUNT << " B/doc" << endl;
+}
+
+}  // namespace
+
+int main() {
+#ifndef __GLIBC__
+    cout << "mallinfo2 is not available" << endl;
+#else
+    mt19937 generator(42);
+    vector<string> vocabulary;
+    for (int i = 0; i < VOCABULARY_SIZE; ++i) {
+        vocabulary.push_back(GenerateWord(generator));
+    }
+    uniform_int_distribution<int> word_index(0, VOCABULARY_SIZE - 1);
+    vector<string> documents;
+    size_t word_count = 0;
+    for (int i = 0; i < DOCUMENT_COUNT; ++i) {
+        string document;
+        set<int> words;
+        for (int j = 0; j < DOCUMENT_LENGTH; ++j) {
+            const int index = word_index(generator);
+            words.insert(index);
+            document += vocabulary[index];
+            document += ' ';
+        }
+        word_count += words.size();
+        documents.push_back(move(document));
+    }
+
+    {
+        const size_t start = GetHeapUsage();
+        MapIndex index;
+        for (int id = 0; id < DOCUMENT_COUNT; ++id) {
+            index.AddDocument(id, documents[id]);
+        }
+        const size_t total = GetHeapUsage() - start;
+        const size_t before_forward_index = GetHeapUsage();
+        index.id_to_word_freqs.clear();
+        PrintUsage("before, total", total);
+        PrintUsage("before, forward index", before_forward_index - GetHeapUsage());
+    }
+    {
+        const size_t start = GetHeapUsage();
+        SearchServer server(""s);
+        for (int id = 0; id < DOCUMENT_COUNT; ++id) {
+            server.AddDocument(id, documents[id], DocumentStatus::ACTUAL, {1});
+        }
+        PrintUsage("after, total", GetHeapUsage() - start);
+        // The records themselves; the per-document headers are counted in the total only
+        PrintUsage("after, forward index records", word_count * sizeof(TermFrequency));
+    }
+#endif
+}
@@ -0,0 +1,115 @@
+// Index footprint, indexing time and query latency with different upstream memory resources,
+// and the memory of every index structure
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "memory_stats.h"
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+const int DOCUMENT_COUNT = 50000;
+const int DOCUMENT_LENGTH = 30;
+const int VOCABULARY_SIZE = 20000;
+const int QUERY_COUNT = 1000;
+
+string GenerateWord(mt19937& generator) {
+    uniform_int_distribution<int> length(2, 10);
+    uniform_int_distribution<int> letter('a', 'z');
+    string word(length(generator), ' ');
+    for (char& c : word) {
+        c = static_cast<char>(letter(generator));
+    }
+    return word;
+}
+
+template <typename Func>
+double MeasureMilliseconds(Func func) {
+    const auto start = chrono::steady_clock::now();
+    func();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator(42);
+    vector<string> vocabulary;
+    vector<double> weights;
+    for (int i = 0; i < VOCABULARY_SIZE; ++i) {
+        vocabulary.push_back(GenerateWord(generator));
+        weights.push_back(1.0 / (i + 1));
+    }
+    discrete_distribution<int> word_index(weights.begin(), weights.end());
+    vector<string> documents;
+    for (int i = 0; i < DOCUMENT_COUNT; ++i) {
+        string document;
+        for (int j = 0; j < DOCUMENT_LENGTH; ++j) {
+            document += vocabulary[word_index(generator)] + " "s;
+        }
+        documents.push_back(move(document));
+    }
+    uniform_int_distribution<int> any_word(0, VOCABULARY_SIZE - 1);
+    vector<string> queries;
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        queries.push_back(vocabulary[any_word(generator)] + " "s + vocabulary[any_word(generator)] + " "s
+                          + vocabulary[word_index(generator)]);
+    }
+
+    // Every resource gets its memory from a counter over new/delete, which shows the real footprint
+    const vector<pair<string, function<unique_ptr<pmr::memory_resource>(pmr::memory_resource*)>>> resources = {
+        {"new/delete"s, [](pmr::memory_resource*) {
+             return unique_ptr<pmr::memory_resource>();
+         }},
+        {"synchronized pool"s, [](pmr::memory_resource* upstream) {
+             return make_unique<pmr::synchronized_pool_resource>(upstream);
+         }},
+        {"unsynchronized pool"s, [](pmr::memory_resource* upstream) {
+             return make_unique<pmr::unsynchronized_pool_resource>(upstream);
+         }},
+        {"monotonic"s, [](pmr::memory_resource* upstream) {
+             return make_unique<pmr::monotonic_buffer_resource>(upstream);
+         }},
+    };
+    cout << "resource | requested, MB | footprint, MB | blocks | AddDocument, ms | query, us" << endl;
+    for (const auto& [name, make_resource] : resources) {
+        CountingMemoryResource footprint(pmr::new_delete_resource());
+        const unique_ptr<pmr::memory_resource> resource = make_resource(&footprint);
+        IndexOptions options;
+        options.memory_resource = resource ? resource.get() : &footprint;
+        MemoryStats stats;
+        size_t footprint_bytes = 0;
+        double indexing_time = 0.0;
+        double query_time = 0.0;
+        {
+            SearchServer server(""s, options);
+            indexing_time = MeasureMilliseconds([&] {
+                for (int id = 0; id < DOCUMENT_COUNT; ++id) {
+                    server.AddDocument(id, documents[id], DocumentStatus::ACTUAL, {id % 10});
+                }
+            });
+            query_time = MeasureMilliseconds([&] {
+                for (const string& query : queries) {
+                    server.FindTopDocuments(execution::seq, query);
+                }
+            });
+            stats = server.GetMemoryStats();
+            footprint_bytes = footprint.GetUsage().bytes;
+        }
+        const MemoryUsage total = stats.GetTotal();
+        cout << name << " | " << total.bytes / 1e6 << " | " << footprint_bytes / 1e6 << " | "
+             << total.allocations << " | " << indexing_time << " | " << query_time * 1000 / QUERY_COUNT << endl;
+        if (!resource) {
+            cout << stats;
+        }
+    }
+}
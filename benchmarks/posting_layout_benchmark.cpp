@@ -0,0 +1,200 @@
+// Hardware counters of the posting list scans: scoring of FindTopDocuments and FindTopDocumentsWith and
+// posting lookups of MatchDocument, with and without software prefetching (IndexOptions::prefetch_min_documents).
+// Counters come from perf_event_open and are reported as n/a where the kernel or the machine lacks them.
+// Usage: posting_layout_benchmark [documents]
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <execution>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+const int DOCUMENT_LENGTH = 20;
+const int VOCABULARY_SIZE = 50000;
+const int QUERY_COUNT = 200;
+const int MATCH_COUNT = 20000;
+
+string GenerateWord(mt19937& generator) {
+    uniform_int_distribution<int> length(2, 10);
+    uniform_int_distribution<int> letter('a', 'z');
+    string word(length(generator), ' ');
+    for (char& c : word) {
+        c = static_cast<char>(letter(generator));
+    }
+    return word;
+}
+
+// Counts user-space events of the calling thread between Start and Stop
+class PerfCounters {
+public:
+    static const size_t EVENT_COUNT = 4;
+
+    PerfCounters() {
+        descriptors_.fill(-1);
+#ifdef __linux__
+        const array<pair<uint32_t, uint64_t>, EVENT_COUNT> events = {{
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                 | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        }};
+        for (size_t i = 0; i < EVENT_COUNT; ++i) {
+            perf_event_attr attributes;
+            memset(&attributes, 0, sizeof(attributes));
+            attributes.size = sizeof(attributes);
+            attributes.type = events[i].first;
+            attributes.config = events[i].second;
+            attributes.disabled = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            descriptors_[i] = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (const int descriptor : descriptors_) {
+            if (descriptor >= 0) {
+                close(descriptor);
+            }
+        }
+#endif
+    }
+
+    void Start() {
+#ifdef __linux__
+        for (const int descriptor : descriptors_) {
+            if (descriptor >= 0) {
+                ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+                ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    // Event values, negative for unavailable events
+    array<long long, EVENT_COUNT> Stop() {
+        array<long long, EVENT_COUNT> values;
+        values.fill(-1);
+#ifdef __linux__
+        for (size_t i = 0; i < EVENT_COUNT; ++i) {
+            if (descriptors_[i] < 0) {
+                continue;
+            }
+            ioctl(descriptors_[i], PERF_EVENT_IOC_DISABLE, 0);
+            long long value = 0;
+            if (read(descriptors_[i], &value, sizeof(value)) == sizeof(value)) {
+                values[i] = value;
+            }
+        }
+#endif
+        return values;
+    }
+
+private:
+    array<int, EVENT_COUNT> descriptors_;
+};
+
+template <typename Func>
+void Measure(const string& name, int operation_count, PerfCounters& counters, Func func) {
+    const auto start = chrono::steady_clock::now();
+    counters.Start();
+    func();
+    const auto values = counters.Stop();
+    const double microseconds = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    cout << name << " | " << microseconds / operation_count;
+    for (const long long value : values) {
+        cout << " | ";
+        if (value < 0) {
+            cout << "n/a";
+        } else {
+            cout << static_cast<double>(value) / operation_count;
+        }
+    }
+    cout << endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const int document_count = argc > 1 ? stoi(argv[1]) : 300000;
+    mt19937 generator(42);
+    vector<string> vocabulary;
+    vector<double> weights;
+    for (int i = 0; i < VOCABULARY_SIZE; ++i) {
+        vocabulary.push_back(GenerateWord(generator));
+        weights.push_back(1.0 / (i + 1));
+    }
+    discrete_distribution<int> word_index(weights.begin(), weights.end());
+    vector<string> documents;
+    for (int id = 0; id < document_count; ++id) {
+        string document;
+        for (int j = 0; j < DOCUMENT_LENGTH; ++j) {
+            document += vocabulary[word_index(generator)] + " "s;
+        }
+        documents.push_back(move(document));
+    }
+    // A frequent word and a word of the middle of the distribution, so that both dense and sparse lists are scanned
+    vector<string> queries;
+    uniform_int_distribution<int> frequent_word(0, 20);
+    uniform_int_distribution<int> middle_word(100, 2000);
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        queries.push_back(vocabulary[frequent_word(generator)] + " "s + vocabulary[middle_word(generator)]);
+    }
+    uniform_int_distribution<int> any_document(0, document_count - 1);
+    vector<int> matched_ids;
+    for (int i = 0; i < MATCH_COUNT; ++i) {
+        matched_ids.push_back(any_document(generator));
+    }
+
+    PerfCounters counters;
+    for (const bool prefetch : {false, true}) {
+        IndexOptions options;
+        options.prefetch_min_documents = prefetch ? 0 : numeric_limits<size_t>::max();
+        SearchServer server(""s, options);
+        for (int id = 0; id < document_count; ++id) {
+            server.AddDocument(id, documents[id], DocumentStatus::ACTUAL, {id % 10});
+        }
+        cout << (prefetch ? "prefetch"s : "no prefetch"s) << ", postings: " << server.GetMemoryStats().postings.bytes << " bytes" << endl;
+        cout << "operation | us | instructions | cycles | L1d read misses | cache misses" << endl;
+        for (int round = 0; round < 5; ++round) {
+            Measure("FindTopDocuments"s, QUERY_COUNT, counters, [&] {
+                for (const string& query : queries) {
+                    server.FindTopDocuments(execution::seq, query);
+                }
+            });
+            Measure("FindTopDocumentsWith<Bm25Scorer>"s, QUERY_COUNT, counters, [&] {
+                for (const string& query : queries) {
+                    server.FindTopDocumentsWith<Bm25Scorer>(query);
+                }
+            });
+            Measure("MatchDocument"s, MATCH_COUNT, counters, [&] {
+                for (int i = 0; i < MATCH_COUNT; ++i) {
+                    server.MatchDocument(execution::seq, queries[i % QUERY_COUNT], matched_ids[i]);
+                }
+            });
+        }
+    }
+}
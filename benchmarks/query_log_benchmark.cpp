@@ -0,0 +1,120 @@
+// Cost of logging queries: RequestQueue without and with a QueryLog, and QueryLog::Record()
+// alone from several threads
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "query_log.h"
+#include "request_queue.h"
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+const int DOCUMENT_COUNT = 20000;
+const int DOCUMENT_LENGTH = 20;
+const int VOCABULARY_SIZE = 20000;
+const int QUERY_COUNT = 50000;
+const int RECORDS_PER_THREAD = 1000000;
+
+string GenerateWord(mt19937& generator) {
+    uniform_int_distribution<int> length(2, 10);
+    uniform_int_distribution<int> letter('a', 'z');
+    string word(length(generator), ' ');
+    for (char& c : word) {
+        c = static_cast<char>(letter(generator));
+    }
+    return word;
+}
+
+template <typename Func>
+double MeasureNanoseconds(Func func) {
+    const auto start = chrono::steady_clock::now();
+    func();
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator(42);
+    vector<string> vocabulary;
+    for (int i = 0; i < VOCABULARY_SIZE; ++i) {
+        vocabulary.push_back(GenerateWord(generator));
+    }
+    uniform_int_distribution<int> any_word(0, VOCABULARY_SIZE - 1);
+    SearchServer server(""s);
+    for (int id = 0; id < DOCUMENT_COUNT; ++id) {
+        string document;
+        for (int j = 0; j < DOCUMENT_LENGTH; ++j) {
+            document += vocabulary[any_word(generator)] + " "s;
+        }
+        server.AddDocument(id, document, DocumentStatus::ACTUAL, {id % 10});
+    }
+    vector<string> queries;
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        queries.push_back(vocabulary[any_word(generator)] + " "s + vocabulary[any_word(generator)]);
+    }
+
+    const string path = "/tmp/query_log_benchmark.qlog"s;
+    double plain_time = 0.0;
+    double logged_time = 0.0;
+    // Rounds alternate which variant goes first, so that both see the same cache and frequency conditions
+    const auto run_plain = [&] {
+        RequestQueue queue(server);
+        plain_time += MeasureNanoseconds([&] {
+            for (const string& query : queries) {
+                queue.AddFindRequest(query);
+            }
+        });
+    };
+    const auto run_logged = [&] {
+        QueryLog log(path);
+        RequestQueue queue(server, &log);
+        logged_time += MeasureNanoseconds([&] {
+            for (const string& query : queries) {
+                queue.AddFindRequest(query);
+            }
+        });
+        log.Flush();
+    };
+    for (int round = 0; round < 4; ++round) {
+        if (round % 2 == 0) {
+            run_plain();
+            run_logged();
+        } else {
+            run_logged();
+            run_plain();
+        }
+    }
+    cout << "RequestQueue::AddFindRequest, ns: without log " << plain_time / (4 * QUERY_COUNT) << ", with log "
+         << logged_time / (4 * QUERY_COUNT) << endl;
+
+    cout << "threads | Record, ns | dropped" << endl;
+    for (int thread_count : {1, 2, 4}) {
+        QueryLog log(path);
+        const DocumentFilter filter(DocumentStatus::ACTUAL);
+        const double time = MeasureNanoseconds([&] {
+            vector<thread> threads;
+            for (int i = 0; i < thread_count; ++i) {
+                threads.emplace_back([&] {
+                    for (int j = 0; j < RECORDS_PER_THREAD; ++j) {
+                        log.Record(queries[j % QUERY_COUNT], &filter, QueryLog::Now(), 100, 10);
+                    }
+                });
+            }
+            for (thread& t : threads) {
+                t.join();
+            }
+        });
+        log.Flush();
+        cout << thread_count << " | " << time / RECORDS_PER_THREAD << " | " << log.GetDroppedCount() << endl;
+    }
+    remove(path.c_str());
+}
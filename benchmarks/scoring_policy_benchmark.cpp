@@ -0,0 +1,118 @@
+// FindTopDocuments against FindTopDocumentsWith with different policies on a Zipf-distributed collection
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+const int DOCUMENT_COUNT = 100000;
+const int DOCUMENT_LENGTH = 30;
+const int VOCABULARY_SIZE = 20000;
+const int QUERY_COUNT = 300;
+const int QUERY_LENGTH = 3;
+
+string GenerateWord(mt19937& generator) {
+    uniform_int_distribution<int> length(3, 10);
+    uniform_int_distribution<int> letter('a', 'z');
+    string word(length(generator), ' ');
+    for (char& c : word) {
+        c = static_cast<char>(letter(generator));
+    }
+    return word;
+}
+
+template <typename Search>
+void Measure(const string& name, const vector<string>& queries, Search search) {
+    size_t found_count = 0;
+    const auto start = chrono::steady_clock::now();
+    for (const string& query : queries) {
+        found_count += search(query).size();
+    }
+    const double elapsed = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    cout << name << ": " << static_cast<int>(elapsed / queries.size()) << " us/query (" << found_count << " found)" << endl;
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator(42);
+    vector<string> vocabulary;
+    for (int i = 0; i < VOCABULARY_SIZE; ++i) {
+        vocabulary.push_back(GenerateWord(generator));
+    }
+    vector<double> weights;
+    for (int i = 0; i < VOCABULARY_SIZE; ++i) {
+        weights.push_back(1.0 / (i + 1));
+    }
+    discrete_distribution<int> word_index(weights.begin(), weights.end());
+    uniform_int_distribution<int> status(0, 9);
+    uniform_int_distribution<int> rating(-10, 10);
+
+    SearchServer server(""s);
+    for (int id = 0; id < DOCUMENT_COUNT; ++id) {
+        string document;
+        for (int j = 0; j < DOCUMENT_LENGTH; ++j) {
+            document += vocabulary[word_index(generator)];
+            document += ' ';
+        }
+        // Nine documents of ten are actual
+        server.AddDocument(id, document, status(generator) == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL,
+                           {rating(generator)});
+    }
+    vector<string> queries;
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        string query;
+        for (int j = 0; j < QUERY_LENGTH; ++j) {
+            query += vocabulary[word_index(generator)];
+            query += ' ';
+        }
+        queries.push_back(move(query));
+    }
+    // Words of the second half of the vocabulary have few documents, so their hits are merged without dense arrays
+    uniform_int_distribution<int> rare_word_index(VOCABULARY_SIZE / 2, VOCABULARY_SIZE - 1);
+    vector<string> rare_queries;
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        string query;
+        for (int j = 0; j < QUERY_LENGTH; ++j) {
+            query += vocabulary[rare_word_index(generator)];
+            query += ' ';
+        }
+        rare_queries.push_back(move(query));
+    }
+
+    const auto is_actual = [](int, DocumentStatus status, int) {
+        return status == DocumentStatus::ACTUAL;
+    };
+    Measure("FindTopDocuments(seq, query)", queries, [&](const string& query) {
+        return server.FindTopDocuments(execution::seq, query);
+    });
+    Measure("FindTopDocuments(query, predicate)", queries, [&](const string& query) {
+        return server.FindTopDocuments(query, is_actual);
+    });
+    Measure("FindTopDocumentsWith(query)", queries, [&](const string& query) {
+        return server.FindTopDocumentsWith(query);
+    });
+    Measure("FindTopDocumentsWith<TfIdfScorer, ExactRelevance, StatusIs<ACTUAL>>", queries, [&](const string& query) {
+        return server.FindTopDocumentsWith<TfIdfScorer, ExactRelevance, StatusIs<DocumentStatus::ACTUAL>>(query);
+    });
+    Measure("FindTopDocumentsWith(query, predicate)", queries, [&](const string& query) {
+        return server.FindTopDocumentsWith(query, is_actual);
+    });
+    Measure("FindTopDocumentsWith<Bm25Scorer>", queries, [&](const string& query) {
+        return server.FindTopDocumentsWith<Bm25Scorer>(query);
+    });
+
+    Measure("rare words, FindTopDocuments(seq, query)", rare_queries, [&](const string& query) {
+        return server.FindTopDocuments(execution::seq, query);
+    });
+    Measure("rare words, FindTopDocumentsWith(query)", rare_queries, [&](const string& query) {
+        return server.FindTopDocumentsWith(query);
+    });
+}
@@ -0,0 +1,129 @@
+// Total hits and facet counts: one SearchServer::Search against the separate queries a client
+// would otherwise send, one per status and one for all documents to bucket their ratings
+
+#include <chrono>
+#include <execution>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+const int DOCUMENT_COUNT = 200000;
+const int DOCUMENT_LENGTH = 20;
+const int VOCABULARY_SIZE = 20000;
+const int QUERY_COUNT = 100;
+const int RATING_BUCKET_WIDTH = 10;
+
+string GenerateWord(mt19937& generator) {
+    uniform_int_distribution<int> length(2, 10);
+    uniform_int_distribution<int> letter('a', 'z');
+    string word(length(generator), ' ');
+    for (char& c : word) {
+        c = static_cast<char>(letter(generator));
+    }
+    return word;
+}
+
+template <typename Func>
+double MeasureMicroseconds(Func func) {
+    const auto start = chrono::steady_clock::now();
+    func();
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+}
+
+// The same counts as Search, collected by separate queries returning every match
+SearchResult SearchSeparately(const SearchServer& server, const string& query, const SearchOptions& options) {
+    const size_t all = numeric_limits<size_t>::max();
+    SearchResult result;
+    result.documents = server.FindTopDocuments(execution::seq, query, options.filter);
+    result.total_hits = server.FindTopDocuments(query, PageCursor(), all, options.filter).size();
+    for (size_t status = 0; status < DOCUMENT_STATUS_COUNT; ++status) {
+        const DocumentFilter filter = options.filter.WithoutStatusRestriction().AllowStatus(static_cast<DocumentStatus>(status));
+        result.status_counts[status] = server.FindTopDocuments(query, PageCursor(), all, filter).size();
+    }
+    for (const Document& document : server.FindTopDocuments(query, PageCursor(), all, options.filter.WithoutRatingRestriction())) {
+        const int remainder = document.rating % RATING_BUCKET_WIDTH;
+        ++result.rating_counts[document.rating - (remainder < 0 ? remainder + RATING_BUCKET_WIDTH : remainder)];
+    }
+    return result;
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator(42);
+    vector<string> vocabulary;
+    vector<double> weights;
+    for (int i = 0; i < VOCABULARY_SIZE; ++i) {
+        vocabulary.push_back(GenerateWord(generator));
+        weights.push_back(1.0 / (i + 1));
+    }
+    discrete_distribution<int> word_index(weights.begin(), weights.end());
+    uniform_int_distribution<int> any_rating(-50, 50);
+    discrete_distribution<int> any_status({70, 10, 10, 10});
+
+    SearchServer server(""s);
+    for (int id = 0; id < DOCUMENT_COUNT; ++id) {
+        string document;
+        for (int j = 0; j < DOCUMENT_LENGTH; ++j) {
+            document += vocabulary[word_index(generator)] + " "s;
+        }
+        server.AddDocument(id, document, static_cast<DocumentStatus>(any_status(generator)), {any_rating(generator)});
+    }
+    vector<string> queries;
+    uniform_int_distribution<int> frequent_word(0, 50);
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        queries.push_back(vocabulary[frequent_word(generator)] + " "s + vocabulary[frequent_word(generator)]);
+    }
+
+    SearchOptions options;
+    options.filter = DocumentFilter(DocumentStatus::ACTUAL).MinRating(0);
+    options.count_statuses = true;
+    options.rating_bucket_width = RATING_BUCKET_WIDTH;
+
+    bool are_equal = true;
+    for (const string& query : queries) {
+        const SearchResult combined = server.Search(execution::seq, query, options);
+        const SearchResult separate = SearchSeparately(server, query, options);
+        are_equal = are_equal && combined.total_hits == separate.total_hits && combined.status_counts == separate.status_counts
+                    && combined.rating_counts == separate.rating_counts && combined.documents.size() == separate.documents.size();
+        for (size_t i = 0; are_equal && i < combined.documents.size(); ++i) {
+            are_equal = combined.documents[i].id == separate.documents[i].id;
+        }
+    }
+
+    SearchOptions top_only;
+    top_only.filter = options.filter;
+    const double top_time = MeasureMicroseconds([&] {
+        for (const string& query : queries) {
+            server.FindTopDocuments(execution::seq, query, options.filter);
+        }
+    });
+    const double search_time = MeasureMicroseconds([&] {
+        for (const string& query : queries) {
+            server.Search(execution::seq, query, top_only);
+        }
+    });
+    const double facets_time = MeasureMicroseconds([&] {
+        for (const string& query : queries) {
+            server.Search(execution::seq, query, options);
+        }
+    });
+    const double separate_time = MeasureMicroseconds([&] {
+        for (const string& query : queries) {
+            SearchSeparately(server, query, options);
+        }
+    });
+    cout << "FindTopDocuments: " << top_time / QUERY_COUNT << " us per query" << endl;
+    cout << "Search, total hits: " << search_time / QUERY_COUNT << " us per query" << endl;
+    cout << "Search, total hits and facets: " << facets_time / QUERY_COUNT << " us per query" << endl;
+    cout << "Separate queries: " << separate_time / QUERY_COUNT << " us per query" << endl;
+    cout << "Results equal: " << (are_equal ? "yes" : "no") << endl;
+}
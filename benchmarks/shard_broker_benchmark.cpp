@@ -0,0 +1,159 @@
+// Search over shard processes: indexing through ShardBroker one request at a time and pipelined,
+// query latency against a SearchServer in the same process
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "search_server.h"
+#include "shard_broker.h"
+#include "shard_server.h"
+
+using namespace std;
+
+namespace {
+
+const int DOCUMENT_COUNT = 20000;
+const int DOCUMENT_LENGTH = 30;
+const int VOCABULARY_SIZE = 5000;
+const int QUERY_COUNT = 500;
+
+string GenerateWord(mt19937& generator) {
+    uniform_int_distribution<int> length(2, 10);
+    uniform_int_distribution<int> letter('a', 'z');
+    string word(length(generator), ' ');
+    for (char& c : word) {
+        c = static_cast<char>(letter(generator));
+    }
+    return word;
+}
+
+template <typename Func>
+double MeasureMilliseconds(Func func) {
+    const auto start = chrono::steady_clock::now();
+    func();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+ShardServer* shard_server = nullptr;
+
+void HandleSignal(int) {
+    shard_server->Stop();
+}
+
+// The shard processes are forked before the benchmark starts any thread
+vector<pid_t> StartShards(const vector<string>& socket_paths) {
+    vector<pid_t> pids;
+    for (const string& socket_path : socket_paths) {
+        int ready[2];
+        if (pipe(ready) < 0) {
+            throw runtime_error("pipe failed"s);
+        }
+        const pid_t pid = fork();
+        if (pid == 0) {
+            {
+                SearchServer server(""s);
+                ShardServer shard(server, socket_path);
+                shard_server = &shard;
+                signal(SIGTERM, HandleSignal);
+                // The shard listens now, the broker may connect
+                close(ready[1]);
+                shard.Serve();
+            }
+            _exit(0);
+        }
+        close(ready[1]);
+        char byte;
+        [[maybe_unused]] const ssize_t size = read(ready[0], &byte, 1);
+        close(ready[0]);
+        pids.push_back(pid);
+    }
+    return pids;
+}
+
+void StopShards(const vector<pid_t>& pids) {
+    for (const pid_t pid : pids) {
+        kill(pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+    }
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator(42);
+    vector<string> vocabulary;
+    for (int i = 0; i < VOCABULARY_SIZE; ++i) {
+        vocabulary.push_back(GenerateWord(generator));
+    }
+    uniform_int_distribution<int> word_index(0, VOCABULARY_SIZE - 1);
+    vector<DocumentRecord> documents;
+    for (int id = 0; id < DOCUMENT_COUNT; ++id) {
+        string text;
+        for (int j = 0; j < DOCUMENT_LENGTH; ++j) {
+            text += vocabulary[word_index(generator)] + " "s;
+        }
+        documents.push_back({id, move(text), DocumentStatus::ACTUAL, {id % 10}});
+    }
+    vector<string> queries;
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        queries.push_back(vocabulary[word_index(generator)] + " "s + vocabulary[word_index(generator)] + " -"s
+                          + vocabulary[word_index(generator)]);
+    }
+
+    SearchServer local_server(""s);
+    for (const DocumentRecord& document : documents) {
+        local_server.AddDocument(document.id, document.text, document.status, document.ratings);
+    }
+    const double local_query_time = MeasureMilliseconds([&] {
+        for (const string& query : queries) {
+            local_server.FindTopDocuments(query);
+        }
+    });
+    cout << "in process: " << local_query_time * 1000 / QUERY_COUNT << " us/query" << endl;
+
+    cout << "shards | AddDocument, ms | AddDocuments, ms | broker query, us" << endl;
+    for (const size_t shard_count : {1, 2, 4}) {
+        vector<string> socket_paths;
+        for (size_t i = 0; i < shard_count; ++i) {
+            socket_paths.push_back("/tmp/shard-broker-benchmark-"s + to_string(getpid()) + "-"s + to_string(i));
+        }
+        for (const bool is_pipelined : {false, true}) {
+            const vector<pid_t> pids = StartShards(socket_paths);
+            ShardBroker broker(socket_paths);
+            const double indexing_time = MeasureMilliseconds([&] {
+                if (is_pipelined) {
+                    broker.AddDocuments(documents);
+                    return;
+                }
+                for (const DocumentRecord& document : documents) {
+                    broker.AddDocument(document.id, document.text, document.status, document.ratings);
+                }
+            });
+            if (!is_pipelined) {
+                cout << shard_count << " | " << indexing_time << " | " << flush;
+                StopShards(pids);
+                continue;
+            }
+            size_t mismatches = 0;
+            const double query_time = MeasureMilliseconds([&] {
+                for (const string& query : queries) {
+                    mismatches += broker.FindTopDocuments(query).size() != local_server.FindTopDocuments(query).size();
+                }
+            });
+            StopShards(pids);
+            cout << indexing_time << " | " << (query_time - local_query_time) * 1000 / QUERY_COUNT << endl;
+            if (mismatches > 0) {
+                cerr << mismatches << " queries differ" << endl;
+                return 1;
+            }
+        }
+    }
+}
@@ -0,0 +1,129 @@
+// Indexing and query throughput of ShardedSearchServer per shard count against a single SearchServer.
+// Shards are pinned one per core, so the throughput per core shows how well the work scales
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "search_server.h"
+#include "sharded_search_server.h"
+
+using namespace std;
+
+namespace {
+
+const int DOCUMENT_COUNT = 50000;
+const int DOCUMENT_LENGTH = 30;
+const int VOCABULARY_SIZE = 20000;
+const int QUERY_COUNT = 500;
+const int QUERY_LENGTH = 3;
+
+string GenerateWord(mt19937& generator) {
+    uniform_int_distribution<int> length(3, 10);
+    uniform_int_distribution<int> letter('a', 'z');
+    string word(length(generator), ' ');
+    for (char& c : word) {
+        c = static_cast<char>(letter(generator));
+    }
+    return word;
+}
+
+vector<string> GenerateTexts(mt19937& generator, const vector<string>& vocabulary, int count, int length) {
+    vector<double> weights;
+    for (size_t i = 0; i < vocabulary.size(); ++i) {
+        weights.push_back(1.0 / (i + 1));
+    }
+    discrete_distribution<int> word_index(weights.begin(), weights.end());
+    vector<string> texts;
+    for (int i = 0; i < count; ++i) {
+        string text;
+        for (int j = 0; j < length; ++j) {
+            text += vocabulary[word_index(generator)];
+            text += ' ';
+        }
+        texts.push_back(move(text));
+    }
+    return texts;
+}
+
+double SecondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Queries are sent from as many client threads as there are shards, so all shards stay busy
+template <typename Search>
+double MeasureQueries(const vector<string>& queries, size_t client_count, Search search) {
+    atomic<size_t> next_query = 0;
+    const auto start = chrono::steady_clock::now();
+    vector<future<void>> clients;
+    for (size_t i = 0; i < client_count; ++i) {
+        clients.push_back(async(launch::async, [&] {
+            for (size_t query = next_query++; query < queries.size(); query = next_query++) {
+                search(queries[query]);
+            }
+        }));
+    }
+    for (future<void>& client : clients) {
+        client.get();
+    }
+    return queries.size() / SecondsSince(start);
+}
+
+void PrintThroughput(const string& name, size_t core_count, double documents_per_second, double queries_per_second) {
+    cout << name << ": " << static_cast<int>(documents_per_second) << " documents/s ("
+         << static_cast<int>(documents_per_second / core_count) << " per core), "
+         << static_cast<int>(queries_per_second) << " queries/s ("
+         << static_cast<int>(queries_per_second / core_count) << " per core)" << endl;
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator(42);
+    vector<string> vocabulary;
+    for (int i = 0; i < VOCABULARY_SIZE; ++i) {
+        vocabulary.push_back(GenerateWord(generator));
+    }
+    const vector<string> documents = GenerateTexts(generator, vocabulary, DOCUMENT_COUNT, DOCUMENT_LENGTH);
+    const vector<string> queries = GenerateTexts(generator, vocabulary, QUERY_COUNT, QUERY_LENGTH);
+    const size_t hardware_cores = max(1u, thread::hardware_concurrency());
+    cout << hardware_cores << " hardware threads" << endl;
+
+    {
+        SearchServer server(""s);
+        const auto start = chrono::steady_clock::now();
+        for (int id = 0; id < DOCUMENT_COUNT; ++id) {
+            server.AddDocument(id, documents[id], DocumentStatus::ACTUAL, {id % 10});
+        }
+        const double documents_per_second = DOCUMENT_COUNT / SecondsSince(start);
+        const double queries_per_second = MeasureQueries(queries, 1, [&](const string& query) {
+            return server.FindTopDocuments(execution::seq, query);
+        });
+        PrintThroughput("SearchServer", 1, documents_per_second, queries_per_second);
+    }
+
+    for (size_t shard_count = 1; shard_count <= max<size_t>(hardware_cores, 2); shard_count *= 2) {
+        ShardedSearchServer server(""s, shard_count);
+        const auto start = chrono::steady_clock::now();
+        vector<future<void>> added;
+        for (int id = 0; id < DOCUMENT_COUNT; ++id) {
+            added.push_back(server.AddDocument(id, documents[id], DocumentStatus::ACTUAL, {id % 10}));
+        }
+        for (future<void>& document : added) {
+            document.get();
+        }
+        const double documents_per_second = DOCUMENT_COUNT / SecondsSince(start);
+        const double queries_per_second = MeasureQueries(queries, shard_count, [&](const string& query) {
+            return server.FindTopDocuments(query);
+        });
+        // Shards beyond the number of cores share them
+        PrintThroughput("ShardedSearchServer, " + to_string(shard_count) + " shards", min(shard_count, hardware_cores),
+                        documents_per_second, queries_per_second);
+    }
+}
@@ -0,0 +1,99 @@
+// Ingestion with different numbers of stop words: lookups of document tokens in std::set
+// and in StopWords, and AddDocument as a whole
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+#include "stop_words.h"
+
+using namespace std;
+
+namespace {
+
+const int DOCUMENT_COUNT = 20000;
+const int DOCUMENT_LENGTH = 50;
+const int VOCABULARY_SIZE = 20000;
+
+string GenerateWord(mt19937& generator) {
+    uniform_int_distribution<int> length(2, 10);
+    uniform_int_distribution<int> letter('a', 'z');
+    string word(length(generator), ' ');
+    for (char& c : word) {
+        c = static_cast<char>(letter(generator));
+    }
+    return word;
+}
+
+template <typename Func>
+double MeasureMilliseconds(Func func) {
+    const auto start = chrono::steady_clock::now();
+    func();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator(42);
+    vector<string> vocabulary;
+    for (int i = 0; i < VOCABULARY_SIZE; ++i) {
+        vocabulary.push_back(GenerateWord(generator));
+    }
+    // Frequent words are the most likely stop words, as in natural texts
+    vector<double> weights;
+    for (int i = 0; i < VOCABULARY_SIZE; ++i) {
+        weights.push_back(1.0 / (i + 1));
+    }
+    discrete_distribution<int> word_index(weights.begin(), weights.end());
+    vector<string> documents;
+    vector<string_view> tokens;
+    for (int i = 0; i < DOCUMENT_COUNT; ++i) {
+        string document;
+        for (int j = 0; j < DOCUMENT_LENGTH; ++j) {
+            document += vocabulary[word_index(generator)];
+            document += ' ';
+        }
+        documents.push_back(move(document));
+    }
+    for (const string& document : documents) {
+        for (const string_view token : SplitIntoWords(document)) {
+            tokens.push_back(token);
+        }
+    }
+
+    cout << "stop words | std::set, ms | StopWords, ms | stop tokens | AddDocument x" << DOCUMENT_COUNT << ", ms" << endl;
+    for (const int stop_word_count : {100, 1000, 10000}) {
+        const set<string, less<>> stop_word_set(vocabulary.begin(), vocabulary.begin() + stop_word_count);
+        const StopWords stop_words(stop_word_set);
+
+        size_t set_hits = 0;
+        const double set_time = MeasureMilliseconds([&] {
+            for (const string_view token : tokens) {
+                set_hits += stop_word_set.count(token);
+            }
+        });
+        size_t table_hits = 0;
+        const double table_time = MeasureMilliseconds([&] {
+            for (const string_view token : tokens) {
+                table_hits += stop_words.Contains(token);
+            }
+        });
+        if (set_hits != table_hits) {
+            cerr << "Lookup results differ" << endl;
+            return 1;
+        }
+        SearchServer server(stop_word_set);
+        const double ingestion_time = MeasureMilliseconds([&] {
+            for (int id = 0; id < DOCUMENT_COUNT; ++id) {
+                server.AddDocument(id, documents[id], DocumentStatus::ACTUAL, {1});
+            }
+        });
+        cout << stop_word_count << " | " << set_time << " | " << table_time << " | "
+             << set_hits * 100 / tokens.size() << "% | " << ingestion_time << endl;
+    }
+}
@@ -0,0 +1,127 @@
+#include "attribute_index.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+bool AttributeIndex::Entry::operator<(const Entry& other) const {
+    return key < other.key || (key == other.key && ordinal < other.ordinal);
+}
+
+AttributeIndex::AttributeIndex(AttributeType type, const allocator_type& allocator)
+    : type_(type)
+    , sorted_(allocator)
+    , recent_(allocator)
+    , live_(allocator) {
+}
+
+AttributeIndex::AttributeIndex(const AttributeIndex& other, const allocator_type& allocator)
+    : type_(other.type_)
+    , sorted_(other.sorted_, allocator)
+    , recent_(other.recent_, allocator)
+    , live_(other.live_, allocator)
+    , garbage_(other.garbage_) {
+}
+
+AttributeIndex::AttributeIndex(AttributeIndex&& other, const allocator_type& allocator)
+    : type_(other.type_)
+    , sorted_(move(other.sorted_), allocator)
+    , recent_(move(other.recent_), allocator)
+    , live_(move(other.live_), allocator)
+    , garbage_(other.garbage_) {
+}
+
+AttributeType AttributeIndex::GetType() const {
+    return type_;
+}
+
+void AttributeIndex::Add(uint32_t ordinal, int64_t key) {
+    live_.Add(ordinal);
+    recent_.push_back({key, ordinal});
+    if (recent_.size() >= max(MIN_MERGE_SIZE, sorted_.size() / 16)) {
+        Merge();
+    }
+}
+
+void AttributeIndex::Remove(uint32_t ordinal) {
+    if (!live_.Contains(ordinal)) {
+        return;
+    }
+    live_.Remove(ordinal);
+    ++garbage_;
+    if (garbage_ * 2 > sorted_.size() + recent_.size()) {
+        Merge();
+    }
+}
+
+Bitmap AttributeIndex::Select(int64_t min_key, int64_t max_key) const {
+    Bitmap result;
+    if (min_key > max_key) {
+        return result;
+    }
+    const auto first = lower_bound(sorted_.begin(), sorted_.end(), Entry{min_key, 0});
+    const auto last = upper_bound(first, sorted_.end(), Entry{max_key, numeric_limits<uint32_t>::max()});
+    vector<uint32_t> ordinals;
+    ordinals.reserve(last - first);
+    for (auto it = first; it != last; ++it) {
+        ordinals.push_back(it->ordinal);
+    }
+    for (const Entry& entry : recent_) {
+        if (min_key <= entry.key && entry.key <= max_key) {
+            ordinals.push_back(entry.ordinal);
+        }
+    }
+    if (ordinals.empty()) {
+        return result;
+    }
+
+    // Bitmap is built fastest from ascending values. A wide range goes through a plain bitset
+    // in linear time instead of a comparison sort
+    const uint32_t max_ordinal = *max_element(ordinals.begin(), ordinals.end());
+    if (ordinals.size() * 16 < max_ordinal) {
+        sort(ordinals.begin(), ordinals.end());
+        for (const uint32_t ordinal : ordinals) {
+            result.Add(ordinal);
+        }
+    } else {
+        vector<uint64_t> bits(max_ordinal / 64 + 1);
+        for (const uint32_t ordinal : ordinals) {
+            bits[ordinal / 64] |= uint64_t{1} << (ordinal % 64);
+        }
+        result = Bitmap::FromBitset(bits);
+    }
+    // Entries of removed ordinals stay until the next merge
+    if (garbage_ > 0) {
+        result &= live_;
+    }
+    return result;
+}
+
+void AttributeIndex::Renumber(const vector<uint32_t>& new_ordinals) {
+    // Entries of removed ordinals go first, their numbers are about to be taken by other documents
+    Merge();
+    for (const Entry& entry : sorted_) {
+        live_.Remove(entry.ordinal);
+    }
+    for (Entry& entry : sorted_) {
+        entry.ordinal = new_ordinals[entry.ordinal];
+        live_.Add(entry.ordinal);
+    }
+}
+
+void AttributeIndex::Merge() {
+    if (garbage_ > 0) {
+        const auto is_removed = [this](const Entry& entry) {
+            return !live_.Contains(entry.ordinal);
+        };
+        sorted_.erase(remove_if(sorted_.begin(), sorted_.end(), is_removed), sorted_.end());
+        recent_.erase(remove_if(recent_.begin(), recent_.end(), is_removed), recent_.end());
+        garbage_ = 0;
+    }
+    sort(recent_.begin(), recent_.end());
+    const size_t middle = sorted_.size();
+    sorted_.insert(sorted_.end(), recent_.begin(), recent_.end());
+    inplace_merge(sorted_.begin(), sorted_.begin() + middle, sorted_.end());
+    recent_.clear();
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "attributes.h"
+#include "bitmap.h"
+
+// Column of one numeric attribute sorted by value, answering range queries with a bitmap of ordinals.
+// Values are kept as keys of AttributeValue::ToKey. New values go to a short unsorted tail which is
+// merged into the sorted part once it outgrows a sixteenth of it, so adding costs amortized O(1) moves
+// and a range query is a binary search plus a scan of the tail
+class AttributeIndex {
+public:
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+    AttributeIndex(AttributeType type, const allocator_type& allocator);
+    AttributeIndex(const AttributeIndex& other, const allocator_type& allocator);
+    AttributeIndex(AttributeIndex&& other, const allocator_type& allocator);
+    AttributeIndex(const AttributeIndex& other) = default;
+    AttributeIndex(AttributeIndex&& other) = default;
+    AttributeIndex& operator=(const AttributeIndex& other) = default;
+    AttributeIndex& operator=(AttributeIndex&& other) = default;
+
+    AttributeType GetType() const;
+
+    // Ordinals are added at most once
+    void Add(uint32_t ordinal, int64_t key);
+
+    // Does nothing if the ordinal has no value
+    void Remove(uint32_t ordinal);
+
+    // Ordinals with min_key <= key <= max_key
+    Bitmap Select(int64_t min_key, int64_t max_key) const;
+
+    // Replaces every ordinal having a value by new_ordinals[ordinal]. The mapping must keep their order
+    void Renumber(const std::vector<uint32_t>& new_ordinals);
+
+private:
+    struct Entry {
+        int64_t key;
+        uint32_t ordinal;
+
+        bool operator<(const Entry& other) const;
+    };
+
+    static const size_t MIN_MERGE_SIZE = 256;
+
+    AttributeType type_;
+    std::pmr::vector<Entry> sorted_;
+    std::pmr::vector<Entry> recent_;
+    // Ordinals having a value; entries of the others are dropped by the next merge
+    Bitmap live_;
+    size_t garbage_ = 0;
+
+    void Merge();
+};
@@ -0,0 +1,54 @@
+#include "attributes.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+
+AttributeValue::AttributeValue(double value)
+    : type_(AttributeType::REAL)
+    , real_(value) {
+}
+
+AttributeType AttributeValue::GetType() const {
+    return type_;
+}
+
+int64_t AttributeValue::GetInteger() const {
+    if (type_ != AttributeType::INTEGER) {
+        throw invalid_argument("Attribute value is not an integer"s);
+    }
+    return integer_;
+}
+
+double AttributeValue::GetReal() const {
+    return type_ == AttributeType::REAL ? real_ : static_cast<double>(integer_);
+}
+
+int64_t AttributeValue::ToKey(AttributeType type, bool is_lower_bound) const {
+    if (type_ == AttributeType::REAL && isnan(real_)) {
+        throw invalid_argument("Attribute value is NaN"s);
+    }
+    if (type == AttributeType::INTEGER) {
+        if (type_ == AttributeType::INTEGER) {
+            return integer_;
+        }
+        const double rounded = is_lower_bound ? ceil(real_) : floor(real_);
+        // 2^63 is the first double beyond int64
+        if (rounded >= 9223372036854775808.0) {
+            return numeric_limits<int64_t>::max();
+        }
+        if (rounded < -9223372036854775808.0) {
+            return numeric_limits<int64_t>::min();
+        }
+        return static_cast<int64_t>(rounded);
+    }
+    // Bits of a non-negative double grow with its value; those of a negative one decrease, so their
+    // magnitude bits are flipped. -0.0 becomes 0.0 to compare equal to it
+    const double value = GetReal() == 0.0 ? 0.0 : GetReal();
+    int64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits >= 0 ? bits : bits ^ numeric_limits<int64_t>::max();
+}
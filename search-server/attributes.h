@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <type_traits>
+
+enum class AttributeType : uint8_t {
+    INTEGER,
+    REAL,
+};
+
+// Value of a numeric document attribute: a 64-bit integer or a double
+class AttributeValue {
+public:
+    template <typename Integer, std::enable_if_t<std::is_integral_v<Integer>, int> = 0>
+    AttributeValue(Integer value)
+        : type_(AttributeType::INTEGER)
+        , integer_(static_cast<int64_t>(value)) {
+    }
+
+    AttributeValue(double value);
+
+    AttributeType GetType() const;
+
+    int64_t GetInteger() const;
+
+    // Integers are converted
+    double GetReal() const;
+
+    // Key ordered like the values of an attribute of the given type, see AttributeIndex. An integer
+    // is converted for a REAL attribute; a double is rounded inwards for an INTEGER one, up as the lower
+    // bound of a range (is_lower_bound) and down as the upper one, saturating at the limits of int64.
+    // Throws invalid_argument for NaN
+    int64_t ToKey(AttributeType type, bool is_lower_bound) const;
+
+private:
+    AttributeType type_;
+    int64_t integer_ = 0;
+    double real_ = 0.0;
+};
+
+// Attribute declared in IndexOptions::attributes
+struct AttributeField {
+    std::string name;
+    AttributeType type = AttributeType::INTEGER;
+};
+
+// Attributes of one document by name. A document may lack any of them
+using DocumentAttributes = std::map<std::string, AttributeValue, std::less<>>;
+
+// Bounds are inclusive
+struct AttributeRange {
+    std::string name;
+    AttributeValue min;
+    AttributeValue max;
+};
@@ -0,0 +1,313 @@
+#include "bitmap.h"
+
+#include <algorithm>
+#include <iterator>
+
+using namespace std;
+
+Bitmap::Container::Container(const allocator_type& allocator)
+    : array(allocator)
+    , bits(allocator) {
+}
+
+Bitmap::Container::Container(const Container& other, const allocator_type& allocator)
+    : key(other.key)
+    , size(other.size)
+    , array(other.array, allocator)
+    , bits(other.bits, allocator) {
+}
+
+Bitmap::Container::Container(Container&& other, const allocator_type& allocator)
+    : key(other.key)
+    , size(other.size)
+    , array(move(other.array), allocator)
+    , bits(move(other.bits), allocator) {
+}
+
+bool Bitmap::Container::IsBitset() const {
+    return !bits.empty();
+}
+
+bool Bitmap::Container::Contains(uint16_t low) const {
+    if (IsBitset()) {
+        return (bits[low >> 6] >> (low & 63)) & 1;
+    }
+    return binary_search(array.begin(), array.end(), low);
+}
+
+void Bitmap::Container::Add(uint16_t low) {
+    if (IsBitset()) {
+        uint64_t& word = bits[low >> 6];
+        const uint64_t mask = uint64_t(1) << (low & 63);
+        size += (word & mask) == 0;
+        word |= mask;
+        return;
+    }
+    const auto it = lower_bound(array.begin(), array.end(), low);
+    if (it != array.end() && *it == low) {
+        return;
+    }
+    array.insert(it, low);
+    ++size;
+    if (size > MAX_ARRAY_SIZE) {
+        ToBitset();
+    }
+}
+
+void Bitmap::Container::Remove(uint16_t low) {
+    if (IsBitset()) {
+        uint64_t& word = bits[low >> 6];
+        const uint64_t mask = uint64_t(1) << (low & 63);
+        size -= (word & mask) != 0;
+        word &= ~mask;
+        if (size <= MAX_ARRAY_SIZE / 2) {
+            ToArray();
+        }
+        return;
+    }
+    const auto it = lower_bound(array.begin(), array.end(), low);
+    if (it != array.end() && *it == low) {
+        array.erase(it);
+        --size;
+    }
+}
+
+void Bitmap::Container::ToBitset() {
+    bits.assign(BITSET_WORDS, 0);
+    for (const uint16_t low : array) {
+        bits[low >> 6] |= uint64_t(1) << (low & 63);
+    }
+    array.clear();
+    array.shrink_to_fit();
+}
+
+void Bitmap::Container::ToArray() {
+    array.clear();
+    array.reserve(size);
+    for (size_t word_index = 0; word_index < BITSET_WORDS; ++word_index) {
+        for (uint64_t word = bits[word_index]; word != 0; word &= word - 1) {
+            array.push_back(static_cast<uint16_t>(word_index * 64 + CountTrailingZeros(word)));
+        }
+    }
+    bits.clear();
+    bits.shrink_to_fit();
+}
+
+void Bitmap::Container::Unite(const Container& other) {
+    if (!IsBitset() && !other.IsBitset()) {
+        pmr::vector<uint16_t> united(array.get_allocator());
+        united.reserve(array.size() + other.array.size());
+        set_union(array.begin(), array.end(), other.array.begin(), other.array.end(), back_inserter(united));
+        array = move(united);
+        size = static_cast<uint32_t>(array.size());
+        if (size > MAX_ARRAY_SIZE) {
+            ToBitset();
+        }
+        return;
+    }
+    if (!IsBitset()) {
+        ToBitset();
+    }
+    if (other.IsBitset()) {
+        size = 0;
+        for (size_t i = 0; i < BITSET_WORDS; ++i) {
+            bits[i] |= other.bits[i];
+            size += CountOnes(bits[i]);
+        }
+    } else {
+        for (const uint16_t low : other.array) {
+            Add(low);
+        }
+    }
+}
+
+void Bitmap::Container::Intersect(const Container& other) {
+    if (!IsBitset()) {
+        const auto last = remove_if(array.begin(), array.end(), [&other](uint16_t low) {
+            return !other.Contains(low);
+        });
+        array.erase(last, array.end());
+        size = static_cast<uint32_t>(array.size());
+        return;
+    }
+    if (!other.IsBitset()) {
+        pmr::vector<uint16_t> intersected(array.get_allocator());
+        for (const uint16_t low : other.array) {
+            if (Contains(low)) {
+                intersected.push_back(low);
+            }
+        }
+        array = move(intersected);
+        bits.clear();
+        bits.shrink_to_fit();
+        size = static_cast<uint32_t>(array.size());
+        return;
+    }
+    size = 0;
+    for (size_t i = 0; i < BITSET_WORDS; ++i) {
+        bits[i] &= other.bits[i];
+        size += CountOnes(bits[i]);
+    }
+    if (size <= MAX_ARRAY_SIZE) {
+        ToArray();
+    }
+}
+
+Bitmap::Bitmap(const allocator_type& allocator)
+    : containers_(allocator) {
+}
+
+Bitmap::Bitmap(const Bitmap& other, const allocator_type& allocator)
+    : containers_(other.containers_, allocator) {
+}
+
+Bitmap::Bitmap(Bitmap&& other, const allocator_type& allocator)
+    : containers_(move(other.containers_), allocator) {
+}
+
+void Bitmap::Add(uint32_t value) {
+    const uint16_t key = static_cast<uint16_t>(value >> 16);
+    auto it = LowerBound(key);
+    if (it == containers_.end() || it->key != key) {
+        it = containers_.emplace(it);
+        it->key = key;
+    }
+    it->Add(static_cast<uint16_t>(value));
+}
+
+void Bitmap::Remove(uint32_t value) {
+    const uint16_t key = static_cast<uint16_t>(value >> 16);
+    const auto it = LowerBound(key);
+    if (it == containers_.end() || it->key != key) {
+        return;
+    }
+    it->Remove(static_cast<uint16_t>(value));
+    if (it->size == 0) {
+        containers_.erase(it);
+    }
+}
+
+bool Bitmap::Contains(uint32_t value) const {
+    const uint16_t key = static_cast<uint16_t>(value >> 16);
+    const auto it = LowerBound(key);
+    return it != containers_.end() && it->key == key && it->Contains(static_cast<uint16_t>(value));
+}
+
+size_t Bitmap::Size() const {
+    size_t result = 0;
+    for (const Container& container : containers_) {
+        result += container.size;
+    }
+    return result;
+}
+
+Bitmap Bitmap::FromBitset(const vector<uint64_t>& bits) {
+    Bitmap result;
+    for (size_t first_word = 0; first_word < bits.size(); first_word += BITSET_WORDS) {
+        const size_t word_count = min(BITSET_WORDS, bits.size() - first_word);
+        uint32_t size = 0;
+        for (size_t i = 0; i < word_count; ++i) {
+            size += CountOnes(bits[first_word + i]);
+        }
+        if (size == 0) {
+            continue;
+        }
+        Container& container = result.containers_.emplace_back();
+        container.key = static_cast<uint16_t>(first_word / BITSET_WORDS);
+        container.size = size;
+        if (size > MAX_ARRAY_SIZE) {
+            container.bits.assign(BITSET_WORDS, 0);
+            copy(bits.begin() + first_word, bits.begin() + first_word + word_count, container.bits.begin());
+            continue;
+        }
+        container.array.reserve(size);
+        for (size_t i = 0; i < word_count; ++i) {
+            for (uint64_t word = bits[first_word + i]; word != 0; word &= word - 1) {
+                container.array.push_back(static_cast<uint16_t>(i * 64 + CountTrailingZeros(word)));
+            }
+        }
+    }
+    return result;
+}
+
+vector<uint64_t> Bitmap::ToBitset(size_t universe) const {
+    vector<uint64_t> result((universe + 63) / 64);
+    for (const Container& container : containers_) {
+        const size_t first_word = static_cast<size_t>(container.key) * BITSET_WORDS;
+        if (first_word >= result.size()) {
+            break;
+        }
+        if (container.IsBitset()) {
+            const size_t word_count = min(BITSET_WORDS, result.size() - first_word);
+            copy(container.bits.begin(), container.bits.begin() + word_count, result.begin() + first_word);
+        } else {
+            for (const uint16_t low : container.array) {
+                const size_t word = first_word + (low >> 6);
+                if (word < result.size()) {
+                    result[word] |= uint64_t(1) << (low & 63);
+                }
+            }
+        }
+    }
+    // Values of the last word beyond universe
+    if (universe % 64 != 0 && !result.empty()) {
+        result.back() &= (uint64_t(1) << (universe % 64)) - 1;
+    }
+    return result;
+}
+
+bool Bitmap::Empty() const {
+    return containers_.empty();
+}
+
+Bitmap& Bitmap::operator|=(const Bitmap& other) {
+    pmr::vector<Container> united(containers_.get_allocator());
+    united.reserve(containers_.size() + other.containers_.size());
+    auto lhs = containers_.begin();
+    auto rhs = other.containers_.begin();
+    while (lhs != containers_.end() || rhs != other.containers_.end()) {
+        if (rhs == other.containers_.end() || (lhs != containers_.end() && lhs->key < rhs->key)) {
+            united.push_back(move(*lhs++));
+        } else if (lhs == containers_.end() || rhs->key < lhs->key) {
+            united.push_back(*rhs++);
+        } else {
+            lhs->Unite(*rhs++);
+            united.push_back(move(*lhs++));
+        }
+    }
+    containers_ = move(united);
+    return *this;
+}
+
+Bitmap& Bitmap::operator&=(const Bitmap& other) {
+    pmr::vector<Container> intersected(containers_.get_allocator());
+    auto rhs = other.containers_.begin();
+    for (Container& container : containers_) {
+        while (rhs != other.containers_.end() && rhs->key < container.key) {
+            ++rhs;
+        }
+        if (rhs == other.containers_.end()) {
+            break;
+        }
+        if (rhs->key == container.key) {
+            container.Intersect(*rhs);
+            if (container.size > 0) {
+                intersected.push_back(move(container));
+            }
+        }
+    }
+    containers_ = move(intersected);
+    return *this;
+}
+
+pmr::vector<Bitmap::Container>::iterator Bitmap::LowerBound(uint16_t key) {
+    return lower_bound(containers_.begin(), containers_.end(), key, [](const Container& container, uint16_t k) {
+        return container.key < k;
+    });
+}
+
+pmr::vector<Bitmap::Container>::const_iterator Bitmap::LowerBound(uint16_t key) const {
+    return lower_bound(containers_.begin(), containers_.end(), key, [](const Container& container, uint16_t k) {
+        return container.key < k;
+    });
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Compressed set of 32-bit integers in the spirit of roaring bitmaps.
+// Values are grouped by their high 16 bits; every group is stored either as a sorted
+// array of low halves (sparse groups) or as a 65536-bit bitset (dense groups).
+class Bitmap {
+public:
+    // Containers of a bitmap allocate from its resource; copies made without an allocator use the default one
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+    Bitmap() = default;
+
+    explicit Bitmap(const allocator_type& allocator);
+
+    Bitmap(const Bitmap& other, const allocator_type& allocator);
+
+    Bitmap(Bitmap&& other, const allocator_type& allocator);
+
+    Bitmap(const Bitmap& other) = default;
+    Bitmap(Bitmap&& other) = default;
+    Bitmap& operator=(const Bitmap& other) = default;
+    Bitmap& operator=(Bitmap&& other) = default;
+
+    void Add(uint32_t value);
+
+    void Remove(uint32_t value);
+
+    bool Contains(uint32_t value) const;
+
+    size_t Size() const;
+
+    bool Empty() const;
+
+    Bitmap& operator|=(const Bitmap& other);
+
+    Bitmap& operator&=(const Bitmap& other);
+
+    // Set of the values whose bits are set in bits, see ToBitset
+    static Bitmap FromBitset(const std::vector<uint64_t>& bits);
+
+    // Uncompressed copy with bit value % 64 of word value / 64 set for every value below universe.
+    // Testing a bit is a single load, cheaper than Contains for a set probed many times
+    std::vector<uint64_t> ToBitset(size_t universe) const;
+
+    // Calls func(value) for every value in ascending order
+    template <typename Func>
+    void ForEach(Func func) const;
+
+private:
+    static const size_t MAX_ARRAY_SIZE = 4096;
+    static const size_t BITSET_WORDS = 65536 / 64;
+
+    struct Container {
+        using allocator_type = Bitmap::allocator_type;
+
+        uint16_t key = 0;
+        uint32_t size = 0;
+        std::pmr::vector<uint16_t> array;
+        std::pmr::vector<uint64_t> bits;
+
+        explicit Container(const allocator_type& allocator);
+        Container(const Container& other, const allocator_type& allocator);
+        Container(Container&& other, const allocator_type& allocator);
+        Container(const Container& other) = default;
+        Container(Container&& other) = default;
+        Container& operator=(const Container& other) = default;
+        Container& operator=(Container&& other) = default;
+
+        bool IsBitset() const;
+        bool Contains(uint16_t low) const;
+        void Add(uint16_t low);
+        void Remove(uint16_t low);
+        void ToBitset();
+        void ToArray();
+        void Unite(const Container& other);
+        void Intersect(const Container& other);
+    };
+
+    std::pmr::vector<Container> containers_;
+
+    static int CountTrailingZeros(uint64_t word);
+    static int CountOnes(uint64_t word);
+
+    std::pmr::vector<Container>::iterator LowerBound(uint16_t key);
+    std::pmr::vector<Container>::const_iterator LowerBound(uint16_t key) const;
+};
+
+inline int Bitmap::CountTrailingZeros(uint64_t word) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+inline int Bitmap::CountOnes(uint64_t word) {
+#ifdef _MSC_VER
+    return static_cast<int>(__popcnt64(word));
+#else
+    return __builtin_popcountll(word);
+#endif
+}
+
+template <typename Func>
+void Bitmap::ForEach(Func func) const {
+    for (const Container& container : containers_) {
+        const uint32_t high = static_cast<uint32_t>(container.key) << 16;
+        if (container.IsBitset()) {
+            for (size_t word_index = 0; word_index < BITSET_WORDS; ++word_index) {
+                for (uint64_t word = container.bits[word_index]; word != 0; word &= word - 1) {
+                    func(high | static_cast<uint32_t>(word_index * 64 + CountTrailingZeros(word)));
+                }
+            }
+        } else {
+            for (const uint16_t low : container.array) {
+                func(high | low);
+            }
+        }
+    }
+}
@@ -1,5 +1,7 @@
 #include "document.h"
 
+#include <cmath>
+
 using namespace std;
 
 Document::Document(int id, double relevance, int rating)
@@ -15,4 +17,20 @@ ostream& operator <<(ostream& out, const Document document) {
         << "rating = "s << document.rating
         << " }"s;
     return out;
+}
+
+long long QuantizeRelevance(double relevance) {
+    return llround(relevance / EPS);
+}
+
+bool RanksBefore(const Document& lhs, const Document& rhs) {
+    const long long lhs_relevance = QuantizeRelevance(lhs.relevance);
+    const long long rhs_relevance = QuantizeRelevance(rhs.relevance);
+    if (lhs_relevance != rhs_relevance) {
+        return lhs_relevance > rhs_relevance;
+    }
+    if (lhs.rating != rhs.rating) {
+        return lhs.rating > rhs.rating;
+    }
+    return lhs.id < rhs.id;
 }
\ No newline at end of file
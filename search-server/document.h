@@ -2,6 +2,8 @@
 
 #include <iostream>
 
+const float EPS = 1e-6;
+
 struct Document {
     Document() = default;
 
@@ -19,4 +21,15 @@ enum class DocumentStatus {
     REMOVED,
 };
 
-std::ostream& operator <<(std::ostream& out, const Document document);
\ No newline at end of file
+const size_t DOCUMENT_STATUS_COUNT = 4;
+
+std::ostream& operator <<(std::ostream& out, const Document document);
+
+// Relevance rounded to a multiple of EPS. Results whose relevances round to the same value
+// are ranked as equally relevant
+long long QuantizeRelevance(double relevance);
+
+// Order of search results: by quantized relevance, then by rating, from the highest,
+// then by id from the lowest. Unlike a comparison of relevances within EPS, this is a strict
+// weak ordering, so sorting, merging and cursors agree on it
+bool RanksBefore(const Document& lhs, const Document& rhs);
\ No newline at end of file
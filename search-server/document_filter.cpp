@@ -0,0 +1,76 @@
+#include "document_filter.h"
+
+using namespace std;
+
+DocumentFilter::DocumentFilter(DocumentStatus status) {
+    AllowStatus(status);
+}
+
+DocumentFilter& DocumentFilter::AllowStatus(DocumentStatus status) {
+    status_mask_ |= 1u << static_cast<uint32_t>(status);
+    return *this;
+}
+
+DocumentFilter& DocumentFilter::MinRating(int rating) {
+    min_rating_ = rating;
+    return *this;
+}
+
+DocumentFilter& DocumentFilter::MaxRating(int rating) {
+    max_rating_ = rating;
+    return *this;
+}
+
+DocumentFilter& DocumentFilter::AttributeBetween(string_view name, AttributeValue min, AttributeValue max) {
+    attribute_ranges_.push_back({string(name), min, max});
+    return *this;
+}
+
+DocumentFilter& DocumentFilter::AttributeAtLeast(string_view name, AttributeValue min) {
+    return AttributeBetween(name, min, numeric_limits<double>::infinity());
+}
+
+DocumentFilter& DocumentFilter::AttributeAtMost(string_view name, AttributeValue max) {
+    return AttributeBetween(name, -numeric_limits<double>::infinity(), max);
+}
+
+bool DocumentFilter::HasStatusRestriction() const {
+    return status_mask_ != 0;
+}
+
+bool DocumentFilter::IsStatusAllowed(DocumentStatus status) const {
+    return !HasStatusRestriction() || (status_mask_ >> static_cast<uint32_t>(status)) & 1;
+}
+
+bool DocumentFilter::HasRatingRestriction() const {
+    return min_rating_ != numeric_limits<int>::min() || max_rating_ != numeric_limits<int>::max();
+}
+
+int DocumentFilter::GetMinRating() const {
+    return min_rating_;
+}
+
+int DocumentFilter::GetMaxRating() const {
+    return max_rating_;
+}
+
+const vector<AttributeRange>& DocumentFilter::GetAttributeRanges() const {
+    return attribute_ranges_;
+}
+
+DocumentFilter DocumentFilter::WithoutStatusRestriction() const {
+    DocumentFilter result = *this;
+    result.status_mask_ = 0;
+    return result;
+}
+
+DocumentFilter DocumentFilter::WithoutRatingRestriction() const {
+    DocumentFilter result = *this;
+    result.min_rating_ = numeric_limits<int>::min();
+    result.max_rating_ = numeric_limits<int>::max();
+    return result;
+}
+
+bool DocumentFilter::operator()([[maybe_unused]] int document_id, DocumentStatus status, int rating) const {
+    return IsStatusAllowed(status) && min_rating_ <= rating && rating <= max_rating_;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+#include "attributes.h"
+#include "document.h"
+
+// Filter on document status, rating and numeric attributes which SearchServer evaluates with its
+// indexes before scoring. Arbitrary predicates remain available as a slower fallback.
+// Default constructed filter accepts every document.
+class DocumentFilter {
+public:
+    DocumentFilter() = default;
+
+    explicit DocumentFilter(DocumentStatus status);
+
+    // Each call adds one more accepted status
+    DocumentFilter& AllowStatus(DocumentStatus status);
+
+    DocumentFilter& MinRating(int rating);
+
+    DocumentFilter& MaxRating(int rating);
+
+    // Accepts documents having the attribute within [min, max]. Ranges of one attribute add up to
+    // their intersection. The attribute must be declared in IndexOptions::attributes of the server
+    DocumentFilter& AttributeBetween(std::string_view name, AttributeValue min, AttributeValue max);
+
+    DocumentFilter& AttributeAtLeast(std::string_view name, AttributeValue min);
+
+    DocumentFilter& AttributeAtMost(std::string_view name, AttributeValue max);
+
+    bool HasStatusRestriction() const;
+
+    bool IsStatusAllowed(DocumentStatus status) const;
+
+    bool HasRatingRestriction() const;
+
+    int GetMinRating() const;
+
+    int GetMaxRating() const;
+
+    const std::vector<AttributeRange>& GetAttributeRanges() const;
+
+    // Copies accepting any status or any rating, for facets over that dimension
+    DocumentFilter WithoutStatusRestriction() const;
+
+    DocumentFilter WithoutRatingRestriction() const;
+
+    // Checks status and rating only, attribute ranges need the indexes of a server
+    bool operator()(int document_id, DocumentStatus status, int rating) const;
+
+private:
+    uint32_t status_mask_ = 0;
+    int min_rating_ = std::numeric_limits<int>::min();
+    int max_rating_ = std::numeric_limits<int>::max();
+    std::vector<AttributeRange> attribute_ranges_;
+};
@@ -0,0 +1,131 @@
+#include "fuzzy.h"
+
+#include <algorithm>
+
+using namespace std;
+
+LevenshteinAutomaton::LevenshteinAutomaton(string_view word, int max_distance)
+    : word_(word)
+    , max_distance_(static_cast<uint8_t>(max_distance)) {
+}
+
+LevenshteinAutomaton::State LevenshteinAutomaton::Start() const {
+    State state(word_.size() + 1);
+    for (size_t i = 0; i < state.size(); ++i) {
+        state[i] = static_cast<uint8_t>(min<size_t>(i, max_distance_ + 1));
+    }
+    return state;
+}
+
+LevenshteinAutomaton::State LevenshteinAutomaton::Step(const State& state, char c) const {
+    State next(state.size());
+    next[0] = min<uint8_t>(state[0] + 1, max_distance_ + 1);
+    for (size_t i = 1; i < state.size(); ++i) {
+        const uint8_t substitution = state[i - 1] + (word_[i - 1] == c ? 0 : 1);
+        const uint8_t edit = min(substitution, static_cast<uint8_t>(min(state[i], next[i - 1]) + 1));
+        next[i] = min<uint8_t>(edit, max_distance_ + 1);
+    }
+    return next;
+}
+
+bool LevenshteinAutomaton::IsMatch(const State& state) const {
+    return state.back() <= max_distance_;
+}
+
+bool LevenshteinAutomaton::CanMatch(const State& state) const {
+    return *min_element(state.begin(), state.end()) <= max_distance_;
+}
+
+int LevenshteinAutomaton::Distance(string_view text) const {
+    if (max(text.size(), word_.size()) - min(text.size(), word_.size()) > max_distance_) {
+        return max_distance_ + 1;
+    }
+    State state = Start();
+    for (const char c : text) {
+        state = Step(state, c);
+        if (!CanMatch(state)) {
+            return max_distance_ + 1;
+        }
+    }
+    return state.back();
+}
+
+TrigramIndex::TrigramIndex(pmr::memory_resource* resource)
+    : term_ids_(resource) {
+}
+
+void TrigramIndex::Add(uint32_t term_id, string_view word) {
+    for (const uint32_t trigram : GetTrigrams(word)) {
+        pmr::vector<uint32_t>& term_ids = term_ids_[trigram];
+        // New words usually get the largest id, reused ids land inside the list
+        term_ids.insert(lower_bound(term_ids.begin(), term_ids.end(), term_id), term_id);
+    }
+}
+
+void TrigramIndex::Remove(uint32_t term_id, string_view word) {
+    for (const uint32_t trigram : GetTrigrams(word)) {
+        const auto list = term_ids_.find(trigram);
+        if (list == term_ids_.end()) {
+            continue;
+        }
+        pmr::vector<uint32_t>& term_ids = list->second;
+        const auto it = lower_bound(term_ids.begin(), term_ids.end(), term_id);
+        if (it != term_ids.end() && *it == term_id) {
+            term_ids.erase(it);
+        }
+        if (term_ids.empty()) {
+            term_ids_.erase(list);
+        }
+    }
+}
+
+vector<uint32_t> TrigramIndex::FindCandidates(string_view word, int max_distance) const {
+    static const pmr::vector<uint32_t> empty_list;
+    vector<const pmr::vector<uint32_t>*> lists;
+    for (const uint32_t trigram : GetTrigrams(word)) {
+        const auto it = term_ids_.find(trigram);
+        lists.push_back(it == term_ids_.end() ? &empty_list : &it->second);
+    }
+    sort(lists.begin(), lists.end(), [](const pmr::vector<uint32_t>* lhs, const pmr::vector<uint32_t>* rhs) {
+        return lhs->size() < rhs->size();
+    });
+    const size_t required = lists.size() > 3 * static_cast<size_t>(max_distance)
+                          ? lists.size() - 3 * static_cast<size_t>(max_distance) : 1;
+
+    // A word sharing required trigrams occurs in at least one of the lists.size() - required + 1 shortest lists,
+    // so only those are scanned and the long lists of common trigrams are probed for the candidates found
+    const size_t scanned = lists.size() - required + 1;
+    unordered_map<uint32_t, size_t> shared_counts;
+    for (size_t i = 0; i < scanned; ++i) {
+        for (const uint32_t term_id : *lists[i]) {
+            ++shared_counts[term_id];
+        }
+    }
+    vector<uint32_t> candidates;
+    for (const auto& [term_id, count] : shared_counts) {
+        size_t shared = count;
+        for (size_t i = scanned; i < lists.size() && shared < required; ++i) {
+            shared += binary_search(lists[i]->begin(), lists[i]->end(), term_id) ? 1 : 0;
+        }
+        if (shared >= required) {
+            candidates.push_back(term_id);
+        }
+    }
+    sort(candidates.begin(), candidates.end());
+    return candidates;
+}
+
+vector<uint32_t> TrigramIndex::GetTrigrams(string_view word) {
+    const size_t padding = 2;
+    const auto char_at = [&](size_t i) -> uint32_t {
+        // Zero never occurs in words, so it marks the word boundaries
+        return i < padding || i >= word.size() + padding ? 0 : static_cast<unsigned char>(word[i - padding]);
+    };
+    vector<uint32_t> trigrams;
+    for (size_t i = 0; i < word.size() + padding; ++i) {
+        trigrams.push_back(char_at(i) << 16 | char_at(i + 1) << 8 | char_at(i + 2));
+    }
+    sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory_resource>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Accepts words within max_distance insertions, deletions and substitutions from the given word.
+// A state is the row of the Levenshtein distance table for the characters read so far,
+// with values clamped to max_distance + 1
+class LevenshteinAutomaton {
+public:
+    using State = std::vector<uint8_t>;
+
+    LevenshteinAutomaton(std::string_view word, int max_distance);
+
+    State Start() const;
+
+    State Step(const State& state, char c) const;
+
+    bool IsMatch(const State& state) const;
+
+    // False if no continuation of the characters read so far is accepted
+    bool CanMatch(const State& state) const;
+
+    // Distance from the automaton word to text, or max_distance + 1 if text is not accepted
+    int Distance(std::string_view text) const;
+
+private:
+    std::string_view word_;
+    uint8_t max_distance_;
+};
+
+// Inverted index from letter trigrams to ids of dictionary words.
+// Words are padded with two boundary characters on each side, so a word of length n has n + 2 trigrams
+// and every edit destroys at most 3 of them
+class TrigramIndex {
+public:
+    explicit TrigramIndex(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    void Add(uint32_t term_id, std::string_view word);
+
+    void Remove(uint32_t term_id, std::string_view word);
+
+    // Ids of words sharing enough trigrams with word to be within max_distance edits from it.
+    // Candidates are not verified; words of up to 3 * max_distance - 2 characters also need
+    // a common trigram, so some very short matches are not found
+    std::vector<uint32_t> FindCandidates(std::string_view word, int max_distance) const;
+
+private:
+    // Sorted ids of words containing the trigram
+    std::pmr::unordered_map<uint32_t, std::pmr::vector<uint32_t>> term_ids_;
+
+    // Distinct trigrams of the padded word
+    static std::vector<uint32_t> GetTrigrams(std::string_view word);
+};
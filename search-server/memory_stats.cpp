@@ -0,0 +1,61 @@
+#include "memory_stats.h"
+
+using namespace std;
+
+MemoryUsage& MemoryUsage::operator+=(const MemoryUsage& other) {
+    bytes += other.bytes;
+    allocations += other.allocations;
+    total_allocations += other.total_allocations;
+    return *this;
+}
+
+MemoryUsage MemoryStats::GetTotal() const {
+    MemoryUsage total;
+    for (const MemoryUsage* usage : {&dictionary, &postings, &positions, &fuzzy_index, &forward_index, &metadata, &filters}) {
+        total += *usage;
+    }
+    return total;
+}
+
+ostream& operator<<(ostream& out, const MemoryStats& stats) {
+    const auto print = [&out](const char* name, const MemoryUsage& usage) {
+        out << name << ": "s << usage.bytes << " bytes in "s << usage.allocations << " blocks, "s
+            << usage.total_allocations << " allocations\n"s;
+    };
+    print("dictionary", stats.dictionary);
+    print("postings", stats.postings);
+    print("positions", stats.positions);
+    print("fuzzy index", stats.fuzzy_index);
+    print("forward index", stats.forward_index);
+    print("metadata", stats.metadata);
+    print("filters", stats.filters);
+    print("total", stats.GetTotal());
+    return out;
+}
+
+CountingMemoryResource::CountingMemoryResource(pmr::memory_resource* upstream)
+    : upstream_(upstream) {
+}
+
+MemoryUsage CountingMemoryResource::GetUsage() const {
+    return {bytes_.load(memory_order_relaxed), allocations_.load(memory_order_relaxed),
+            total_allocations_.load(memory_order_relaxed)};
+}
+
+void* CountingMemoryResource::do_allocate(size_t bytes, size_t alignment) {
+    void* pointer = upstream_->allocate(bytes, alignment);
+    bytes_.fetch_add(bytes, memory_order_relaxed);
+    allocations_.fetch_add(1, memory_order_relaxed);
+    total_allocations_.fetch_add(1, memory_order_relaxed);
+    return pointer;
+}
+
+void CountingMemoryResource::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+    upstream_->deallocate(pointer, bytes, alignment);
+    bytes_.fetch_sub(bytes, memory_order_relaxed);
+    allocations_.fetch_sub(1, memory_order_relaxed);
+}
+
+bool CountingMemoryResource::do_is_equal(const pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <memory_resource>
+
+// Memory held by one structure: bytes requested from the allocator and the number of blocks,
+// both live at the moment, and the number of allocations made over the lifetime
+struct MemoryUsage {
+    size_t bytes = 0;
+    size_t allocations = 0;
+    size_t total_allocations = 0;
+
+    MemoryUsage& operator+=(const MemoryUsage& other);
+};
+
+// Memory of the index structures of a SearchServer. Sizes are what the containers request,
+// so node overhead of trees is included, and slack of the upstream resource is not
+struct MemoryStats {
+    // Word -> term id tree, term id -> word table and free term ids
+    MemoryUsage dictionary;
+    MemoryUsage postings;
+    MemoryUsage positions;
+    // Trigram index of fuzzy matching
+    MemoryUsage fuzzy_index;
+    // Words of every document and the locations of the document records
+    MemoryUsage forward_index;
+    // Document ids, ratings, statuses, lengths and id -> ordinal tree
+    MemoryUsage metadata;
+    // Bitmaps of documents by status and rating, and attribute indexes, used by DocumentFilter
+    MemoryUsage filters;
+
+    MemoryUsage GetTotal() const;
+};
+
+std::ostream& operator<<(std::ostream& out, const MemoryStats& stats);
+
+// Forwards to upstream and counts what is allocated through it. Thread-safe if upstream is
+class CountingMemoryResource : public std::pmr::memory_resource {
+public:
+    explicit CountingMemoryResource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+    MemoryUsage GetUsage() const;
+
+private:
+    std::pmr::memory_resource* upstream_;
+    std::atomic<size_t> bytes_ = 0;
+    std::atomic<size_t> allocations_ = 0;
+    std::atomic<size_t> total_allocations_ = 0;
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
@@ -0,0 +1,45 @@
+#include "page_cursor.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+using namespace std;
+
+PageCursor::PageCursor(const Document& last_document)
+    : is_first_page_(false)
+    , last_document_(last_document) {
+}
+
+bool PageCursor::IsFirstPage() const {
+    return is_first_page_;
+}
+
+bool PageCursor::Precedes(const Document& document) const {
+    return is_first_page_ || RanksBefore(last_document_, document);
+}
+
+string PageCursor::ToString() const {
+    if (is_first_page_) {
+        return {};
+    }
+    // Hexadecimal floating point keeps the relevance exact
+    char buffer[64];
+    const int size = snprintf(buffer, sizeof(buffer), "%a:%d:%d",
+                              last_document_.relevance, last_document_.rating, last_document_.id);
+    return string(buffer, size);
+}
+
+PageCursor PageCursor::FromString(string_view text) {
+    if (text.empty()) {
+        return PageCursor();
+    }
+    const string buffer(text);
+    Document last_document;
+    int consumed = 0;
+    if (sscanf(buffer.c_str(), "%la:%d:%d%n", &last_document.relevance, &last_document.rating,
+               &last_document.id, &consumed) != 3 || consumed != static_cast<int>(buffer.size())) {
+        throw invalid_argument("Invalid page cursor '"s + buffer + "'"s);
+    }
+    return PageCursor(last_document);
+}
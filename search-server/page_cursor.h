@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "document.h"
+
+// Position in the ranked results of a query, see RanksBefore.
+// A page requested with a cursor starts right after the document the cursor was made from,
+// so pages stay consistent without keeping any state in the server
+class PageCursor {
+public:
+    // Cursor of the first page
+    PageCursor() = default;
+
+    // Cursor of the page following the one ending with last_document
+    explicit PageCursor(const Document& last_document);
+
+    bool IsFirstPage() const;
+
+    // True if document goes after the cursor position
+    bool Precedes(const Document& document) const;
+
+    // Opaque text form to hand to clients, empty for the first page
+    std::string ToString() const;
+
+    // Throws invalid_argument if text was not produced by ToString
+    static PageCursor FromString(std::string_view text);
+
+private:
+    bool is_first_page_ = true;
+    Document last_document_;
+};
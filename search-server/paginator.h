@@ -1,6 +1,10 @@
 #pragma once
 
+#include <functional>
+#include <iterator>
+#include <memory>
 #include <ostream>
+#include <vector>
 
 template<typename It>
 class IteratorRange {
@@ -90,4 +94,90 @@ auto Paginator<It>::end() const {
 template <typename It>
 int Paginator<It>::size() const {
     return static_cast<int>(pages_.size());
-}
\ No newline at end of file
+}
+
+// Paginator over pages produced on demand: fetch_next_page gets the previous page (empty for the
+// first one) and returns the next one, an empty page ends the iteration
+template <typename T>
+class LazyPaginator {
+public:
+    using PageFetcher = std::function<std::vector<T>(const std::vector<T>& previous_page)>;
+
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = IteratorRange<typename std::vector<T>::const_iterator>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator() = default;
+
+        explicit Iterator(std::shared_ptr<const PageFetcher> fetch_next_page);
+
+        reference operator*() const;
+
+        Iterator& operator++();
+
+        // Iterators differ only by being past the last page or not
+        bool operator==(const Iterator& other) const;
+
+        bool operator!=(const Iterator& other) const;
+
+    private:
+        std::shared_ptr<const PageFetcher> fetch_next_page_;
+        std::vector<T> page_;
+    };
+
+    explicit LazyPaginator(PageFetcher fetch_next_page);
+
+    // Fetches the first page
+    Iterator begin() const;
+
+    Iterator end() const;
+
+private:
+    std::shared_ptr<const PageFetcher> fetch_next_page_;
+};
+
+template <typename T>
+LazyPaginator<T>::Iterator::Iterator(std::shared_ptr<const PageFetcher> fetch_next_page)
+    : fetch_next_page_(std::move(fetch_next_page))
+    , page_((*fetch_next_page_)({})) {
+}
+
+template <typename T>
+typename LazyPaginator<T>::Iterator::reference LazyPaginator<T>::Iterator::operator*() const {
+    return {page_.begin(), page_.end()};
+}
+
+template <typename T>
+typename LazyPaginator<T>::Iterator& LazyPaginator<T>::Iterator::operator++() {
+    page_ = (*fetch_next_page_)(page_);
+    return *this;
+}
+
+template <typename T>
+bool LazyPaginator<T>::Iterator::operator==(const Iterator& other) const {
+    return page_.empty() == other.page_.empty();
+}
+
+template <typename T>
+bool LazyPaginator<T>::Iterator::operator!=(const Iterator& other) const {
+    return !(*this == other);
+}
+
+template <typename T>
+LazyPaginator<T>::LazyPaginator(PageFetcher fetch_next_page)
+    : fetch_next_page_(std::make_shared<const PageFetcher>(std::move(fetch_next_page))) {
+}
+
+template <typename T>
+typename LazyPaginator<T>::Iterator LazyPaginator<T>::begin() const {
+    return Iterator(fetch_next_page_);
+}
+
+template <typename T>
+typename LazyPaginator<T>::Iterator LazyPaginator<T>::end() const {
+    return Iterator();
+}
@@ -0,0 +1,114 @@
+#include "positions.h"
+
+#include <limits>
+#include <utility>
+
+using namespace std;
+
+namespace {
+
+void EncodeVarint(uint32_t value, pmr::vector<uint8_t>& output) {
+    while (value >= 0x80) {
+        output.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    output.push_back(static_cast<uint8_t>(value));
+}
+
+const uint8_t* DecodeVarint(const uint8_t* data, uint32_t& value) {
+    value = 0;
+    for (int shift = 0;; shift += 7) {
+        const uint8_t byte = *data++;
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return data;
+        }
+    }
+}
+
+}  // namespace
+
+void EncodePositions(const vector<uint32_t>& positions, pmr::vector<uint8_t>& output) {
+    EncodeVarint(static_cast<uint32_t>(positions.size()), output);
+    uint32_t previous = 0;
+    for (const uint32_t position : positions) {
+        EncodeVarint(position - previous, output);
+        previous = position;
+    }
+}
+
+const uint8_t* DecodePositions(const uint8_t* data, vector<uint32_t>& positions) {
+    uint32_t count;
+    data = DecodeVarint(data, count);
+    positions.resize(count);
+    uint32_t position = 0;
+    for (uint32_t& result : positions) {
+        uint32_t gap;
+        data = DecodeVarint(data, gap);
+        position += gap;
+        result = position;
+    }
+    return data;
+}
+
+const uint8_t* SkipPositions(const uint8_t* data) {
+    uint32_t count;
+    data = DecodeVarint(data, count);
+    for (uint32_t i = 0; i < count; ++i) {
+        while (*data++ & 0x80) {
+        }
+    }
+    return data;
+}
+
+bool HasPhraseOccurrence(const vector<vector<uint32_t>>& positions, const vector<uint32_t>& offsets) {
+    // Candidates are taken from the shortest list, the other lists are only probed
+    size_t pivot = 0;
+    for (size_t i = 1; i < positions.size(); ++i) {
+        if (positions[i].size() < positions[pivot].size()) {
+            pivot = i;
+        }
+    }
+    vector<vector<uint32_t>::const_iterator> cursors;
+    for (const auto& term_positions : positions) {
+        cursors.push_back(term_positions.begin());
+    }
+    for (const uint32_t pivot_position : positions[pivot]) {
+        if (pivot_position < offsets[pivot]) {
+            continue;
+        }
+        const uint32_t start = pivot_position - offsets[pivot];
+        bool matched = true;
+        for (size_t i = 0; i < positions.size() && matched; ++i) {
+            if (i == pivot) {
+                continue;
+            }
+            cursors[i] = GallopLowerBound(cursors[i], positions[i].end(), start + offsets[i]);
+            if (cursors[i] == positions[i].end()) {
+                return false;
+            }
+            matched = *cursors[i] == start + offsets[i];
+        }
+        if (matched) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t ComputeMinTermDistance(const vector<vector<uint32_t>>& positions) {
+    vector<pair<uint32_t, size_t>> merged;
+    for (size_t term = 0; term < positions.size(); ++term) {
+        for (const uint32_t position : positions[term]) {
+            merged.push_back({position, term});
+        }
+    }
+    sort(merged.begin(), merged.end());
+    uint32_t result = numeric_limits<uint32_t>::max();
+    for (size_t i = 1; i < merged.size(); ++i) {
+        if (merged[i].second != merged[i - 1].second) {
+            result = min(result, merged[i].first - merged[i - 1].first);
+        }
+    }
+    return result == numeric_limits<uint32_t>::max() ? 0 : result;
+}
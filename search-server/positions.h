@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+// Position list of a term in a document is stored as a varint encoded count
+// followed by varint encoded gaps between consecutive positions
+
+void EncodePositions(const std::vector<uint32_t>& positions, std::pmr::vector<uint8_t>& output);
+
+// Replaces contents of positions with the list starting at data, returns pointer past the list
+const uint8_t* DecodePositions(const uint8_t* data, std::vector<uint32_t>& positions);
+
+// Returns pointer past the list starting at data
+const uint8_t* SkipPositions(const uint8_t* data);
+
+// Finds the first element in the sorted range [first, last) which is not less than value.
+// Probes positions first + 1, first + 2, first + 4, ... before the binary search, so a scan
+// advancing the lower bound step by step costs O(log distance) per step
+template <typename It, typename T, typename Less>
+It GallopLowerBound(It first, It last, const T& value, Less less) {
+    if (first == last || !less(*first, value)) {
+        return first;
+    }
+    It low = first;
+    for (size_t step = 1;; step *= 2) {
+        if (static_cast<size_t>(last - low) <= step) {
+            return std::lower_bound(low + 1, last, value, less);
+        }
+        const It high = low + step;
+        if (!less(*high, value)) {
+            return std::lower_bound(low + 1, high, value, less);
+        }
+        low = high;
+    }
+}
+
+template <typename It, typename T>
+It GallopLowerBound(It first, It last, const T& value) {
+    return GallopLowerBound(first, last, value, [](const auto& lhs, const auto& rhs) {
+        return lhs < rhs;
+    });
+}
+
+// Checks whether there is a position p such that p + offsets[i] is in positions[i] for every i
+bool HasPhraseOccurrence(const std::vector<std::vector<uint32_t>>& positions, const std::vector<uint32_t>& offsets);
+
+// Minimal distance between positions of two different terms, 0 if less than two terms occur
+uint32_t ComputeMinTermDistance(const std::vector<std::vector<uint32_t>>& positions);
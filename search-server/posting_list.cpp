@@ -0,0 +1,200 @@
+#include "posting_list.h"
+
+#include <cstring>
+#include <utility>
+
+using namespace std;
+
+PostingList::PostingList(const allocator_type& allocator)
+    : allocator_(allocator) {
+}
+
+PostingList::PostingList(const PostingList& other, const allocator_type& allocator)
+    : allocator_(allocator) {
+    if (other.size_ > 0) {
+        Reallocate(other.size_);
+        memcpy(data_, other.data_, other.size_ * sizeof(uint32_t));
+        memcpy(MutableCounts(), other.Counts(), other.size_ * sizeof(uint32_t));
+        size_ = other.size_;
+        UpdateSkips(0);
+    }
+}
+
+PostingList::PostingList(PostingList&& other, const allocator_type& allocator)
+    : allocator_(allocator) {
+    if (allocator_ == other.allocator_) {
+        swap(data_, other.data_);
+        swap(size_, other.size_);
+        swap(capacity_, other.capacity_);
+    } else {
+        *this = other;
+    }
+}
+
+PostingList::PostingList(const PostingList& other)
+    : PostingList(other, allocator_type()) {
+}
+
+PostingList::PostingList(PostingList&& other) noexcept
+    : allocator_(other.allocator_)
+    , data_(exchange(other.data_, nullptr))
+    , size_(exchange(other.size_, 0))
+    , capacity_(exchange(other.capacity_, 0)) {
+}
+
+PostingList& PostingList::operator=(const PostingList& other) {
+    if (this != &other) {
+        PostingList copy(other, allocator_);
+        swap(data_, copy.data_);
+        swap(size_, copy.size_);
+        swap(capacity_, copy.capacity_);
+    }
+    return *this;
+}
+
+PostingList& PostingList::operator=(PostingList&& other) {
+    if (allocator_ != other.allocator_) {
+        return *this = other;
+    }
+    swap(data_, other.data_);
+    swap(size_, other.size_);
+    swap(capacity_, other.capacity_);
+    return *this;
+}
+
+PostingList::~PostingList() {
+    Deallocate();
+}
+
+size_t PostingList::Size() const {
+    return size_;
+}
+
+bool PostingList::Empty() const {
+    return size_ == 0;
+}
+
+size_t PostingList::Capacity() const {
+    return capacity_;
+}
+
+size_t PostingList::GetAllocatedBytes() const {
+    return GetAllocationSize(capacity_);
+}
+
+const uint32_t* PostingList::Ordinals() const {
+    return data_;
+}
+
+const uint32_t* PostingList::Counts() const {
+    return data_ + capacity_;
+}
+
+void PostingList::Append(uint32_t ordinal, uint32_t count) {
+    if (size_ == capacity_) {
+        Reallocate(max<uint32_t>(capacity_ * 2, 1));
+    }
+    data_[size_] = ordinal;
+    MutableCounts()[size_] = count;
+    ++size_;
+    if (size_ % BLOCK_SIZE == 0) {
+        Skips()[size_ / BLOCK_SIZE - 1] = ordinal;
+    }
+}
+
+size_t PostingList::LowerBound(uint32_t ordinal) const {
+    const uint32_t* skips = Skips();
+    const size_t block = lower_bound(skips, skips + size_ / BLOCK_SIZE, ordinal) - skips;
+    const uint32_t* first = data_ + block * BLOCK_SIZE;
+    const uint32_t* last = data_ + min<size_t>(size_, (block + 1) * BLOCK_SIZE);
+    return lower_bound(first, last, ordinal) - data_;
+}
+
+size_t PostingList::Find(uint32_t ordinal) const {
+    const size_t index = LowerBound(ordinal);
+    return index < size_ && data_[index] == ordinal ? index : size_;
+}
+
+bool PostingList::Contains(uint32_t ordinal) const {
+    return Find(ordinal) != size_;
+}
+
+void PostingList::Erase(size_t index) {
+    uint32_t* counts = MutableCounts();
+    memmove(data_ + index, data_ + index + 1, (size_ - index - 1) * sizeof(uint32_t));
+    memmove(counts + index, counts + index + 1, (size_ - index - 1) * sizeof(uint32_t));
+    --size_;
+    UpdateSkips(index);
+}
+
+void PostingList::Renumber(const std::vector<uint32_t>& new_ordinals) {
+    for (size_t i = 0; i < size_; ++i) {
+        data_[i] = new_ordinals[data_[i]];
+    }
+    UpdateSkips(0);
+}
+
+void PostingList::Clear() {
+    size_ = 0;
+}
+
+void PostingList::ShrinkToFit() {
+    const uint32_t capacity = size_ <= BLOCK_SIZE ? size_ : (size_ + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+    if (capacity < capacity_) {
+        Reallocate(capacity);
+    }
+}
+
+size_t PostingList::GetAllocationSize(size_t capacity) {
+    return (2 * capacity + capacity / BLOCK_SIZE) * sizeof(uint32_t);
+}
+
+size_t PostingList::GetAlignment(size_t capacity) {
+    // Over-aligned allocations leave gaps in the heap, which short lists are not worth
+    return capacity < BLOCK_SIZE ? alignof(uint32_t) : CACHE_LINE_SIZE;
+}
+
+uint32_t* PostingList::MutableCounts() {
+    return data_ + capacity_;
+}
+
+uint32_t* PostingList::Skips() {
+    return data_ + 2 * capacity_;
+}
+
+const uint32_t* PostingList::Skips() const {
+    return data_ + 2 * capacity_;
+}
+
+void PostingList::Reallocate(uint32_t capacity) {
+    // Whole blocks beyond the first one keep the counts array aligned to the cache line
+    if (capacity > BLOCK_SIZE) {
+        capacity = (capacity + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+    }
+    uint32_t* data = nullptr;
+    if (capacity > 0) {
+        data = static_cast<uint32_t*>(allocator_.resource()->allocate(GetAllocationSize(capacity), GetAlignment(capacity)));
+    }
+    if (size_ > 0) {
+        memcpy(data, data_, size_ * sizeof(uint32_t));
+        memcpy(data + capacity, Counts(), size_ * sizeof(uint32_t));
+        memcpy(data + 2 * capacity, Skips(), size_ / BLOCK_SIZE * sizeof(uint32_t));
+    }
+    Deallocate();
+    data_ = data;
+    capacity_ = capacity;
+}
+
+void PostingList::Deallocate() {
+    if (data_) {
+        allocator_.resource()->deallocate(data_, GetAllocationSize(capacity_), GetAlignment(capacity_));
+        data_ = nullptr;
+    }
+}
+
+void PostingList::UpdateSkips(size_t first) {
+    uint32_t* skips = Skips();
+    for (size_t block = first / BLOCK_SIZE; block < size_ / BLOCK_SIZE; ++block) {
+        skips[block] = data_[(block + 1) * BLOCK_SIZE - 1];
+    }
+}
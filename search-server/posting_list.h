@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <xmmintrin.h>
+#endif
+
+// Hint to bring the cache line of address into the cache ahead of its use
+inline void Prefetch(const void* address) {
+#ifdef _MSC_VER
+    _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+    __builtin_prefetch(address);
+#endif
+}
+
+// Documents containing a term: ordinals in ascending order with the number of occurrences of the term.
+// Ordinals and counts are separate arrays of one allocation aligned to the cache line, so scans and
+// lookups read only what they use, and every block of BLOCK_SIZE postings starts a new line of each array.
+// The last ordinal of every full block is repeated in a skip array, a sixteenth of the list long, so
+// a lookup binary searches the skips, which mostly stay cached, and then scans one line of ordinals
+class PostingList {
+public:
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+    static const size_t CACHE_LINE_SIZE = 64;
+    static const size_t BLOCK_SIZE = CACHE_LINE_SIZE / sizeof(uint32_t);
+
+    PostingList() = default;
+    explicit PostingList(const allocator_type& allocator);
+    PostingList(const PostingList& other, const allocator_type& allocator);
+    PostingList(PostingList&& other, const allocator_type& allocator);
+    PostingList(const PostingList& other);
+    PostingList(PostingList&& other) noexcept;
+    PostingList& operator=(const PostingList& other);
+    PostingList& operator=(PostingList&& other);
+    ~PostingList();
+
+    size_t Size() const;
+
+    bool Empty() const;
+
+    size_t Capacity() const;
+
+    // Bytes allocated for the current capacity
+    size_t GetAllocatedBytes() const;
+
+    const uint32_t* Ordinals() const;
+
+    const uint32_t* Counts() const;
+
+    // The ordinal must exceed every ordinal of the list
+    void Append(uint32_t ordinal, uint32_t count);
+
+    // Index of the first posting with an ordinal not less than the given one
+    size_t LowerBound(uint32_t ordinal) const;
+
+    // Index of the posting of the ordinal, Size() if there is none
+    size_t Find(uint32_t ordinal) const;
+
+    bool Contains(uint32_t ordinal) const;
+
+    void Erase(size_t index);
+
+    // Erases every posting i with is_erased(i), which is called once per posting in ascending order of i
+    template <typename Predicate>
+    void EraseIf(Predicate is_erased);
+
+    // Replaces every ordinal by new_ordinals[ordinal]. The mapping must keep their order
+    void Renumber(const std::vector<uint32_t>& new_ordinals);
+
+    void Clear();
+
+    // Reduces the capacity to the size, rounded up to whole blocks
+    void ShrinkToFit();
+
+private:
+    allocator_type allocator_;
+    // Capacity ordinals, then capacity counts, then capacity / BLOCK_SIZE skips
+    uint32_t* data_ = nullptr;
+    uint32_t size_ = 0;
+    uint32_t capacity_ = 0;
+
+    static size_t GetAllocationSize(size_t capacity);
+
+    static size_t GetAlignment(size_t capacity);
+
+    uint32_t* MutableCounts();
+
+    uint32_t* Skips();
+
+    const uint32_t* Skips() const;
+
+    void Reallocate(uint32_t capacity);
+
+    void Deallocate();
+
+    // Recomputes skips of the blocks from the one holding the posting first on
+    void UpdateSkips(size_t first);
+};
+
+template <typename Predicate>
+void PostingList::EraseIf(Predicate is_erased) {
+    uint32_t* counts = MutableCounts();
+    size_t kept = 0;
+    size_t first_erased = size_;
+    for (size_t i = 0; i < size_; ++i) {
+        if (is_erased(i)) {
+            first_erased = std::min(first_erased, i);
+            continue;
+        }
+        data_[kept] = data_[i];
+        counts[kept] = counts[i];
+        ++kept;
+    }
+    size_ = static_cast<uint32_t>(kept);
+    UpdateSkips(first_erased);
+}
@@ -0,0 +1,231 @@
+#include "query_log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+using namespace std;
+
+namespace {
+
+const string_view MAGIC = "SSQLOG1\n"sv;
+
+const uint8_t HAS_CUSTOM_PREDICATE = 1;
+const uint8_t IS_QUERY_TRUNCATED = 2;
+const uint8_t IS_FILTER_TRUNCATED = 4;
+
+size_t RoundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+}  // namespace
+
+QueryLog::QueryLog(const string& path, const QueryLogOptions& options)
+    : options_(options)
+    , output_(path, ios::binary | ios::trunc)
+    , mask_(RoundUpToPowerOfTwo(max<size_t>(options.buffer_capacity, 2)) - 1)
+    , slots_(make_unique<Slot[]>(mask_ + 1))
+    , queries_(make_unique<char[]>((mask_ + 1) * options.max_query_length))
+    , attribute_names_(make_unique<char[]>((mask_ + 1) * options.max_attribute_names_length)) {
+    if (!output_) {
+        throw system_error(errno, generic_category(), "Cannot create "s + path);
+    }
+    for (size_t i = 0; i <= mask_; ++i) {
+        slots_[i].sequence.store(i, memory_order_relaxed);
+    }
+    output_ << MAGIC;
+    writer_ = thread([this] {
+        RunWriter();
+    });
+}
+
+QueryLog::~QueryLog() {
+    {
+        lock_guard lock(mutex_);
+        is_stopping_ = true;
+    }
+    wake_writer_.notify_one();
+    writer_.join();
+}
+
+bool QueryLog::Record(string_view query, const DocumentFilter* filter, uint64_t timestamp_us, uint32_t latency_us,
+                      uint32_t result_count) {
+    // Bounded multi-producer queue: a slot is free for position p when its sequence is p,
+    // and is published for the writer when its sequence is p + 1
+    size_t position = enqueue_position_.load(memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+        slot = &slots_[position & mask_];
+        const size_t sequence = slot->sequence.load(memory_order_acquire);
+        if (sequence == position) {
+            if (enqueue_position_.compare_exchange_weak(position, position + 1, memory_order_relaxed)) {
+                break;
+            }
+        } else if (sequence < position) {
+            // The writer has not freed the slot since the previous round
+            dropped_count_.fetch_add(1, memory_order_relaxed);
+            return false;
+        } else {
+            position = enqueue_position_.load(memory_order_relaxed);
+        }
+    }
+    slot->timestamp_us = timestamp_us;
+    slot->latency_us = latency_us;
+    slot->result_count = result_count;
+    slot->flags = filter == nullptr ? HAS_CUSTOM_PREDICATE : 0;
+    slot->status_mask = 0;
+    slot->min_rating = numeric_limits<int>::min();
+    slot->max_rating = numeric_limits<int>::max();
+    slot->attribute_range_count = 0;
+    if (filter != nullptr) {
+        if (filter->HasStatusRestriction()) {
+            for (size_t status = 0; status < DOCUMENT_STATUS_COUNT; ++status) {
+                if (filter->IsStatusAllowed(static_cast<DocumentStatus>(status))) {
+                    slot->status_mask |= 1u << status;
+                }
+            }
+        }
+        slot->min_rating = filter->GetMinRating();
+        slot->max_rating = filter->GetMaxRating();
+        char* names = &attribute_names_[(position & mask_) * options_.max_attribute_names_length];
+        size_t names_length = 0;
+        for (const AttributeRange& range : filter->GetAttributeRanges()) {
+            if (slot->attribute_range_count == MAX_ATTRIBUTE_RANGES
+                || names_length + range.name.size() > options_.max_attribute_names_length) {
+                slot->flags |= IS_FILTER_TRUNCATED;
+                break;
+            }
+            memcpy(names + names_length, range.name.data(), range.name.size());
+            names_length += range.name.size();
+            slot->attribute_ranges[slot->attribute_range_count++] = {range.name.size(), range.min, range.max};
+        }
+    }
+    slot->query_length = min(query.size(), options_.max_query_length);
+    if (slot->query_length < query.size()) {
+        slot->flags |= IS_QUERY_TRUNCATED;
+    }
+    memcpy(&queries_[(position & mask_) * options_.max_query_length], query.data(), slot->query_length);
+    slot->sequence.store(position + 1, memory_order_release);
+    return true;
+}
+
+void QueryLog::Flush() {
+    const size_t target = enqueue_position_.load(memory_order_relaxed);
+    unique_lock lock(mutex_);
+    is_flush_requested_ = true;
+    wake_writer_.notify_one();
+    written_.wait(lock, [this, target] {
+        return written_position_ >= target || has_failed_;
+    });
+    if (has_failed_) {
+        throw runtime_error("Cannot write the query log"s);
+    }
+}
+
+uint64_t QueryLog::GetDroppedCount() const {
+    return dropped_count_.load(memory_order_relaxed);
+}
+
+uint64_t QueryLog::Now() {
+    return chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void QueryLog::RunWriter() {
+    // Reused, so that the writer does not allocate per record
+    MessageWriter output;
+    MessageWriter record;
+    unique_lock lock(mutex_);
+    while (true) {
+        const bool is_last_pass = is_stopping_;
+        is_flush_requested_ = false;
+        lock.unlock();
+        // Slots claimed but not yet published stop a pass; the next one picks them up
+        while (CollectRecords(output, record)) {
+            output_.write(output.GetData().data(), output.GetData().size());
+            output.Clear();
+        }
+        output_.flush();
+        lock.lock();
+        written_position_ = dequeue_position_;
+        has_failed_ = has_failed_ || !output_;
+        written_.notify_all();
+        if (is_last_pass) {
+            return;
+        }
+        wake_writer_.wait_for(lock, options_.flush_interval, [this] {
+            return is_stopping_ || is_flush_requested_;
+        });
+    }
+}
+
+bool QueryLog::CollectRecords(MessageWriter& output, MessageWriter& record) {
+    const size_t batch_end = dequeue_position_ + mask_ + 1;
+    while (dequeue_position_ < batch_end) {
+        Slot& slot = slots_[dequeue_position_ & mask_];
+        if (slot.sequence.load(memory_order_acquire) != dequeue_position_ + 1) {
+            break;
+        }
+        record.Clear();
+        record.PutUint64(slot.timestamp_us);
+        record.PutUint32(slot.latency_us);
+        record.PutUint32(slot.result_count);
+        record.PutUint8(slot.flags);
+        DocumentFilter filter;
+        for (size_t status = 0; status < DOCUMENT_STATUS_COUNT; ++status) {
+            if ((slot.status_mask >> status) & 1) {
+                filter.AllowStatus(static_cast<DocumentStatus>(status));
+            }
+        }
+        filter.MinRating(slot.min_rating).MaxRating(slot.max_rating);
+        const char* names = &attribute_names_[(dequeue_position_ & mask_) * options_.max_attribute_names_length];
+        for (size_t i = 0; i < slot.attribute_range_count; ++i) {
+            const AttributeRangeSnapshot& range = slot.attribute_ranges[i];
+            filter.AttributeBetween({names, range.name_length}, range.min, range.max);
+            names += range.name_length;
+        }
+        WriteDocumentFilter(record, filter);
+        record.PutString({&queries_[(dequeue_position_ & mask_) * options_.max_query_length], slot.query_length});
+        output.PutString(record.GetData());
+        slot.sequence.store(dequeue_position_ + mask_ + 1, memory_order_release);
+        ++dequeue_position_;
+    }
+    return !output.GetData().empty();
+}
+
+vector<QueryLogRecord> ReadQueryLog(istream& input) {
+    const string data{istreambuf_iterator<char>(input), istreambuf_iterator<char>()};
+    if (data.compare(0, MAGIC.size(), MAGIC) != 0) {
+        throw invalid_argument("Not a query log"s);
+    }
+    vector<QueryLogRecord> records;
+    MessageReader reader(string_view(data).substr(MAGIC.size()));
+    while (!reader.AtEnd()) {
+        // A record is a size-prefixed string of its fields
+        string_view payload;
+        try {
+            payload = reader.GetString();
+        } catch (const invalid_argument&) {
+            break;
+        }
+        MessageReader fields(payload);
+        QueryLogRecord record;
+        record.timestamp_us = fields.GetUint64();
+        record.latency_us = fields.GetUint32();
+        record.result_count = fields.GetUint32();
+        const uint8_t flags = fields.GetUint8();
+        record.has_custom_predicate = (flags & HAS_CUSTOM_PREDICATE) != 0;
+        record.is_query_truncated = (flags & IS_QUERY_TRUNCATED) != 0;
+        record.is_filter_truncated = (flags & IS_FILTER_TRUNCATED) != 0;
+        record.filter = ReadDocumentFilter(fields);
+        record.query = string(fields.GetString());
+        records.push_back(move(record));
+    }
+    return records;
+}
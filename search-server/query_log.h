@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "document_filter.h"
+#include "shard_protocol.h"
+
+struct QueryLogRecord {
+    // Microseconds since the Unix epoch at the arrival of the query
+    uint64_t timestamp_us = 0;
+    uint32_t latency_us = 0;
+    uint32_t result_count = 0;
+    // The query was filtered by an arbitrary predicate, which cannot be logged; filter accepts everything then
+    bool has_custom_predicate = false;
+    // query is only the first QueryLogOptions::max_query_length bytes of the query
+    bool is_query_truncated = false;
+    // Attribute ranges beyond the limits of QueryLog were left out of filter
+    bool is_filter_truncated = false;
+    DocumentFilter filter;
+    std::string query;
+};
+
+struct QueryLogOptions {
+    // Records waiting for the writer thread, rounded up to a power of two.
+    // Records not fitting are dropped, so queries never wait for the disk
+    size_t buffer_capacity = 1 << 14;
+    // Longer queries are truncated
+    size_t max_query_length = 1024;
+    // Room for the names of the attribute ranges of a filter; ranges not fitting are left out
+    size_t max_attribute_names_length = 256;
+    // How often the writer thread collects the records
+    std::chrono::milliseconds flush_interval{10};
+};
+
+// Binary log of queries, written to a file by a background thread. Record() is lock-free, does not
+// allocate and may be called from any number of threads: it copies the query and a flat snapshot of the
+// filter into a slot of a bounded ring, and the writer thread encodes the filled slots and appends them to the file.
+// File: "SSQLOG1\n", then for every record its size (u32), timestamp (u64), latency (u32), result count (u32),
+// flags (u8), DocumentFilter and query, encoded as in shard_protocol.h
+class QueryLog {
+public:
+    // Throws system_error if the file cannot be created
+    explicit QueryLog(const std::string& path, const QueryLogOptions& options = QueryLogOptions());
+
+    QueryLog(const QueryLog&) = delete;
+    QueryLog& operator=(const QueryLog&) = delete;
+
+    // Writes the rest of the records. Record() must not be running
+    ~QueryLog();
+
+    // Null filter means a custom predicate. Returns false if the buffer is full and the record is dropped
+    bool Record(std::string_view query, const DocumentFilter* filter, uint64_t timestamp_us, uint32_t latency_us,
+                uint32_t result_count);
+
+    // Waits until the records made before the call are written. Throws runtime_error if writing failed
+    void Flush();
+
+    uint64_t GetDroppedCount() const;
+
+    static uint64_t Now();
+
+private:
+    // Attribute ranges kept per record; the rest are left out
+    static const size_t MAX_ATTRIBUTE_RANGES = 4;
+
+    struct AttributeRangeSnapshot {
+        size_t name_length = 0;
+        AttributeValue min = 0;
+        AttributeValue max = 0;
+    };
+
+    struct Slot {
+        std::atomic<size_t> sequence;
+        uint64_t timestamp_us;
+        uint32_t latency_us;
+        uint32_t result_count;
+        uint8_t flags;
+        // DocumentFilter copied without allocation, the names of the ranges go to attribute_names_
+        uint8_t status_mask;
+        int min_rating;
+        int max_rating;
+        size_t attribute_range_count;
+        std::array<AttributeRangeSnapshot, MAX_ATTRIBUTE_RANGES> attribute_ranges;
+        size_t query_length;
+    };
+
+    QueryLogOptions options_;
+    std::ofstream output_;
+    size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    // max_query_length bytes for every slot
+    std::unique_ptr<char[]> queries_;
+    // max_attribute_names_length bytes for every slot
+    std::unique_ptr<char[]> attribute_names_;
+    alignas(64) std::atomic<size_t> enqueue_position_ = 0;
+    std::atomic<uint64_t> dropped_count_ = 0;
+
+    // Everything below belongs to the writer thread or is guarded by mutex_
+    alignas(64) size_t dequeue_position_ = 0;
+    std::mutex mutex_;
+    std::condition_variable wake_writer_;
+    std::condition_variable written_;
+    size_t written_position_ = 0;
+    bool is_flush_requested_ = false;
+    bool is_stopping_ = false;
+    bool has_failed_ = false;
+    std::thread writer_;
+
+    void RunWriter();
+
+    // Encodes the published slots in order into output. Returns false if there were none
+    bool CollectRecords(MessageWriter& output, MessageWriter& record);
+};
+
+// Reads a whole log. An incomplete last record, left by a process killed while writing, is ignored.
+// Throws invalid_argument if the data is not a query log
+std::vector<QueryLogRecord> ReadQueryLog(std::istream& input);
@@ -0,0 +1,49 @@
+#include "query_plan.h"
+
+using namespace std;
+
+namespace {
+
+void PrintGroups(ostream& out, const vector<QueryPlan::Group>& groups) {
+    bool first_group = true;
+    for (const QueryPlan::Group& group : groups) {
+        out << (first_group ? " "s : ", "s) << group.query_word;
+        if (group.kind != QueryPlan::Group::Kind::WORD) {
+            out << (group.kind == QueryPlan::Group::Kind::PREFIX ? "* ->"s : "~ ->"s);
+            for (const QueryPlan::Term& term : group.terms) {
+                out << " "s << term.word;
+                if (term.distance > 0) {
+                    out << "~"s << term.distance;
+                }
+            }
+        }
+        out << " ("s << group.cost << ")"s;
+        first_group = false;
+    }
+}
+
+}  // namespace
+
+bool IsPreferredExpansion(const QueryPlan::Term& lhs, const QueryPlan::Term& rhs) {
+    if (lhs.distance != rhs.distance) {
+        return lhs.distance < rhs.distance;
+    }
+    if (lhs.document_count != rhs.document_count) {
+        return lhs.document_count > rhs.document_count;
+    }
+    return lhs.word < rhs.word;
+}
+
+ostream& operator<<(ostream& out, const QueryPlan& plan) {
+    static const char* exclusion_names[] = {"none", "bitmap", "probe"};
+    out << (plan.parallel ? "parallel"s : "sequential"s) << ", cost "s << plan.estimated_cost << endl;
+    out << "plus:"s;
+    PrintGroups(out, plan.plus_groups);
+    out << endl << "minus ["s << exclusion_names[static_cast<int>(plan.exclusion)] << "]:"s;
+    PrintGroups(out, plan.minus_groups);
+    out << endl << "skipped:"s;
+    for (const string_view word : plan.skipped_words) {
+        out << " "s << word;
+    }
+    return out << endl;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+// Describes how SearchServer evaluates a query, see SearchServer::Explain.
+// Words are views into the server dictionary and the query text
+struct QueryPlan {
+    enum class Exclusion {
+        // No minus word has documents, or there is nothing to exclude from
+        NONE,
+        // Documents of minus words are collected before scoring and never scored
+        BITMAP,
+        // Minus words are much longer than plus words, so they are probed for every found document
+        PROBE,
+    };
+
+    struct Term {
+        std::string_view word;
+        size_t document_count;
+        // Number of edits for a misspelled match of a fuzzy word
+        int distance;
+    };
+
+    // One word of the query; prefixes and fuzzy words are expanded to several dictionary words
+    struct Group {
+        enum class Kind {
+            WORD,
+            PREFIX,
+            FUZZY,
+        };
+
+        std::string_view query_word;
+        Kind kind;
+        std::vector<Term> terms;
+        size_t cost;
+    };
+
+    // Plus words ordered by cost, cheapest first
+    std::vector<Group> plus_groups;
+    std::vector<Group> minus_groups;
+    // Query words without documents
+    std::vector<std::string_view> skipped_words;
+    Exclusion exclusion = Exclusion::NONE;
+    // Number of postings to visit
+    size_t estimated_cost = 0;
+    // Size of the collection the document counts of the terms refer to
+    size_t document_count = 0;
+    bool parallel = false;
+};
+
+// Order in which expansions of a prefix or a misspelled word are kept under a cap:
+// the closest words first, then the most frequent ones, then in alphabetical order
+bool IsPreferredExpansion(const QueryPlan::Term& lhs, const QueryPlan::Term& rhs);
+
+std::ostream& operator<<(std::ostream& out, const QueryPlan& plan);
@@ -10,7 +10,7 @@ void RemoveDuplicates(SearchServer& search_server) {
     for(int document_id: search_server) {
         set<string> words;
         for(auto [word, _]: search_server.GetWordFrequencies(document_id)) {
-            words.insert(word);
+            words.insert(string(word));
         }
         if(documents_words.count(words)) {
             ids_to_remove.push_back(document_id);
@@ -2,22 +2,25 @@
 
 using namespace std;
 
-RequestQueue::RequestQueue(const SearchServer& search_server)
+RequestQueue::RequestQueue(const SearchServer& search_server, QueryLog* query_log)
     : search_server_(search_server)
+    , query_log_(query_log)
     , no_results_requests_(0)
     , current_time_(0) {
 }
 
 vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentStatus status) {
-    vector<Document> result = search_server_.FindTopDocuments(raw_query, status);
-    AddRequest(result.size());
-    return result;
+    return AddFindRequest(raw_query, DocumentFilter(status));
+}
+
+vector<Document> RequestQueue::AddFindRequest(const string& raw_query, const DocumentFilter& filter) {
+    return Execute(raw_query, &filter, [&] {
+        return search_server_.FindTopDocuments(raw_query, filter);
+    });
 }
 
 vector<Document> RequestQueue::AddFindRequest(const string& raw_query) {
-    vector<Document> result = search_server_.FindTopDocuments(raw_query);
-    AddRequest(result.size());
-    return result;
+    return AddFindRequest(raw_query, DocumentStatus::ACTUAL);
 }
 
 int RequestQueue::GetNoResultRequests() const {
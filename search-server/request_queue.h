@@ -1,20 +1,25 @@
 #pragma once
 
 #include "search_server.h"
+#include "query_log.h"
 
 #include <vector>
 #include <string>
 #include <deque>
+#include <chrono>
 
 class RequestQueue {
 public:
-    explicit RequestQueue(const SearchServer& search_server);
+    // Every request is also written to query_log when it is given
+    explicit RequestQueue(const SearchServer& search_server, QueryLog* query_log = nullptr);
     
     template <typename DocumentPredicate>
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate);
 
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentStatus status);
 
+    std::vector<Document> AddFindRequest(const std::string& raw_query, const DocumentFilter& filter);
+
     std::vector<Document> AddFindRequest(const std::string& raw_query);
 
     int GetNoResultRequests() const;
@@ -25,16 +30,37 @@ private:
     };
     std::deque<QueryResult> requests_;
     const SearchServer& search_server_;
+    QueryLog* query_log_;
     int no_results_requests_;
     uint64_t current_time_;
     const static int min_in_day_ = 1440;
  
     void AddRequest(int results_num);
+
+    // Null filter stands for a custom predicate in the log
+    template <typename Find>
+    std::vector<Document> Execute(const std::string& raw_query, const DocumentFilter* filter, Find find);
 };
 
 template <typename DocumentPredicate>
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
-    std::vector<Document> result = search_server_.FindTopDocuments(raw_query, document_predicate);
+    return Execute(raw_query, nullptr, [&] {
+        return search_server_.FindTopDocuments(raw_query, document_predicate);
+    });
+}
+
+template <typename Find>
+std::vector<Document> RequestQueue::Execute(const std::string& raw_query, const DocumentFilter* filter, Find find) {
+    if (query_log_ == nullptr) {
+        std::vector<Document> result = find();
+        AddRequest(result.size());
+        return result;
+    }
+    const uint64_t timestamp_us = QueryLog::Now();
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<Document> result = find();
+    const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    query_log_->Record(raw_query, filter, timestamp_us, static_cast<uint32_t>(latency.count()), static_cast<uint32_t>(result.size()));
     AddRequest(result.size());
     return result;
 }
\ No newline at end of file
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+
+#include "document.h"
+
+// Policies of SearchServer::FindTopDocumentsWith, all resolved at compile time
+
+struct CollectionStats {
+    size_t document_count;
+    double average_word_count;
+};
+
+// A scorer computes the weight of a query word once per query and the relevance of every posting
+// from the number of occurrences of the word in the document. USES_WORD_COUNT tells whether the
+// scoring loop has to load the document length, Relevance is the type of the accumulated scores
+struct TfIdfScorer {
+    using Relevance = double;
+    static constexpr bool USES_WORD_COUNT = false;
+
+    static double ComputeWordWeight(size_t document_freq, const CollectionStats& stats) {
+        return std::log(stats.document_count * 1.0 / document_freq);
+    }
+
+    static double ComputeRelevance(uint32_t count, double inv_word_count, [[maybe_unused]] uint32_t word_count,
+                                   double word_weight, [[maybe_unused]] const CollectionStats& stats) {
+        return count * inv_word_count * word_weight;
+    }
+};
+
+// TF-IDF accumulated in float: twice as many scores per vector register, rankings match
+// TfIdfScorer within EPS for relevances below 1
+struct FloatTfIdfScorer {
+    using Relevance = float;
+    static constexpr bool USES_WORD_COUNT = false;
+
+    static double ComputeWordWeight(size_t document_freq, const CollectionStats& stats) {
+        return TfIdfScorer::ComputeWordWeight(document_freq, stats);
+    }
+
+    static float ComputeRelevance(uint32_t count, double inv_word_count, [[maybe_unused]] uint32_t word_count,
+                                  float word_weight, [[maybe_unused]] const CollectionStats& stats) {
+        return static_cast<float>(count) * static_cast<float>(inv_word_count) * word_weight;
+    }
+};
+
+// Okapi BM25 with k1 = 1.2 and b = 0.75
+struct Bm25Scorer {
+    using Relevance = double;
+    static constexpr bool USES_WORD_COUNT = true;
+    static constexpr double K1 = 1.2;
+    static constexpr double B = 0.75;
+
+    static double ComputeWordWeight(size_t document_freq, const CollectionStats& stats) {
+        return std::log(1.0 + (stats.document_count - document_freq + 0.5) / (document_freq + 0.5));
+    }
+
+    static double ComputeRelevance(uint32_t count, [[maybe_unused]] double inv_word_count, uint32_t word_count,
+                                   double word_weight, const CollectionStats& stats) {
+        return word_weight * count * (K1 + 1.0) / (count + K1 * (1.0 - B + B * word_count / stats.average_word_count));
+    }
+};
+
+// Filters known at compile time. Besides them a filter may be a DocumentFilter
+// or a predicate(document_id, status, rating)
+struct AnyDocument {
+};
+
+template <DocumentStatus Status>
+struct StatusIs {
+    static constexpr DocumentStatus STATUS = Status;
+};
+
+template <typename Filter>
+struct IsStatusFilter : std::false_type {
+};
+
+template <DocumentStatus Status>
+struct IsStatusFilter<StatusIs<Status>> : std::true_type {
+};
+
+// Orders of the results, they differ in documents of equal relevance.
+// Same order as RanksBefore: relevance rounded to EPS, then rating and id
+struct RatingWithinEps {
+    bool operator()(const Document& lhs, const Document& rhs) const {
+        return RanksBefore(lhs, rhs);
+    }
+};
+
+// Relevance compared exactly, then rating and id; cheaper, but rounding errors may reorder
+// documents which are equally relevant in theory
+struct ExactRelevance {
+    bool operator()(const Document& lhs, const Document& rhs) const {
+        return std::tie(rhs.relevance, rhs.rating, lhs.id) < std::tie(lhs.relevance, lhs.rating, rhs.id);
+    }
+};
@@ -0,0 +1,337 @@
+#include "search_frontend.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+// epoll data of the sockets which are not connections; connection ids never reach them
+const uint64_t LISTENER_TAG = numeric_limits<uint64_t>::max();
+const uint64_t WAKEUP_TAG = numeric_limits<uint64_t>::max() - 1;
+
+const array<const char*, DOCUMENT_STATUS_COUNT> STATUS_NAMES = {"ACTUAL", "IRRELEVANT", "BANNED", "REMOVED"};
+
+void Notify(const UniqueFd& event) {
+    const uint64_t increment = 1;
+    // A full counter wakes the loop as well
+    [[maybe_unused]] const ssize_t size = write(event.Get(), &increment, sizeof(increment));
+}
+
+void Watch(const UniqueFd& epoll, int operation, int fd, uint32_t events, uint64_t tag) {
+    epoll_event event{};
+    event.events = events;
+    event.data.u64 = tag;
+    if (epoll_ctl(epoll.Get(), operation, fd, &event) < 0) {
+        throw system_error(errno, generic_category(), "epoll_ctl"s);
+    }
+}
+
+}  // namespace
+
+SearchFrontend::SearchFrontend(const SearchServer& server, const FrontendOptions& options)
+    : server_(server)
+    , options_(options)
+    , listener_(ListenTcpSocket(options.address, options.port))
+    , epoll_(epoll_create1(EPOLL_CLOEXEC))
+    , wakeup_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+    if (epoll_.Get() < 0 || wakeup_.Get() < 0) {
+        throw system_error(errno, generic_category(), "epoll"s);
+    }
+    if (options_.max_pipelined_requests == 0) {
+        throw invalid_argument("At least one request per connection must be allowed"s);
+    }
+    Watch(epoll_, EPOLL_CTL_ADD, listener_.Get(), EPOLLIN, LISTENER_TAG);
+    Watch(epoll_, EPOLL_CTL_ADD, wakeup_.Get(), EPOLLIN, WAKEUP_TAG);
+}
+
+uint16_t SearchFrontend::GetPort() const {
+    return GetLocalPort(listener_);
+}
+
+void SearchFrontend::Serve() {
+    const size_t worker_count = options_.worker_count > 0 ? options_.worker_count
+                                                          : max(1u, thread::hardware_concurrency());
+    vector<thread> workers;
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers.emplace_back([this] {
+            RunWorker();
+        });
+    }
+
+    array<epoll_event, 64> events;
+    while (!is_stopping_) {
+        const int event_count = epoll_wait(epoll_.Get(), events.data(), events.size(), -1);
+        if (event_count < 0 && errno != EINTR) {
+            throw system_error(errno, generic_category(), "epoll_wait"s);
+        }
+        for (int i = 0; i < event_count; ++i) {
+            const uint64_t tag = events[i].data.u64;
+            if (tag == LISTENER_TAG) {
+                AcceptConnections();
+            } else if (tag == WAKEUP_TAG) {
+                uint64_t counter;
+                [[maybe_unused]] const ssize_t size = read(wakeup_.Get(), &counter, sizeof(counter));
+                DrainCompletions();
+            } else if (const auto it = connections_.find(tag); it != connections_.end()) {
+                if (!Process(tag, it->second, events[i].events)) {
+                    connections_.erase(it);
+                }
+            }
+        }
+    }
+
+    {
+        lock_guard lock(tasks_mutex_);
+        are_workers_stopping_ = true;
+    }
+    has_tasks_.notify_all();
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    connections_.clear();
+    tasks_.clear();
+    completions_.clear();
+}
+
+void SearchFrontend::Stop() {
+    is_stopping_ = true;
+    Notify(wakeup_);
+}
+
+string SearchFrontend::Execute(const SearchServer& server, string_view request) {
+    const size_t space = request.find(' ');
+    const string_view command = request.substr(0, space);
+    const string_view argument = space == string_view::npos ? string_view() : request.substr(space + 1);
+    ostringstream response;
+    try {
+        if (command == "FIND"sv) {
+            const vector<Document> documents = server.FindTopDocuments(argument);
+            response << "OK "s << documents.size();
+            for (const Document& document : documents) {
+                response << ' ' << document.id << ' ' << document.relevance << ' ' << document.rating;
+            }
+        } else if (command == "MATCH"sv) {
+            const size_t id_end = min(argument.find(' '), argument.size());
+            int document_id = 0;
+            if (from_chars(argument.data(), argument.data() + id_end, document_id).ptr != argument.data() + id_end
+                || id_end == 0) {
+                throw invalid_argument("Invalid document id"s);
+            }
+            const auto [words, status] = server.MatchDocument(argument.substr(min(id_end + 1, argument.size())), document_id);
+            response << "OK "s << STATUS_NAMES[static_cast<size_t>(status)];
+            for (const string_view word : words) {
+                response << ' ' << word;
+            }
+        } else if (command == "PING"sv) {
+            response << "OK"s;
+        } else {
+            throw invalid_argument("Unknown command "s + string(command));
+        }
+    } catch (const exception& e) {
+        return "ERROR "s + e.what();
+    }
+    return response.str();
+}
+
+void SearchFrontend::RunWorker() {
+    while (true) {
+        Task task;
+        {
+            unique_lock lock(tasks_mutex_);
+            has_tasks_.wait(lock, [this] {
+                return are_workers_stopping_ || !tasks_.empty();
+            });
+            if (are_workers_stopping_) {
+                return;
+            }
+            task = move(tasks_.front());
+            tasks_.pop_front();
+        }
+        string response = Execute(server_, task.request);
+        bool was_empty;
+        {
+            lock_guard lock(completions_mutex_);
+            was_empty = completions_.empty();
+            completions_.push_back({task.connection_id, task.sequence, move(response)});
+        }
+        // The loop drains all completions at once, one wakeup per batch is enough
+        if (was_empty) {
+            Notify(wakeup_);
+        }
+    }
+}
+
+void SearchFrontend::AcceptConnections() {
+    while (true) {
+        UniqueFd socket = AcceptConnection(listener_);
+        if (socket.Get() < 0) {
+            return;
+        }
+        // Responses are batched here, the kernel should not delay them once more
+        const int enable = 1;
+        setsockopt(socket.Get(), IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        const uint64_t connection_id = next_connection_id_++;
+        Connection& connection = connections_[connection_id];
+        connection.socket = move(socket);
+        connection.events = EPOLLIN | EPOLLRDHUP;
+        Watch(epoll_, EPOLL_CTL_ADD, connection.socket.Get(), connection.events, connection_id);
+    }
+}
+
+void SearchFrontend::DrainCompletions() {
+    vector<Completion> completions;
+    {
+        lock_guard lock(completions_mutex_);
+        completions.swap(completions_);
+    }
+    vector<uint64_t> touched;
+    for (Completion& completion : completions) {
+        const auto it = connections_.find(completion.connection_id);
+        // The client may have gone while its request was executed
+        if (it == connections_.end()) {
+            continue;
+        }
+        Connection& connection = it->second;
+        connection.completed.emplace(completion.sequence, move(completion.response));
+        while (!connection.completed.empty() && connection.completed.begin()->first == connection.next_to_send) {
+            connection.output += connection.completed.begin()->second;
+            connection.output += '\n';
+            connection.completed.erase(connection.completed.begin());
+            ++connection.next_to_send;
+        }
+        touched.push_back(completion.connection_id);
+    }
+    sort(touched.begin(), touched.end());
+    touched.erase(unique(touched.begin(), touched.end()), touched.end());
+    for (const uint64_t connection_id : touched) {
+        const auto it = connections_.find(connection_id);
+        if (!Process(connection_id, it->second, 0)) {
+            connections_.erase(it);
+        }
+    }
+}
+
+bool SearchFrontend::Process(uint64_t connection_id, Connection& connection, uint32_t events) {
+    // Nothing can be sent to a client which has hung up or failed, its requests are abandoned
+    if (events & (EPOLLHUP | EPOLLERR)) {
+        return false;
+    }
+    if ((events & (EPOLLIN | EPOLLRDHUP)) && !ReadInput(connection)) {
+        return false;
+    }
+    DispatchRequests(connection_id, connection);
+    const bool has_request = connection.input.find('\n') != string::npos;
+    if (!has_request && connection.input.size() > options_.max_request_length) {
+        return false;
+    }
+    if (connection.output.size() > connection.output_offset && !WriteOutput(connection)) {
+        return false;
+    }
+    const bool is_done = connection.next_to_send == connection.next_sequence && connection.output.empty();
+    if (connection.is_input_closed && is_done && !has_request) {
+        return false;
+    }
+    UpdateEvents(connection_id, connection);
+    return true;
+}
+
+bool SearchFrontend::ReadInput(Connection& connection) {
+    // One read per event keeps the input bounded; level-triggered epoll reports the rest
+    char buffer[64 * 1024];
+    while (true) {
+        const ssize_t size = read(connection.socket.Get(), buffer, sizeof(buffer));
+        if (size > 0) {
+            connection.input.append(buffer, size);
+            return true;
+        }
+        if (size == 0) {
+            connection.is_input_closed = true;
+            return true;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return true;
+        }
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+void SearchFrontend::DispatchRequests(uint64_t connection_id, Connection& connection) {
+    vector<Task> tasks;
+    size_t offset = 0;
+    while (connection.next_sequence - connection.next_to_send < options_.max_pipelined_requests
+           && connection.output.size() - connection.output_offset < options_.max_pending_output) {
+        const size_t line_end = connection.input.find('\n', offset);
+        if (line_end == string::npos) {
+            break;
+        }
+        string request = connection.input.substr(offset, line_end - offset);
+        if (!request.empty() && request.back() == '\r') {
+            request.pop_back();
+        }
+        tasks.push_back({connection_id, connection.next_sequence++, move(request)});
+        offset = line_end + 1;
+    }
+    connection.input.erase(0, offset);
+    if (tasks.empty()) {
+        return;
+    }
+    {
+        lock_guard lock(tasks_mutex_);
+        move(tasks.begin(), tasks.end(), back_inserter(tasks_));
+    }
+    if (tasks.size() == 1) {
+        has_tasks_.notify_one();
+    } else {
+        has_tasks_.notify_all();
+    }
+}
+
+bool SearchFrontend::WriteOutput(Connection& connection) {
+    while (connection.output_offset < connection.output.size()) {
+        const ssize_t size = send(connection.socket.Get(), connection.output.data() + connection.output_offset,
+                                  connection.output.size() - connection.output_offset, MSG_NOSIGNAL);
+        if (size >= 0) {
+            connection.output_offset += size;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return true;
+        } else if (errno != EINTR) {
+            return false;
+        }
+    }
+    connection.output.clear();
+    connection.output_offset = 0;
+    return true;
+}
+
+void SearchFrontend::UpdateEvents(uint64_t connection_id, Connection& connection) {
+    // Buffered requests are dispatched before anything else is read
+    const bool can_read = !connection.is_input_closed && connection.input.find('\n') == string::npos
+                          && connection.next_sequence - connection.next_to_send < options_.max_pipelined_requests
+                          && connection.output.size() - connection.output_offset < options_.max_pending_output;
+    uint32_t events = can_read ? EPOLLIN | EPOLLRDHUP : 0;
+    if (connection.output.size() > connection.output_offset) {
+        events |= EPOLLOUT;
+    }
+    if (events != connection.events) {
+        Watch(epoll_, EPOLL_CTL_MOD, connection.socket.Get(), events, connection_id);
+        connection.events = events;
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "search_server.h"
+#include "socket_util.h"
+
+struct FrontendOptions {
+    std::string address = "127.0.0.1";
+    // Zero asks the system for a free port, see SearchFrontend::GetPort()
+    uint16_t port = 0;
+    // Zero means one worker per hardware thread
+    size_t worker_count = 0;
+    // Requests of one connection being executed or waiting for earlier responses. A connection
+    // reaching the limit, or max_pending_output bytes of unsent responses, is not read until it drains
+    size_t max_pipelined_requests = 128;
+    size_t max_pending_output = 1 << 20;
+    size_t max_request_length = 64 * 1024;
+};
+
+// Network front end of a SearchServer speaking a line protocol over TCP:
+//   FIND <query>          -> OK <count> <id> <relevance> <rating> ...
+//   MATCH <id> <query>    -> OK <status> <word> ...
+//   PING                  -> OK
+// Errors are answered with ERROR <message>. One thread runs an epoll loop over non-blocking
+// sockets and hands requests to a pool of workers. A client may send many requests without
+// waiting; responses come in the order of requests, and all responses ready for a connection
+// are written with one send
+class SearchFrontend {
+public:
+    // Listens from construction on. The server must not change while the front end serves
+    explicit SearchFrontend(const SearchServer& server, const FrontendOptions& options = FrontendOptions());
+
+    SearchFrontend(const SearchFrontend&) = delete;
+    SearchFrontend& operator=(const SearchFrontend&) = delete;
+
+    uint16_t GetPort() const;
+
+    // Returns after Stop(); responses not sent by then are dropped
+    void Serve();
+
+    // Safe to call from other threads and from signal handlers
+    void Stop();
+
+    // Response line to one request line, without the line break
+    static std::string Execute(const SearchServer& server, std::string_view request);
+
+private:
+    struct Connection {
+        UniqueFd socket;
+        std::string input;
+        std::string output;
+        size_t output_offset = 0;
+        uint64_t next_sequence = 0;
+        uint64_t next_to_send = 0;
+        // Responses which came before the responses to earlier requests
+        std::map<uint64_t, std::string> completed;
+        uint32_t events = 0;
+        bool is_input_closed = false;
+    };
+
+    struct Task {
+        uint64_t connection_id;
+        uint64_t sequence;
+        std::string request;
+    };
+
+    struct Completion {
+        uint64_t connection_id;
+        uint64_t sequence;
+        std::string response;
+    };
+
+    const SearchServer& server_;
+    FrontendOptions options_;
+    UniqueFd listener_;
+    UniqueFd epoll_;
+    // Woken by finished tasks and by Stop()
+    UniqueFd wakeup_;
+    std::atomic<bool> is_stopping_ = false;
+
+    std::unordered_map<uint64_t, Connection> connections_;
+    uint64_t next_connection_id_ = 0;
+
+    std::mutex tasks_mutex_;
+    std::condition_variable has_tasks_;
+    std::deque<Task> tasks_;
+    bool are_workers_stopping_ = false;
+
+    std::mutex completions_mutex_;
+    std::vector<Completion> completions_;
+
+    void RunWorker();
+
+    void AcceptConnections();
+
+    void DrainCompletions();
+
+    // Reads, dispatches, writes and updates the interest of one connection.
+    // Returns false when it has been closed
+    bool Process(uint64_t connection_id, Connection& connection, uint32_t events);
+
+    bool ReadInput(Connection& connection);
+
+    void DispatchRequests(uint64_t connection_id, Connection& connection);
+
+    bool WriteOutput(Connection& connection);
+
+    void UpdateEvents(uint64_t connection_id, Connection& connection);
+};
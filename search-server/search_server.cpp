@@ -4,112 +4,235 @@
 #include <numeric>
 #include <algorithm>
 #include <cmath>
+#include <limits>
+#include <optional>
 
 #include "string_processing.h"
 
 using namespace std;
 
-SearchServer::SearchServer(const string_view& stop_words_text)
-    : SearchServer(SplitIntoWords(stop_words_text)) {
+SearchServer::SearchServer(const string_view& stop_words_text, const IndexOptions& options)
+    : SearchServer(SplitIntoWords(stop_words_text), options) {
 }
 
-SearchServer::SearchServer(const string& stop_words_text)
-    : SearchServer(string_view(stop_words_text)) {
+SearchServer::SearchServer(const string& stop_words_text, const IndexOptions& options)
+    : SearchServer(string_view(stop_words_text), options) {
+}
+
+SearchServer::TermPositions::TermPositions(const allocator_type& allocator)
+    : data(allocator)
+    , offsets(allocator) {
+}
+
+SearchServer::TermPositions::TermPositions(const TermPositions& other, const allocator_type& allocator)
+    : data(other.data, allocator)
+    , offsets(other.offsets, allocator)
+    , garbage(other.garbage) {
+}
+
+SearchServer::TermPositions::TermPositions(TermPositions&& other, const allocator_type& allocator)
+    : data(move(other.data), allocator)
+    , offsets(move(other.offsets), allocator)
+    , garbage(other.garbage) {
+}
+
+SearchServer::MemoryResources::MemoryResources(pmr::memory_resource* upstream)
+    : dictionary(upstream)
+    , postings(upstream)
+    , positions(upstream)
+    , fuzzy_index(upstream)
+    , forward_index(upstream)
+    , metadata(upstream)
+    , filters(upstream) {
 }
 
 void SearchServer::AddDocument(int document_id, const string_view& document, DocumentStatus status,
-                    const vector<int>& ratings) {
+                    const vector<int>& ratings, const DocumentAttributes& attributes) {
     if(document_id < 0) {
         throw invalid_argument("Document id should not be less than 0");
     }
-    if(document_ids.count(document_id) != 0) {
+    if(id_to_ordinal_.count(document_id) != 0) {
         throw invalid_argument("Document with the same id already exists");
     }
     if(!IsValidWord(document)) {
         throw invalid_argument("Document contains invalid characters");
     }
-    const vector<string> words = SplitIntoWordsNoStop(document);
-    const double inv_word_count = 1.0 / words.size();
-    document_ids.insert(document_id);
-    for (const string& word : words) {
-        word_to_document_freqs_[word][document_id] += inv_word_count;
-        id_to_word_freqs_[document_id][word] += inv_word_count;
+    // (field, key) pairs, resolved before the index changes
+    vector<pair<size_t, int64_t>> attribute_keys;
+    for(const auto& [name, value] : attributes) {
+        const size_t field = GetAttributeField(name);
+        if(options_.attributes[field].type == AttributeType::INTEGER && value.GetType() != AttributeType::INTEGER) {
+            throw invalid_argument("Attribute "s + name + " must be an integer"s);
+        }
+        attribute_keys.push_back({field, value.ToKey(options_.attributes[field].type, true)});
+    }
+    struct WordOccurrences {
+        uint32_t count = 0;
+        vector<uint32_t> positions;
+    };
+    // Positions count every word of the document, stop words included
+    const vector<string_view> words = SplitIntoWords(document);
+    map<string_view, WordOccurrences> word_occurrences;
+    uint32_t word_count = 0;
+    for (uint32_t position = 0; position < words.size(); ++position) {
+        if (IsStopWord(words[position])) {
+            continue;
+        }
+        WordOccurrences& occurrences = word_occurrences[words[position]];
+        ++occurrences.count;
+        if (options_.store_positions) {
+            occurrences.positions.push_back(position);
+        }
+        ++word_count;
+    }
+
+    const uint32_t ordinal = static_cast<uint32_t>(document_ids_.size());
+    const int rating = ComputeAverageRating(ratings);
+    id_to_ordinal_[document_id] = ordinal;
+    document_ids_.push_back(document_id);
+    ratings_.push_back(rating);
+    statuses_.push_back(status);
+    document_terms_.push_back({forward_index_.size(), static_cast<uint32_t>(word_occurrences.size()), word_count});
+    inv_word_counts_.push_back(1.0 / word_count);
+    total_word_count_ += word_count;
+    for (const auto& [word, occurrences] : word_occurrences) {
+        const uint32_t term_id = GetOrAddTermId(word);
+        if (options_.store_positions) {
+            TermPositions& positions = term_positions_[term_id];
+            positions.offsets.push_back(static_cast<uint32_t>(positions.data.size()));
+            EncodePositions(occurrences.positions, positions.data);
+        }
+        term_postings_[term_id].Append(ordinal, occurrences.count);
+        forward_index_.push_back({term_id, occurrences.count});
+    }
+    status_to_documents_[static_cast<size_t>(status)].Add(ordinal);
+    rating_to_documents_[rating].Add(ordinal);
+    for(const auto& [field, key] : attribute_keys) {
+        attribute_indexes_[field].Add(ordinal, key);
     }
-    documents_[document_id] = DocumentData{ComputeAverageRating(ratings), status};
 }
 
 vector<Document> SearchServer::FindTopDocuments(const string_view& raw_query, DocumentStatus status) const {
     //LOG_DURATION_STREAM("Operation time"s, std::cout);
-    return FindTopDocuments(
-        raw_query, [status]([[maybe_unused]] int document_id, DocumentStatus document_status, [[maybe_unused]] int rating) {
-            return document_status == status;
-        });
+    return FindTopDocuments(raw_query, DocumentFilter(status));
+}
+
+vector<Document> SearchServer::FindTopDocuments(const string_view& raw_query, const DocumentFilter& filter) const {
+    return FindTopDocuments(AutomaticExecution(), raw_query, filter);
+}
+
+vector<Document> SearchServer::FindTopDocuments(const string_view& raw_query, const PageCursor& after, size_t page_size,
+                                               const DocumentFilter& filter) const {
+    return FindTopFilteredDocuments(AutomaticExecution(), raw_query, filter, after, page_size);
+}
+
+LazyPaginator<Document> PaginateTopDocuments(const SearchServer& search_server, const string_view& raw_query, size_t page_size,
+                                             const DocumentFilter& filter) {
+    return LazyPaginator<Document>([&search_server, query = string(raw_query), page_size, filter](const vector<Document>& previous_page) {
+        const PageCursor after = previous_page.empty() ? PageCursor() : PageCursor(previous_page.back());
+        return search_server.FindTopDocuments(query, after, page_size, filter);
+    });
+}
+
+vector<Document> SearchServer::FindTopDocuments(const string_view& raw_query, const DocumentFilter& filter,
+                                               const TermStatistics& statistics) const {
+    return FindTopFilteredDocuments(AutomaticExecution(), raw_query, filter, PageCursor(), MAX_RESULT_DOCUMENT_COUNT, &statistics);
+}
+
+SearchResult SearchServer::Search(const string_view& raw_query, const SearchOptions& options) const {
+    return Search(AutomaticExecution(), raw_query, options);
 }
 
 int SearchServer::GetDocumentCount() const {
-    return document_ids.size();
+    return static_cast<int>(id_to_ordinal_.size());
+}
+
+MemoryStats SearchServer::GetMemoryStats() const {
+    MemoryStats stats;
+    stats.dictionary = memory_->dictionary.GetUsage();
+    stats.postings = memory_->postings.GetUsage();
+    stats.positions = memory_->positions.GetUsage();
+    stats.fuzzy_index = memory_->fuzzy_index.GetUsage();
+    stats.forward_index = memory_->forward_index.GetUsage();
+    stats.metadata = memory_->metadata.GetUsage();
+    stats.filters = memory_->filters.GetUsage();
+    return stats;
+}
+
+QueryPlan SearchServer::Explain(const string_view& raw_query) const {
+    return BuildQueryPlan(ParseQuery(raw_query));
 }
 
 tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(const string_view& raw_query, int document_id) const {
-    if(document_ids.find(document_id) == document_ids.end()) {
-        throw out_of_range("Document with id "s + to_string(document_id) + " doesn't exist"s);
-    }
+    const uint32_t ordinal = GetOrdinal(document_id);
     const Query query = ParseQuery(raw_query);
     vector<string_view> matched_words;
     
     for (const string_view& word : query.minus_words) {
-        if (word_to_document_freqs_.count(std::string(word)) && word_to_document_freqs_.at(std::string(word)).count(document_id)) {
-            return {matched_words, documents_.at(document_id).status};
+        const auto* postings = FindPostings(word);
+        if (postings && postings->Contains(ordinal)) {
+            return {matched_words, statuses_[ordinal]};
+        }
+    }
+    
+    for (const string_view& prefix : query.minus_prefixes) {
+        for (const uint32_t term_id : ExpandPrefix(prefix, options_.max_prefix_expansions)) {
+            if (term_postings_[term_id].Contains(ordinal)) {
+                return {matched_words, statuses_[ordinal]};
+            }
+        }
+    }
+    for (const Phrase& phrase : query.phrases) {
+        if (!ContainsPhrase(phrase, ordinal)) {
+            return {matched_words, statuses_[ordinal]};
         }
     }
     
     for (const string_view& word : query.plus_words) {
-        if (word_to_document_freqs_.count(std::string(word)) && word_to_document_freqs_.at(std::string(word)).count(document_id)) {
+        const auto* postings = FindPostings(word);
+        if (postings && postings->Contains(ordinal)) {
             matched_words.push_back(word);
         }
     }
+    AddExpandedMatches(query, ordinal, matched_words);
+    sort(matched_words.begin(), matched_words.end());
+    matched_words.erase(unique(matched_words.begin(), matched_words.end()), matched_words.end());
 
-    return {matched_words, documents_.at(document_id).status};
+    return {matched_words, statuses_[ordinal]};
 }
 
-const set<int>::const_iterator SearchServer::begin() const {
-    return document_ids.begin();
+SearchServer::DocumentIdIterator SearchServer::begin() const {
+    return DocumentIdIterator(id_to_ordinal_.begin());
 }
 
-const set<int>::const_iterator SearchServer::end() const {
-    return document_ids.end();
+SearchServer::DocumentIdIterator SearchServer::end() const {
+    return DocumentIdIterator(id_to_ordinal_.end());
 }
 
-const map<string, double>& SearchServer::GetWordFrequencies(int document_id) const {
-    if(document_ids.find(document_id) == document_ids.end()) {
-        static map<string, double> empty;
-        return empty;
+WordFrequencies SearchServer::GetWordFrequencies(int document_id) const {
+    const auto it = id_to_ordinal_.find(document_id);
+    if(it == id_to_ordinal_.end()) {
+        return {};
     }
-    return id_to_word_freqs_.at(document_id);
+    const DocumentTerms& record = document_terms_[it->second];
+    const TermFrequency* first = forward_index_.data() + record.offset;
+    return {first, first + record.size, terms_.data(), 1.0 / record.word_count};
 }
 
 void SearchServer::RemoveDocument(int document_id) {
-    document_ids.erase(document_id);
-    documents_.erase(document_id);
+    const uint32_t ordinal = GetOrdinal(document_id);
+    RemoveDocumentData(document_id, ordinal);
     
-    for(auto [word, _]: id_to_word_freqs_.at(document_id)) {
-        word_to_document_freqs_.at(word).erase(document_id);
+    const DocumentTerms& record = document_terms_[ordinal];
+    for(size_t i = record.offset; i < record.offset + record.size; ++i) {
+        ErasePosting(forward_index_[i].term_id, ordinal);
     }
-    id_to_word_freqs_.erase(document_id);
+    ReleaseDocumentTerms(ordinal);
+    ReclaimOrdinals();
 }
 
 bool SearchServer::IsStopWord(const string_view& word) const {
-    return stop_words_.count(word) > 0;
-}
-
-vector<string> SearchServer::SplitIntoWordsNoStop(const string_view& text) const {
-    vector<string> words;
-    for (const string_view& word : SplitIntoWords(text)) {
-        if (!IsStopWord(word)) {
-            words.push_back(string(word));
-        }
-    }
-    return words;
+    return stop_words_.Contains(word);
 }
 
 int SearchServer::ComputeAverageRating(const vector<int>& ratings) {
@@ -135,7 +258,12 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(string_view text) const {
             throw invalid_argument("Query minus word '"s + std::string(text) + "' contains two minuses"s);
         }
     }
-    return {text, is_minus, IsStopWord(text)};
+    // A lone "*" has no prefix to expand and stays an ordinary word
+    if (text.size() > 1 && text.back() == '*') {
+        text.remove_suffix(1);
+        return {text, is_minus, false, true};
+    }
+    return {text, is_minus, IsStopWord(text), false};
 }
 
 bool SearchServer::IsValidWord(const string_view& word) {
@@ -146,27 +274,713 @@ bool SearchServer::IsValidWord(const string_view& word) {
 
 SearchServer::Query SearchServer::ParseQuery(const string_view& text, bool seq) const {
     Query query;
-    for (const string_view& word : SplitIntoWords(text)) {
-        const QueryWord query_word = ParseQueryWord(word);
-        if (!query_word.is_stop) {
-            if (query_word.is_minus) {
-                query.minus_words.push_back(query_word.data);
-            } else {
-                query.plus_words.push_back(query_word.data);
+    optional<Phrase> phrase;
+    uint32_t phrase_offset = 0;
+    for (string_view word : SplitIntoWords(text)) {
+        if (!phrase && word[0] == '"') {
+            phrase.emplace();
+            phrase_offset = 0;
+            word.remove_prefix(1);
+        }
+        const bool closes_phrase = phrase && !word.empty() && word.back() == '"';
+        if (closes_phrase) {
+            word.remove_suffix(1);
+        }
+        if (!word.empty()) {
+            const QueryWord query_word = ParseQueryWord(word);
+            if (phrase && query_word.is_minus) {
+                throw invalid_argument("Phrase contains minus word '"s + std::string(word) + "'"s);
+            }
+            if (phrase && query_word.is_prefix) {
+                throw invalid_argument("Phrase contains prefix '"s + std::string(word) + "'"s);
+            }
+            if (query_word.is_prefix) {
+                (query_word.is_minus ? query.minus_prefixes : query.plus_prefixes).push_back(query_word.data);
+            } else if (!query_word.is_stop) {
+                if (query_word.is_minus) {
+                    query.minus_words.push_back(query_word.data);
+                } else {
+                    query.plus_words.push_back(query_word.data);
+                }
+                if (phrase) {
+                    phrase->words.push_back(query_word.data);
+                    phrase->offsets.push_back(phrase_offset);
+                }
+            }
+            ++phrase_offset;
+        }
+        if (closes_phrase) {
+            // A phrase of one word is an ordinary plus word
+            if (phrase->words.size() > 1) {
+                query.phrases.push_back(move(*phrase));
             }
+            phrase.reset();
         }
     }
+    if (phrase) {
+        throw invalid_argument("Query phrase is not closed with a quote");
+    }
+    if (!query.phrases.empty() && !options_.store_positions) {
+        throw invalid_argument("Phrase queries require an index with positions");
+    }
     if(seq) {
-        sort(query.minus_words.begin(), query.minus_words.end());
-        query.minus_words.erase(unique(query.minus_words.begin(), query.minus_words.end()),
-                                query.minus_words.end());
-        sort(query.plus_words.begin(), query.plus_words.end());
-        query.plus_words.erase(unique(query.plus_words.begin(), query.plus_words.end()),
-                                query.plus_words.end());
+        for (vector<string_view>* words : {&query.plus_words, &query.minus_words, &query.plus_prefixes, &query.minus_prefixes}) {
+            sort(words->begin(), words->end());
+            words->erase(unique(words->begin(), words->end()), words->end());
+        }
     }
     return query;
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(const string& word) const {
-    return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+double SearchServer::ComputeWordInverseDocumentFreq(size_t document_freq, size_t document_count) {
+    return log(document_count * 1.0 / document_freq);
+}
+
+const PostingList* SearchServer::FindPostings(string_view word) const {
+    const auto it = term_ids_.find(word);
+    if(it == term_ids_.end() || term_postings_[it->second].Empty()) {
+        return nullptr;
+    }
+    return &term_postings_[it->second];
+}
+
+bool SearchServer::IsPrefetched(const PostingList& postings) const {
+    return document_ids_.size() >= options_.prefetch_min_documents && postings.Size() * SPARSE_LIST_GAP < document_ids_.size();
+}
+
+void SearchServer::ErasePosting(uint32_t term_id, uint32_t ordinal) {
+    PostingList& postings = term_postings_[term_id];
+    const size_t index = postings.Find(ordinal);
+    if(index == postings.Size()) {
+        return;
+    }
+    if(options_.store_positions) {
+        TermPositions& positions = term_positions_[term_id];
+        const auto offset = positions.offsets.begin() + index;
+        const uint8_t* first = positions.data.data() + *offset;
+        positions.garbage += SkipPositions(first) - first;
+        positions.offsets.erase(offset);
+    }
+    postings.Erase(index);
+    if(options_.store_positions && term_positions_[term_id].garbage * 2 > term_positions_[term_id].data.size()) {
+        CompactPositions(term_id);
+    }
+}
+
+void SearchServer::ErasePostings(uint32_t term_id, const pair<uint32_t, uint32_t>* first,
+                                 const pair<uint32_t, uint32_t>* last) {
+    PostingList& postings = term_postings_[term_id];
+    TermPositions* positions = options_.store_positions ? &term_positions_[term_id] : nullptr;
+    size_t kept = 0;
+    postings.EraseIf([&](size_t i) {
+        const uint32_t ordinal = postings.Ordinals()[i];
+        while(first != last && first->second < ordinal) {
+            ++first;
+        }
+        if(first != last && first->second == ordinal) {
+            if(positions) {
+                const uint8_t* data = positions->data.data() + positions->offsets[i];
+                positions->garbage += SkipPositions(data) - data;
+            }
+            return true;
+        }
+        if(positions) {
+            positions->offsets[kept] = positions->offsets[i];
+        }
+        ++kept;
+        return false;
+    });
+    if(positions) {
+        positions->offsets.resize(kept);
+    }
+    if(positions && positions->garbage * 2 > positions->data.size()) {
+        CompactPositions(term_id);
+    }
+}
+
+void SearchServer::CompactPositions(uint32_t term_id) {
+    TermPositions& positions = term_positions_[term_id];
+    pmr::vector<uint8_t> compacted(positions.data.get_allocator());
+    compacted.reserve(positions.data.size() - positions.garbage);
+    for(uint32_t& offset : positions.offsets) {
+        const uint8_t* first = positions.data.data() + offset;
+        offset = static_cast<uint32_t>(compacted.size());
+        compacted.insert(compacted.end(), first, SkipPositions(first));
+    }
+    positions.data = move(compacted);
+    positions.garbage = 0;
+}
+
+void SearchServer::GetPositions(string_view word, size_t index, vector<uint32_t>& positions) const {
+    const TermPositions& term_positions = term_positions_[term_ids_.find(word)->second];
+    DecodePositions(term_positions.data.data() + term_positions.offsets[index], positions);
+}
+
+bool SearchServer::ContainsPhrase(const Phrase& phrase, uint32_t ordinal) const {
+    vector<vector<uint32_t>> positions(phrase.words.size());
+    for(size_t i = 0; i < phrase.words.size(); ++i) {
+        const PostingList* postings = FindPostings(phrase.words[i]);
+        if(!postings) {
+            return false;
+        }
+        const size_t index = postings->Find(ordinal);
+        if(index == postings->Size()) {
+            return false;
+        }
+        GetPositions(phrase.words[i], index, positions[i]);
+    }
+    return HasPhraseOccurrence(positions, phrase.offsets);
+}
+
+vector<uint32_t> SearchServer::FindPhraseDocuments(const Phrase& phrase) const {
+    vector<const PostingList*> postings;
+    for(const string_view word : phrase.words) {
+        postings.push_back(FindPostings(word));
+        if(!postings.back()) {
+            return {};
+        }
+    }
+    // Documents of the shortest posting list are searched for in the others by galloping
+    const size_t pivot = min_element(postings.begin(), postings.end(), [](const PostingList* lhs, const PostingList* rhs) {
+        return lhs->Size() < rhs->Size();
+    }) - postings.begin();
+    vector<const uint32_t*> cursors;
+    for(const PostingList* list : postings) {
+        cursors.push_back(list->Ordinals());
+    }
+
+    vector<uint32_t> result;
+    vector<vector<uint32_t>> positions(phrase.words.size());
+    const uint32_t* pivot_ordinals = postings[pivot]->Ordinals();
+    for(size_t pivot_index = 0, pivot_count = postings[pivot]->Size(); pivot_index < pivot_count; ++pivot_index) {
+        const uint32_t ordinal = pivot_ordinals[pivot_index];
+        bool in_all_lists = true;
+        for(size_t i = 0; i < postings.size(); ++i) {
+            if(i == pivot) {
+                continue;
+            }
+            const uint32_t* end = postings[i]->Ordinals() + postings[i]->Size();
+            cursors[i] = GallopLowerBound(cursors[i], end, ordinal);
+            if(cursors[i] == end) {
+                return result;
+            }
+            if(*cursors[i] != ordinal) {
+                in_all_lists = false;
+                break;
+            }
+        }
+        if(!in_all_lists) {
+            continue;
+        }
+        for(size_t i = 0; i < postings.size(); ++i) {
+            GetPositions(phrase.words[i], i == pivot ? pivot_index : cursors[i] - postings[i]->Ordinals(), positions[i]);
+        }
+        if(HasPhraseOccurrence(positions, phrase.offsets)) {
+            result.push_back(ordinal);
+        }
+    }
+    return result;
+}
+
+vector<uint32_t> SearchServer::ExpandPrefix(string_view prefix, size_t max_expansions) const {
+    vector<uint32_t> term_ids;
+    for(auto it = term_ids_.lower_bound(prefix);
+        it != term_ids_.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+        if(!term_postings_[it->second].Empty()) {
+            term_ids.push_back(it->second);
+        }
+    }
+    // Too wide prefixes keep the most frequent words
+    if(term_ids.size() > max_expansions) {
+        const auto by_preference = [this](uint32_t lhs, uint32_t rhs) {
+            return IsPreferredExpansion({terms_[lhs], term_postings_[lhs].Size(), 0}, {terms_[rhs], term_postings_[rhs].Size(), 0});
+        };
+        nth_element(term_ids.begin(), term_ids.begin() + max_expansions, term_ids.end(), by_preference);
+        term_ids.resize(max_expansions);
+    }
+    return term_ids;
+}
+
+QueryPlan SearchServer::BuildQueryPlan(const Query& query) const {
+    QueryPlan plan;
+    const auto add_group = [&](vector<QueryPlan::Group>& groups, string_view query_word, QueryPlan::Group::Kind kind) {
+        QueryPlan::Group group{query_word, kind, {}, 0};
+        if(kind == QueryPlan::Group::Kind::PREFIX) {
+            for(const uint32_t term_id : ExpandPrefix(query_word, options_.max_prefix_expansions)) {
+                group.terms.push_back({terms_[term_id], term_postings_[term_id].Size(), 0});
+            }
+        } else if(const PostingList* postings = FindPostings(query_word); postings && !postings->Empty()) {
+            group.terms.push_back({query_word, postings->Size(), 0});
+        }
+        if(kind == QueryPlan::Group::Kind::FUZZY) {
+            for(const auto& [term_id, distance] : ExpandFuzzy(query_word, options_.max_fuzzy_expansions)) {
+                group.terms.push_back({terms_[term_id], term_postings_[term_id].Size(), distance});
+            }
+        }
+        if(group.terms.empty()) {
+            plan.skipped_words.push_back(query_word);
+            return;
+        }
+        for(const QueryPlan::Term& term : group.terms) {
+            group.cost += term.document_count;
+        }
+        groups.push_back(move(group));
+    };
+    const auto total_cost = [](const vector<QueryPlan::Group>& groups) {
+        size_t cost = 0;
+        for(const QueryPlan::Group& group : groups) {
+            cost += group.cost;
+        }
+        return cost;
+    };
+
+    using Kind = QueryPlan::Group::Kind;
+    for(const string_view word : query.plus_words) {
+        add_group(plan.plus_groups, word, options_.max_edit_distance > 0 ? Kind::FUZZY : Kind::WORD);
+    }
+    for(const string_view prefix : query.plus_prefixes) {
+        add_group(plan.plus_groups, prefix, Kind::PREFIX);
+    }
+    for(const string_view word : query.minus_words) {
+        add_group(plan.minus_groups, word, Kind::WORD);
+    }
+    for(const string_view prefix : query.minus_prefixes) {
+        add_group(plan.minus_groups, prefix, Kind::PREFIX);
+    }
+    // Short lists go first: they are cheap and fill the accumulator with fewer rehashes
+    const auto by_cost = [](const QueryPlan::Group& lhs, const QueryPlan::Group& rhs) {
+        return lhs.cost < rhs.cost;
+    };
+    stable_sort(plan.plus_groups.begin(), plan.plus_groups.end(), by_cost);
+    stable_sort(plan.minus_groups.begin(), plan.minus_groups.end(), by_cost);
+
+    const size_t plus_cost = total_cost(plan.plus_groups);
+    const size_t minus_cost = total_cost(plan.minus_groups);
+    plan.estimated_cost = plus_cost;
+    if(plus_cost != 0 && minus_cost != 0) {
+        // Collecting minus documents pays off unless they outnumber the scored postings
+        if(minus_cost <= plus_cost) {
+            plan.exclusion = QueryPlan::Exclusion::BITMAP;
+            plan.estimated_cost += minus_cost;
+        } else {
+            plan.exclusion = QueryPlan::Exclusion::PROBE;
+        }
+    }
+    plan.parallel = plan.plus_groups.size() > 1 && plan.estimated_cost >= options_.parallel_query_cost;
+    plan.document_count = id_to_ordinal_.size();
+    return plan;
+}
+
+pair<SearchServer::Query, QueryPlan> SearchServer::PlanQuery(string_view raw_query, const TermStatistics* statistics) const {
+    pair<Query, QueryPlan> planned;
+    planned.first = ParseQuery(raw_query);
+    planned.second = BuildQueryPlan(planned.first);
+    if (statistics) {
+        ApplyTermStatistics(*statistics, planned.second);
+    }
+    return planned;
+}
+
+void SearchServer::ApplyTermStatistics(const TermStatistics& statistics, QueryPlan& plan) const {
+    plan.document_count = statistics.document_count;
+    const auto apply = [&](vector<QueryPlan::Group>& groups) {
+        for(QueryPlan::Group& group : groups) {
+            const TermStatistics::Expansions* expansions = nullptr;
+            if(group.kind == QueryPlan::Group::Kind::PREFIX) {
+                expansions = &statistics.prefix_expansions;
+            } else if(group.kind == QueryPlan::Group::Kind::FUZZY) {
+                expansions = &statistics.fuzzy_expansions;
+            }
+            if(expansions) {
+                // The exact word of a fuzzy group stays, misspelled and prefixed words are the chosen ones
+                // that have documents in this part of the collection
+                group.terms.erase(remove_if(group.terms.begin(), group.terms.end(), [&](const QueryPlan::Term& term) {
+                    return group.kind == QueryPlan::Group::Kind::PREFIX || term.distance > 0;
+                }), group.terms.end());
+                if(const auto it = expansions->find(group.query_word); it != expansions->end()) {
+                    for(const auto& [word, distance] : it->second) {
+                        if(const PostingList* postings = FindPostings(word); postings && !postings->Empty()) {
+                            group.terms.push_back({word, postings->Size(), distance});
+                        }
+                    }
+                }
+            }
+            group.cost = 0;
+            for(QueryPlan::Term& term : group.terms) {
+                if(const auto it = statistics.document_freqs.find(term.word); it != statistics.document_freqs.end()) {
+                    term.document_count = it->second;
+                }
+                group.cost += term.document_count;
+            }
+        }
+        groups.erase(remove_if(groups.begin(), groups.end(), [](const QueryPlan::Group& group) {
+            return group.terms.empty();
+        }), groups.end());
+        // Same order as on a single server, so relevances are summed in the same order
+        stable_sort(groups.begin(), groups.end(), [](const QueryPlan::Group& lhs, const QueryPlan::Group& rhs) {
+            return lhs.cost < rhs.cost;
+        });
+    };
+    apply(plan.plus_groups);
+    apply(plan.minus_groups);
+}
+
+TermStatistics SearchServer::GetTermStatistics(const string_view& raw_query) const {
+    const Query query = ParseQuery(raw_query);
+    TermStatistics statistics;
+    statistics.document_count = id_to_ordinal_.size();
+    const auto add_expansion = [&](map<string, int, less<>>& expansions, uint32_t term_id, int distance) {
+        expansions.emplace(terms_[term_id], distance);
+        statistics.document_freqs[string(terms_[term_id])] = term_postings_[term_id].Size();
+    };
+    for(const string_view word : query.plus_words) {
+        if(const PostingList* postings = FindPostings(word); postings && !postings->Empty()) {
+            statistics.document_freqs[string(word)] = postings->Size();
+        }
+        if(options_.max_edit_distance > 0) {
+            map<string, int, less<>>& expansions = statistics.fuzzy_expansions[string(word)];
+            for(const auto& [term_id, distance] : ExpandFuzzy(word, numeric_limits<size_t>::max())) {
+                add_expansion(expansions, term_id, distance);
+            }
+        }
+    }
+    // Minus prefixes are capped too, so their expansions have to be the same on every part
+    for(const vector<string_view>* prefixes : {&query.plus_prefixes, &query.minus_prefixes}) {
+        for(const string_view prefix : *prefixes) {
+            map<string, int, less<>>& expansions = statistics.prefix_expansions[string(prefix)];
+            for(const uint32_t term_id : ExpandPrefix(prefix, numeric_limits<size_t>::max())) {
+                add_expansion(expansions, term_id, 0);
+            }
+        }
+    }
+    return statistics;
+}
+
+vector<pair<uint32_t, int>> SearchServer::ExpandFuzzy(string_view word, size_t max_expansions) const {
+    vector<pair<uint32_t, int>> expansions;
+    const LevenshteinAutomaton automaton(word, options_.max_edit_distance);
+    for(const uint32_t term_id : trigram_index_.FindCandidates(word, options_.max_edit_distance)) {
+        if(term_postings_[term_id].Empty() || terms_[term_id] == word) {
+            continue;
+        }
+        const int distance = automaton.Distance(terms_[term_id]);
+        if(distance <= options_.max_edit_distance) {
+            expansions.push_back({term_id, distance});
+        }
+    }
+    if(expansions.size() > max_expansions) {
+        const auto by_preference = [this](const pair<uint32_t, int>& lhs, const pair<uint32_t, int>& rhs) {
+            return IsPreferredExpansion({terms_[lhs.first], term_postings_[lhs.first].Size(), lhs.second},
+                                        {terms_[rhs.first], term_postings_[rhs.first].Size(), rhs.second});
+        };
+        nth_element(expansions.begin(), expansions.begin() + max_expansions, expansions.end(), by_preference);
+        expansions.resize(max_expansions);
+    }
+    return expansions;
+}
+
+double SearchServer::GetFuzzyWeight(int distance) const {
+    return distance == 0 ? 1.0 : pow(options_.fuzzy_penalty, distance);
+}
+
+void SearchServer::AddExpandedMatches(const Query& query, uint32_t ordinal, vector<string_view>& matched_words) const {
+    for(const string_view prefix : query.plus_prefixes) {
+        for(const uint32_t term_id : ExpandPrefix(prefix, options_.max_prefix_expansions)) {
+            if(term_postings_[term_id].Contains(ordinal)) {
+                matched_words.push_back(terms_[term_id]);
+            }
+        }
+    }
+    if(options_.max_edit_distance > 0) {
+        for(const string_view word : query.plus_words) {
+            for(const auto& [term_id, distance] : ExpandFuzzy(word, options_.max_fuzzy_expansions)) {
+                if(term_postings_[term_id].Contains(ordinal)) {
+                    matched_words.push_back(terms_[term_id]);
+                }
+            }
+        }
+    }
+}
+
+double SearchServer::ComputeProximityBoost(const vector<string_view>& words, uint32_t ordinal) const {
+    vector<vector<uint32_t>> positions;
+    for(const string_view word : words) {
+        const PostingList* postings = FindPostings(word);
+        if(!postings) {
+            continue;
+        }
+        const size_t index = postings->Find(ordinal);
+        if(index != postings->Size()) {
+            positions.emplace_back();
+            GetPositions(word, index, positions.back());
+        }
+    }
+    const uint32_t distance = ComputeMinTermDistance(positions);
+    return distance == 0 ? 0.0 : options_.proximity_weight / distance;
+}
+
+uint32_t SearchServer::GetOrAddTermId(string_view word) {
+    const auto it = term_ids_.lower_bound(word);
+    if(it != term_ids_.end() && it->first == word) {
+        return it->second;
+    }
+    if(!free_term_ids_.empty()) {
+        const uint32_t term_id = free_term_ids_.back();
+        free_term_ids_.pop_back();
+        terms_[term_id] = term_ids_.emplace_hint(it, word, term_id)->first;
+        if(options_.max_edit_distance > 0) {
+            trigram_index_.Add(term_id, word);
+        }
+        return term_id;
+    }
+    const uint32_t term_id = static_cast<uint32_t>(terms_.size());
+    const auto inserted = term_ids_.emplace_hint(it, word, term_id);
+    terms_.push_back(inserted->first);
+    term_postings_.emplace_back();
+    if(options_.store_positions) {
+        term_positions_.emplace_back();
+    }
+    if(options_.max_edit_distance > 0) {
+        trigram_index_.Add(term_id, word);
+    }
+    return term_id;
+}
+
+VacuumReport SearchServer::Vacuum(chrono::microseconds budget) {
+    const auto deadline = chrono::steady_clock::now() + budget;
+    // The clock is checked once per batch, so every call makes some progress
+    const uint32_t batch_size = 32;
+    VacuumReport report;
+    while(!terms_.empty()) {
+        const uint32_t batch_end = min<uint32_t>(vacuum_cursor_ + batch_size, static_cast<uint32_t>(terms_.size()));
+        for(; vacuum_cursor_ < batch_end; ++vacuum_cursor_) {
+            report.bytes_reclaimed += VacuumTerm(vacuum_cursor_, report);
+        }
+        if(vacuum_cursor_ == terms_.size()) {
+            vacuum_cursor_ = 0;
+            report.pass_completed = true;
+            break;
+        }
+        if(chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+    }
+    return report;
+}
+
+size_t SearchServer::VacuumTerm(uint32_t term_id, VacuumReport& report) {
+    PostingList& postings = term_postings_[term_id];
+    // Already removed word
+    if(terms_[term_id].empty()) {
+        return 0;
+    }
+    size_t reclaimed = 0;
+    if(postings.Empty()) {
+        reclaimed += postings.GetAllocatedBytes();
+        if(options_.max_edit_distance > 0) {
+            trigram_index_.Remove(term_id, terms_[term_id]);
+        }
+        // The dictionary node and the buffer of its key, whatever their layout in the standard library
+        const size_t dictionary_bytes = memory_->dictionary.GetUsage().bytes;
+        term_ids_.erase(term_ids_.find(terms_[term_id]));
+        reclaimed += dictionary_bytes - memory_->dictionary.GetUsage().bytes;
+        terms_[term_id] = {};
+        postings.Clear();
+        postings.ShrinkToFit();
+        if(options_.store_positions) {
+            TermPositions& positions = term_positions_[term_id];
+            reclaimed += positions.data.capacity() + positions.offsets.capacity() * sizeof(uint32_t);
+            positions.data.clear();
+            positions.data.shrink_to_fit();
+            positions.offsets.clear();
+            positions.offsets.shrink_to_fit();
+            positions.garbage = 0;
+        }
+        free_term_ids_.push_back(term_id);
+        ++report.terms_removed;
+        return reclaimed;
+    }
+    if(options_.store_positions && term_positions_[term_id].garbage > 0) {
+        const size_t capacity = term_positions_[term_id].data.capacity();
+        CompactPositions(term_id);
+        reclaimed += capacity - term_positions_[term_id].data.capacity();
+    }
+    // Lists grown by appending keep up to a half of their capacity unused, only sparser ones are shrunk
+    if(postings.Capacity() > 2 * postings.Size()) {
+        const size_t allocated_bytes = postings.GetAllocatedBytes();
+        postings.ShrinkToFit();
+        reclaimed += allocated_bytes - postings.GetAllocatedBytes();
+        if(options_.store_positions) {
+            pmr::vector<uint32_t>& offsets = term_positions_[term_id].offsets;
+            reclaimed += (offsets.capacity() - offsets.size()) * sizeof(uint32_t);
+            offsets.shrink_to_fit();
+        }
+        ++report.posting_lists_shrunk;
+    }
+    return reclaimed;
+}
+
+uint32_t SearchServer::GetOrdinal(int document_id) const {
+    const auto it = id_to_ordinal_.find(document_id);
+    if(it == id_to_ordinal_.end()) {
+        throw out_of_range("Document with id "s + to_string(document_id) + " doesn't exist"s);
+    }
+    return it->second;
+}
+
+void SearchServer::ReleaseDocumentTerms(uint32_t ordinal) {
+    DocumentTerms& record = document_terms_[ordinal];
+    forward_index_garbage_ += record.size;
+    record = {0, 0, 0};
+    // Holes are reclaimed once they take more than a half of the buffer, so removal stays amortized O(1)
+    if(forward_index_garbage_ * 2 > forward_index_.size()) {
+        CompactForwardIndex();
+    }
+}
+
+void SearchServer::RemoveDocumentData(int document_id, uint32_t ordinal) {
+    total_word_count_ -= document_terms_[ordinal].word_count;
+    status_to_documents_[static_cast<size_t>(statuses_[ordinal])].Remove(ordinal);
+    const auto rating_it = rating_to_documents_.find(ratings_[ordinal]);
+    rating_it->second.Remove(ordinal);
+    if(rating_it->second.Empty()) {
+        rating_to_documents_.erase(rating_it);
+    }
+    for(AttributeIndex& index : attribute_indexes_) {
+        index.Remove(ordinal);
+    }
+    id_to_ordinal_.erase(document_id);
+}
+
+size_t SearchServer::GetAttributeField(string_view name) const {
+    for(size_t field = 0; field < options_.attributes.size(); ++field) {
+        if(options_.attributes[field].name == name) {
+            return field;
+        }
+    }
+    throw invalid_argument("Unknown attribute "s + string(name));
+}
+
+const Bitmap* SearchServer::SelectDocuments(const DocumentFilter& filter, Bitmap& selection) const {
+    const Bitmap* by_status = nullptr;
+    if(filter.HasStatusRestriction()) {
+        for(size_t status = 0; status < DOCUMENT_STATUS_COUNT; ++status) {
+            if(!filter.IsStatusAllowed(static_cast<DocumentStatus>(status))) {
+                continue;
+            }
+            if(!by_status) {
+                by_status = &status_to_documents_[status];
+            } else {
+                if(by_status != &selection) {
+                    selection = *by_status;
+                    by_status = &selection;
+                }
+                selection |= status_to_documents_[status];
+            }
+        }
+    }
+    if(!filter.HasRatingRestriction() && filter.GetAttributeRanges().empty()) {
+        return by_status;
+    }
+
+    vector<Bitmap> restrictions;
+    if(by_status == &selection) {
+        restrictions.push_back(move(selection));
+        by_status = nullptr;
+    }
+    if(filter.HasRatingRestriction()) {
+        Bitmap& by_rating = restrictions.emplace_back();
+        for(auto it = rating_to_documents_.lower_bound(filter.GetMinRating());
+            it != rating_to_documents_.end() && it->first <= filter.GetMaxRating(); ++it) {
+            by_rating |= it->second;
+        }
+    }
+    for(const AttributeRange& range : filter.GetAttributeRanges()) {
+        const AttributeIndex& index = attribute_indexes_[GetAttributeField(range.name)];
+        restrictions.push_back(index.Select(range.min.ToKey(index.GetType(), true), range.max.ToKey(index.GetType(), false)));
+    }
+    // The smallest set goes first, so that every intersection is at most as large
+    const auto smallest = min_element(restrictions.begin(), restrictions.end(), [](const Bitmap& lhs, const Bitmap& rhs) {
+        return lhs.Size() < rhs.Size();
+    });
+    selection = move(*smallest);
+    for(auto it = restrictions.begin(); it != restrictions.end(); ++it) {
+        if(it != smallest) {
+            selection &= *it;
+        }
+    }
+    if(by_status) {
+        selection &= *by_status;
+    }
+    return &selection;
+}
+
+void SearchServer::SelectForPlan(const DocumentFilter& filter, const QueryPlan& plan, Selection& selection) const {
+    selection.documents = SelectDocuments(filter, selection.built);
+    // Filling the bitset is a pass over all ordinals, while a query of this cost visits at least
+    // one posting per DENSE_ACCUMULATION_RATIO documents
+    if(selection.documents && plan.estimated_cost * DENSE_ACCUMULATION_RATIO >= document_ids_.size()) {
+        selection.bits = selection.documents->ToBitset(document_ids_.size());
+    }
+}
+
+void SearchServer::CompactForwardIndex() {
+    pmr::vector<TermFrequency> compacted(forward_index_.get_allocator());
+    compacted.reserve(forward_index_.size() - forward_index_garbage_);
+    for(const auto [_, ordinal] : id_to_ordinal_) {
+        DocumentTerms& record = document_terms_[ordinal];
+        const auto first = forward_index_.begin() + record.offset;
+        record.offset = compacted.size();
+        compacted.insert(compacted.end(), first, first + record.size);
+    }
+    forward_index_ = move(compacted);
+    forward_index_garbage_ = 0;
+}
+
+void SearchServer::ReclaimOrdinals() {
+    const size_t live_count = id_to_ordinal_.size();
+    if((document_ids_.size() - live_count) * 2 <= document_ids_.size()) {
+        return;
+    }
+    const uint32_t REMOVED = numeric_limits<uint32_t>::max();
+    vector<uint32_t> new_ordinals(document_ids_.size(), REMOVED);
+    for(const auto [_, ordinal] : id_to_ordinal_) {
+        new_ordinals[ordinal] = 0;
+    }
+    uint32_t next_ordinal = 0;
+    for(uint32_t ordinal = 0; ordinal < new_ordinals.size(); ++ordinal) {
+        if(new_ordinals[ordinal] == REMOVED) {
+            continue;
+        }
+        new_ordinals[ordinal] = next_ordinal;
+        document_ids_[next_ordinal] = document_ids_[ordinal];
+        ratings_[next_ordinal] = ratings_[ordinal];
+        statuses_[next_ordinal] = statuses_[ordinal];
+        inv_word_counts_[next_ordinal] = inv_word_counts_[ordinal];
+        document_terms_[next_ordinal] = document_terms_[ordinal];
+        ++next_ordinal;
+    }
+    document_ids_.resize(live_count);
+    ratings_.resize(live_count);
+    statuses_.resize(live_count);
+    inv_word_counts_.resize(live_count);
+    document_terms_.resize(live_count);
+
+    for(auto& [_, ordinal] : id_to_ordinal_) {
+        ordinal = new_ordinals[ordinal];
+    }
+    for(PostingList& postings : term_postings_) {
+        postings.Renumber(new_ordinals);
+    }
+    for(AttributeIndex& index : attribute_indexes_) {
+        index.Renumber(new_ordinals);
+    }
+    for(Bitmap& documents : status_to_documents_) {
+        documents = Bitmap(&memory_->filters);
+    }
+    rating_to_documents_.clear();
+    for(uint32_t ordinal = 0; ordinal < live_count; ++ordinal) {
+        status_to_documents_[static_cast<size_t>(statuses_[ordinal])].Add(ordinal);
+        rating_to_documents_[ratings_[ordinal]].Add(ordinal);
+    }
 }
\ No newline at end of file
@@ -5,31 +5,149 @@
 #include <tuple>
 #include <set>
 #include <map>
+#include <array>
+#include <iterator>
 #include <stdexcept>
 #include <algorithm>
-#include <deque>
 #include <execution>
+#include <chrono>
+#include <memory>
+#include <memory_resource>
+#include <numeric>
+#include <thread>
 
 #include "document.h"
 #include "string_processing.h"
 #include "log_duration.h"
 #include "concurrent_map.h"
-
-const float EPS = 1e-6;
+#include "word_frequencies.h"
+#include "bitmap.h"
+#include "document_filter.h"
+#include "positions.h"
+#include "query_plan.h"
+#include "fuzzy.h"
+#include "page_cursor.h"
+#include "paginator.h"
+#include "scoring.h"
+#include "stop_words.h"
+#include "term_statistics.h"
+#include "memory_stats.h"
+#include "attributes.h"
+#include "attribute_index.h"
+#include "posting_list.h"
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 
+struct IndexOptions {
+    // Keep positions of words, required for "quoted phrase" queries and the proximity boost
+    bool store_positions = false;
+    // Relevance bonus weight / d, where d is the smallest distance between two different query words
+    double proximity_weight = 0.0;
+    // Maximal number of dictionary words a "prefix*" query word is expanded to
+    size_t max_prefix_expansions = 64;
+    // Queries without an explicit execution policy run in parallel from this number of postings to visit
+    size_t parallel_query_cost = 100000;
+    // Plus words also match dictionary words within this number of edits, from 0 (exact matching only) to 2
+    int max_edit_distance = 0;
+    // Relevance of a fuzzy match is multiplied by fuzzy_penalty for every edit
+    double fuzzy_penalty = 0.5;
+    // Maximal number of misspelled dictionary words a plus word is expanded to
+    size_t max_fuzzy_expansions = 16;
+    // Upstream of all index structures, must outlive the server. Parallel removal and the shards
+    // of ShardedSearchServer allocate from several threads, a resource used there must be synchronized
+    std::pmr::memory_resource* memory_resource = std::pmr::get_default_resource();
+    // Numeric attributes documents may carry, each indexed for range filters of DocumentFilter
+    std::vector<AttributeField> attributes;
+    // From this number of documents the metadata columns outgrow the caches, and scoring loops prefetch
+    // the slots of the documents ahead in sparse posting lists
+    size_t prefetch_min_documents = size_t{1} << 22;
+};
+
+// What a call of SearchServer::Vacuum has reclaimed
+struct VacuumReport {
+    size_t terms_removed = 0;
+    size_t posting_lists_shrunk = 0;
+    // Freed capacity of posting and position buffers and memory of removed dictionary entries
+    size_t bytes_reclaimed = 0;
+    // The call has reached the end of the dictionary, so the next one starts a new pass
+    bool pass_completed = false;
+};
+
+// Parameters of SearchServer::Search
+struct SearchOptions {
+    DocumentFilter filter = DocumentFilter(DocumentStatus::ACTUAL);
+    // Results are the top_k documents ranked right after the cursor
+    PageCursor after;
+    size_t top_k = MAX_RESULT_DOCUMENT_COUNT;
+    // Count matches of every status, as if the filter accepted any status
+    bool count_statuses = false;
+    // Count matches by rating buckets of this width, as if the filter accepted any rating; 0 disables
+    int rating_bucket_width = 0;
+};
+
+// Results of SearchServer::Search. Counts cover all matches regardless of the cursor and top_k
+struct SearchResult {
+    std::vector<Document> documents;
+    // Documents matching the query and the filter
+    size_t total_hits = 0;
+    // Filled if SearchOptions::count_statuses is set
+    std::array<size_t, DOCUMENT_STATUS_COUNT> status_counts{};
+    // Lower bound of a bucket -> number of matches rated within [bound, bound + width)
+    std::map<int, size_t> rating_counts;
+};
+
 class SearchServer {
 public:
+    // Iterates ids of the stored documents in ascending order
+    class DocumentIdIterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const int*;
+        using reference = const int&;
+
+        explicit DocumentIdIterator(std::pmr::map<int, uint32_t>::const_iterator it)
+            : it_(it) {
+        }
+
+        reference operator*() const {
+            return it_->first;
+        }
+
+        DocumentIdIterator& operator++() {
+            ++it_;
+            return *this;
+        }
+
+        DocumentIdIterator& operator--() {
+            --it_;
+            return *this;
+        }
+
+        bool operator==(const DocumentIdIterator& other) const {
+            return it_ == other.it_;
+        }
+
+        bool operator!=(const DocumentIdIterator& other) const {
+            return it_ != other.it_;
+        }
+
+    private:
+        std::pmr::map<int, uint32_t>::const_iterator it_;
+    };
+
     template <typename StringContainer>
-    explicit SearchServer(const StringContainer& stop_words);
+    explicit SearchServer(const StringContainer& stop_words, const IndexOptions& options = IndexOptions());
 
-    explicit SearchServer(const std::string& stop_words_text);
+    explicit SearchServer(const std::string& stop_words_text, const IndexOptions& options = IndexOptions());
     
-    explicit SearchServer(const std::string_view& stop_words_text);
+    explicit SearchServer(const std::string_view& stop_words_text, const IndexOptions& options = IndexOptions());
 
+    // Throws invalid_argument for an attribute not declared in IndexOptions::attributes
+    // and for a REAL value of an INTEGER attribute
     void AddDocument(int document_id, const std::string_view& document, DocumentStatus status,
-                     const std::vector<int>& ratings);
+                     const std::vector<int>& ratings, const DocumentAttributes& attributes = DocumentAttributes());
 
     template <typename DocumentPredicate>
     std::vector<Document> FindTopDocuments(const std::string_view& raw_query, DocumentPredicate document_predicate) const;
@@ -42,47 +160,178 @@ public:
     template <typename ExecutionPolicy>
     std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const std::string_view& raw_query, DocumentStatus status = DocumentStatus::ACTUAL) const;
 
+    std::vector<Document> FindTopDocuments(const std::string_view& raw_query, const DocumentFilter& filter) const;
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const std::string_view& raw_query, const DocumentFilter& filter) const;
+
+    // Returns up to page_size documents ranked right after the cursor. PageCursor(result.back())
+    // continues with the next page, an empty result means there are no more documents
+    std::vector<Document> FindTopDocuments(const std::string_view& raw_query, const PageCursor& after, size_t page_size,
+                                           const DocumentFilter& filter = DocumentFilter(DocumentStatus::ACTUAL)) const;
+
+    // Search with the scorer, the filter and the order of the results fixed at compile time, see scoring.h.
+    // Runs sequentially. Queries with many postings accumulate into arrays over all documents, where AnyDocument
+    // and StatusIs filters leave the scoring loop without branches; rare words merge their hits instead
+    template <typename Scorer = TfIdfScorer, typename TieBreak = RatingWithinEps, typename Filter = StatusIs<DocumentStatus::ACTUAL>>
+    std::vector<Document> FindTopDocumentsWith(const std::string_view& raw_query, Filter filter = Filter()) const;
+
+    // Top documents together with the number of all matches and the facet counts, collected in the same
+    // scoring pass. Throws invalid_argument for a negative rating bucket width
+    SearchResult Search(const std::string_view& raw_query, const SearchOptions& options) const;
+
+    template <typename ExecutionPolicy>
+    SearchResult Search(ExecutionPolicy&& policy, const std::string_view& raw_query, const SearchOptions& options) const;
+
     int GetDocumentCount() const;
 
+    MemoryStats GetMemoryStats() const;
+
+    // Document frequencies of the plus words of the query and of all dictionary words its prefixes
+    // and misspelled words may expand to, ignoring the expansion caps
+    TermStatistics GetTermStatistics(const std::string_view& raw_query) const;
+
+    // FindTopDocuments with the word weights computed from statistics of the whole collection,
+    // which this server holds a part of. statistics must include GetTermStatistics(raw_query),
+    // its expansions limited by TermStatistics::LimitExpansions are used instead of the local ones
+    std::vector<Document> FindTopDocuments(const std::string_view& raw_query, const DocumentFilter& filter,
+                                           const TermStatistics& statistics) const;
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const std::string_view& raw_query, const DocumentFilter& filter,
+                                           const TermStatistics& statistics) const;
+
+    // Shows how the query would be evaluated by FindTopDocuments without an explicit execution policy.
+    // Query words of the plan refer to raw_query
+    QueryPlan Explain(const std::string_view& raw_query) const;
+
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::string_view& raw_query, int document_id) const;
     
     template <class ExecutionPolicy>
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(ExecutionPolicy policy, const std::string_view& raw_query, int document_id) const;
 
-    const std::set<int>::const_iterator begin() const;
-    const std::set<int>::const_iterator end() const;
+    DocumentIdIterator begin() const;
+    DocumentIdIterator end() const;
     
-    const std::map<std::string, double>& GetWordFrequencies(int document_id) const;
+    WordFrequencies GetWordFrequencies(int document_id) const;
     
     void RemoveDocument(int document_id);
     
     template <class ExecutionPolicy>
     void RemoveDocument(ExecutionPolicy&& policy, int document_id);
 
+    // Removes a batch of documents touching every affected posting list once.
+    // Accepts any container of ids; ids of missing documents are ignored
+    template <typename DocumentIds>
+    void RemoveDocuments(const DocumentIds& document_ids);
+
+    template <class ExecutionPolicy, typename DocumentIds>
+    void RemoveDocuments(ExecutionPolicy&& policy, const DocumentIds& document_ids);
+
+    // Incrementally drops words left without documents and releases unused capacity of posting
+    // and position lists. Works for about budget and continues from where the previous call stopped
+    VacuumReport Vacuum(std::chrono::microseconds budget);
+
 private:
-    struct DocumentData {
-        int rating;
-        DocumentStatus status;
-    };
     struct QueryWord {
         std::string_view data;
         bool is_minus;
         bool is_stop;
+        bool is_prefix;
+    };
+    // Words of a quoted phrase with their offsets from the first word, skipped stop words included
+    struct Phrase {
+        std::vector<std::string_view> words;
+        std::vector<uint32_t> offsets;
     };
     struct Query {
         std::vector<std::string_view> plus_words;
         std::vector<std::string_view> minus_words;
+        std::vector<Phrase> phrases;
+        std::vector<std::string_view> plus_prefixes;
+        std::vector<std::string_view> minus_prefixes;
+    };
+    // Location of the document record inside forward_index_
+    struct DocumentTerms {
+        size_t offset;
+        uint32_t size;
+        uint32_t word_count;
     };
+    // Encoded position lists of one term. offsets[i] is the start of the list of the i-th posting
+    struct TermPositions {
+        using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
 
-    const std::set<std::string, std::less<>> stop_words_;
-    std::map<std::string, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, std::map<std::string, double>> id_to_word_freqs_;
-    std::map<int, DocumentData> documents_;
-    std::set<int> document_ids;
+        std::pmr::vector<uint8_t> data;
+        std::pmr::vector<uint32_t> offsets;
+        size_t garbage = 0;
 
-    bool IsStopWord(const std::string_view& word) const;
+        explicit TermPositions(const allocator_type& allocator);
+        TermPositions(const TermPositions& other, const allocator_type& allocator);
+        TermPositions(TermPositions&& other, const allocator_type& allocator);
+        TermPositions(const TermPositions& other) = default;
+        TermPositions(TermPositions&& other) = default;
+        TermPositions& operator=(const TermPositions& other) = default;
+        TermPositions& operator=(TermPositions&& other) = default;
+    };
+    // Every group of structures allocates through its own counter, see GetMemoryStats().
+    // Held by pointer, so the containers keep valid resources when the server is moved
+    struct MemoryResources {
+        explicit MemoryResources(std::pmr::memory_resource* upstream);
+
+        CountingMemoryResource dictionary;
+        CountingMemoryResource postings;
+        CountingMemoryResource positions;
+        CountingMemoryResource fuzzy_index;
+        CountingMemoryResource forward_index;
+        CountingMemoryResource metadata;
+        CountingMemoryResource filters;
+    };
 
-    std::vector<std::string> SplitIntoWordsNoStop(const std::string_view& text) const;
+    const StopWords stop_words_;
+    const IndexOptions options_;
+    std::unique_ptr<MemoryResources> memory_;
+    // Term dictionary: word -> term id and term id -> word (views into the dictionary keys)
+    std::pmr::map<std::pmr::string, uint32_t, std::less<>> term_ids_;
+    std::pmr::vector<std::string_view> terms_;
+    // Ids of words removed by Vacuum, reused for new words
+    std::pmr::vector<uint32_t> free_term_ids_;
+    uint32_t vacuum_cursor_ = 0;
+    // Posting lists indexed by term id. Documents are referenced inside the index by internal ordinals
+    // assigned in order of addition, so posting lists stay sorted by simple appending.
+    // The term frequency is count * inv_word_counts_[ordinal], so a posting takes 8 bytes
+    std::pmr::vector<PostingList> term_postings_;
+    // Filled only if options_.store_positions is set
+    std::pmr::vector<TermPositions> term_positions_;
+    // Filled only if options_.max_edit_distance is positive
+    TrigramIndex trigram_index_;
+    // Records of all documents stored back to back, each sorted by word
+    std::pmr::vector<TermFrequency> forward_index_;
+    size_t forward_index_garbage_ = 0;
+    // Document metadata columns indexed by ordinal. Slots of removed documents stay unused
+    // until ReclaimOrdinals renumbers the live documents
+    std::pmr::vector<int> document_ids_;
+    std::pmr::vector<int> ratings_;
+    std::pmr::vector<DocumentStatus> statuses_;
+    std::pmr::vector<DocumentTerms> document_terms_;
+    std::pmr::vector<double> inv_word_counts_;
+    std::pmr::map<int, uint32_t> id_to_ordinal_;
+    // Sum of word counts of all documents, for the average document length
+    uint64_t total_word_count_ = 0;
+    // Metadata indexes used by DocumentFilter, keyed by ordinal
+    std::array<Bitmap, DOCUMENT_STATUS_COUNT> status_to_documents_;
+    std::pmr::map<int, Bitmap> rating_to_documents_;
+    // Indexed like options_.attributes
+    std::pmr::vector<AttributeIndex> attribute_indexes_;
+
+    // Postings ahead of the current one whose metadata and accumulators the scoring loops prefetch
+    static const size_t PREFETCH_DISTANCE = PostingList::BLOCK_SIZE;
+    // Lists with fewer postings than one per this number of documents are sparse, see IsPrefetched
+    static const size_t SPARSE_LIST_GAP = 8;
+    // Queries visiting at least one posting per this number of documents accumulate relevance in
+    // an array over all documents instead of a map
+    static const size_t DENSE_ACCUMULATION_RATIO = 64;
+
+    bool IsStopWord(const std::string_view& word) const;
 
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
@@ -92,22 +341,196 @@ private:
 
     Query ParseQuery(const std::string_view& text, bool seq = true) const;
 
-    double ComputeWordInverseDocumentFreq(const std::string& word) const;
+    static double ComputeWordInverseDocumentFreq(size_t document_freq, size_t document_count);
 
-    template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Query& query,
-                          DocumentPredicate document_predicate) const;
-    
-    template <typename DocumentPredicate, typename ExecutionPolicy>
-    std::vector<Document> FindAllDocuments(ExecutionPolicy&& policy, const Query& query, DocumentPredicate document_predicate) const;
+    const PostingList* FindPostings(std::string_view word) const;
+
+    void ErasePosting(uint32_t term_id, uint32_t ordinal);
+
+    // Erases postings of the documents [first, last) sorted by ordinal
+    void ErasePostings(uint32_t term_id, const std::pair<uint32_t, uint32_t>* first,
+                       const std::pair<uint32_t, uint32_t>* last);
+
+    void CompactPositions(uint32_t term_id);
+
+    // Positions of the word in the document of its index-th posting
+    void GetPositions(std::string_view word, size_t index, std::vector<uint32_t>& positions) const;
+
+    bool ContainsPhrase(const Phrase& phrase, uint32_t ordinal) const;
+
+    // Sorted ordinals of documents containing the phrase
+    std::vector<uint32_t> FindPhraseDocuments(const Phrase& phrase) const;
+
+    double ComputeProximityBoost(const std::vector<std::string_view>& words, uint32_t ordinal) const;
+
+    // Ids of dictionary words starting with prefix, at most max_expansions of them chosen by IsPreferredExpansion
+    std::vector<uint32_t> ExpandPrefix(std::string_view prefix, size_t max_expansions) const;
+
+    // Ids of dictionary words within options_.max_edit_distance edits from word, except word itself,
+    // with their distances. At most max_expansions of them are kept, chosen by IsPreferredExpansion
+    std::vector<std::pair<uint32_t, int>> ExpandFuzzy(std::string_view word, size_t max_expansions) const;
+
+    // Calls callback(ordinal, relevance) in ascending order of ordinals for every document of the union
+    // of the posting lists within [first_ordinal, last_ordinal), relevance being the sum of term
+    // frequencies multiplied by the weights of their lists
+    template <typename Callback>
+    void MergePostings(const std::vector<std::pair<const PostingList*, double>>& posting_lists,
+                       uint32_t first_ordinal, uint32_t last_ordinal, Callback callback) const;
+
+    // Documents of a sparse list lie cache lines apart in the metadata columns and the accumulators,
+    // while the hardware prefetcher keeps up with dense lists itself
+    bool IsPrefetched(const PostingList& postings) const;
+
+    // For the documents of the plus word within [first_ordinal, last_ordinal) calls accumulate(ordinal, relevance)
+    // if select(ordinal) is SCORED and mark(ordinal) if it is COUNTED, and prefetch_accumulator(ordinal) for
+    // documents PREFETCH_DISTANCE postings ahead
+    template <typename Selector, typename Accumulate, typename Mark, typename PrefetchAccumulator>
+    void ScoreGroup(const QueryPlan& plan, const QueryPlan::Group& group, uint32_t first_ordinal, uint32_t last_ordinal,
+                    Selector select, Accumulate accumulate, Mark mark, PrefetchAccumulator prefetch_accumulator) const;
+
+    double GetFuzzyWeight(int distance) const;
+
+    void AddExpandedMatches(const Query& query, uint32_t ordinal, std::vector<std::string_view>& matched_words) const;
+
+    uint32_t GetOrAddTermId(std::string_view word);
+
+    // Returns number of reclaimed bytes
+    size_t VacuumTerm(uint32_t term_id, VacuumReport& report);
+
+    uint32_t GetOrdinal(int document_id) const;
+
+    void ReleaseDocumentTerms(uint32_t ordinal);
+
+    void RemoveDocumentData(int document_id, uint32_t ordinal);
+
+    // Index of the attribute in options_.attributes. Throws invalid_argument for an unknown name
+    size_t GetAttributeField(std::string_view name) const;
+
+    // Returns nullptr if the filter accepts every document, otherwise the set of accepted documents
+    // (possibly built in selection)
+    const Bitmap* SelectDocuments(const DocumentFilter& filter, Bitmap& selection) const;
+
+    // Documents accepted by a filter, tested once per visited posting
+    struct Selection {
+        // Null if every document is accepted
+        const Bitmap* documents = nullptr;
+        // Set built by SelectDocuments when no stored one fits
+        Bitmap built;
+        // Plain copy of documents, filled for queries visiting enough postings to pay for it; a test is then one load
+        std::vector<uint64_t> bits;
+
+        Selection() = default;
+        Selection(const Selection&) = delete;
+        Selection& operator=(const Selection&) = delete;
+
+        bool Contains(uint32_t ordinal) const;
+    };
+
+    // Fills selection with the documents accepted by the filter, flattened if the plan visits comparably
+    // many postings, so that the copy never costs more than the search itself
+    void SelectForPlan(const DocumentFilter& filter, const QueryPlan& plan, Selection& selection) const;
+
+    void CompactForwardIndex();
+
+    // Renumbers live documents densely once removed ones take more than a half of the ordinals.
+    // The relative order of ordinals is kept, so posting lists stay sorted
+    void ReclaimOrdinals();
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopFilteredDocuments(ExecutionPolicy&& policy, const std::string_view& raw_query, const DocumentFilter& filter,
+                                                   const PageCursor& after, size_t page_size,
+                                                   const TermStatistics* statistics = nullptr) const;
+
+    template <typename ExecutionPolicy, typename DocumentAcceptor>
+    std::vector<Document> FindTopAcceptedDocuments(ExecutionPolicy&& policy, const std::string_view& raw_query,
+                                                   DocumentAcceptor is_accepted, const PageCursor& after = PageCursor(),
+                                                   size_t page_size = MAX_RESULT_DOCUMENT_COUNT,
+                                                   const TermStatistics* statistics = nullptr) const;
+
+    // The planner picks sequential or parallel execution itself when this type is passed as the policy
+    struct AutomaticExecution {
+    };
+
+    QueryPlan BuildQueryPlan(const Query& query) const;
+
+    // Parses and plans the query, applying statistics if given
+    std::pair<Query, QueryPlan> PlanQuery(std::string_view raw_query, const TermStatistics* statistics) const;
+
+    // Replaces the local document counts of the plan with the global ones and the local expansions
+    // of prefixes and misspelled words with the ones chosen for the whole collection
+    void ApplyTermStatistics(const TermStatistics& statistics, QueryPlan& plan) const;
+
+    template <typename ExecutionPolicy, typename DocumentAcceptor>
+    std::vector<Document> FindTopPlannedDocuments(ExecutionPolicy&& policy, const Query& query, const QueryPlan& plan,
+                                                  DocumentAcceptor is_accepted, const PageCursor& after, size_t page_size) const;
+
+    template <typename ExecutionPolicy>
+    SearchResult SearchPlanned(ExecutionPolicy&& policy, const Query& query, const QueryPlan& plan,
+                               const SearchOptions& options) const;
+
+    template <typename ExecutionPolicy, typename DocumentAcceptor>
+    std::vector<Document> FindAllDocuments(ExecutionPolicy&& policy, const Query& query, const QueryPlan& plan,
+                                           DocumentAcceptor is_accepted) const;
+
+    // What FindMatches does with a document having a plus word
+    enum class MatchSelection : uint8_t {
+        SKIPPED,
+        // Reported to the match counter, but neither scored nor returned
+        COUNTED,
+        SCORED,
+    };
+
+    // Number of tasks FindMatches splits its work into under the policy
+    template <typename ExecutionPolicy>
+    static size_t GetMatchPartCount();
+
+    // Ordinals of the accepted documents matching the query, ascending, with their relevance. Matching
+    // documents for which only is_counted holds are not scored. count_match(part, ordinal) is called for
+    // every match, accepted or counted, by the task of the part, part < GetMatchPartCount<ExecutionPolicy>()
+    template <typename ExecutionPolicy, typename DocumentAcceptor, typename DocumentCounter, typename MatchCounter>
+    std::vector<std::pair<uint32_t, double>> FindMatches(ExecutionPolicy&& policy, const Query& query, const QueryPlan& plan,
+                                                         DocumentAcceptor is_accepted, DocumentCounter is_counted,
+                                                         MatchCounter count_match) const;
 };
 
+// Pages of the ranked results of a query, each one is searched when the iteration reaches it.
+// The paginator refers to search_server and sees its modifications between pages
+LazyPaginator<Document> PaginateTopDocuments(const SearchServer& search_server, const std::string_view& raw_query, size_t page_size,
+                                             const DocumentFilter& filter = DocumentFilter(DocumentStatus::ACTUAL));
+
 template <typename StringContainer>
-SearchServer::SearchServer(const StringContainer& stop_words)
-    : stop_words_(MakeUniqueNonEmptyStrings(stop_words)) {
+SearchServer::SearchServer(const StringContainer& stop_words, const IndexOptions& options)
+    : stop_words_(MakeUniqueNonEmptyStrings(stop_words))
+    , options_(options)
+    , memory_(std::make_unique<MemoryResources>(options.memory_resource))
+    , term_ids_(&memory_->dictionary)
+    , terms_(&memory_->dictionary)
+    , free_term_ids_(&memory_->dictionary)
+    , term_postings_(&memory_->postings)
+    , term_positions_(&memory_->positions)
+    , trigram_index_(&memory_->fuzzy_index)
+    , forward_index_(&memory_->forward_index)
+    , document_ids_(&memory_->metadata)
+    , ratings_(&memory_->metadata)
+    , statuses_(&memory_->metadata)
+    , document_terms_(&memory_->forward_index)
+    , inv_word_counts_(&memory_->metadata)
+    , id_to_ordinal_(&memory_->metadata)
+    , status_to_documents_({Bitmap(&memory_->filters), Bitmap(&memory_->filters), Bitmap(&memory_->filters), Bitmap(&memory_->filters)})
+    , rating_to_documents_(&memory_->filters)
+    , attribute_indexes_(&memory_->filters) {
         if(!all_of(stop_words.begin(), stop_words.end(), IsValidWord)) {
             throw std::invalid_argument("Stop words contain invalid word");
         }
+        if(options.max_edit_distance < 0 || options.max_edit_distance > 2) {
+            throw std::invalid_argument("Edit distance of fuzzy matching must be from 0 to 2");
+        }
+        for(const AttributeField& field : options.attributes) {
+            if(field.name.empty() || GetAttributeField(field.name) != attribute_indexes_.size()) {
+                throw std::invalid_argument("Attribute names must be unique and non-empty");
+            }
+            attribute_indexes_.emplace_back(field.type);
+        }
 }
 
 template <typename DocumentPredicate>
@@ -117,111 +540,668 @@ std::vector<Document> SearchServer::FindTopDocuments(const std::string_view& raw
 
 template <typename DocumentPredicate, typename ExecutionPolicy>
 std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const std::string_view& raw_query, DocumentPredicate document_predicate) const {
-    //LOG_DURATION_STREAM("Operation time", std::cout);
-    auto query = ParseQuery(raw_query);
-    auto found_documents = FindAllDocuments(policy, query, document_predicate);
-
-    sort(policy, found_documents.begin(), found_documents.end(),
-            [](const Document& lhs, const Document& rhs) {
-                if (std::abs(lhs.relevance - rhs.relevance) < EPS) {
-                    return lhs.rating > rhs.rating;
-                } else {
-                    return lhs.relevance > rhs.relevance;
-                }
-            });
-    if (found_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        found_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
-    }
-    return found_documents;
+    return FindTopAcceptedDocuments(policy, raw_query, [&](uint32_t ordinal) {
+        return document_predicate(document_ids_[ordinal], statuses_[ordinal], ratings_[ordinal]);
+    });
 }
 
 template <typename ExecutionPolicy>
 std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const std::string_view& raw_query, DocumentStatus status) const {
-    return FindTopDocuments(policy, raw_query, 
-    [status]([[maybe_unused]] int document_id, DocumentStatus document_status, [[maybe_unused]] int rating) {
-            return document_status == status;
-        });
+    return FindTopDocuments(policy, raw_query, DocumentFilter(status));
 }
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const Query& query,
-                        DocumentPredicate document_predicate) const {
-    return FindAllDocuments(std::execution::seq, query, document_predicate);
+template <typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const std::string_view& raw_query, const DocumentFilter& filter) const {
+    return FindTopFilteredDocuments(policy, raw_query, filter, PageCursor(), MAX_RESULT_DOCUMENT_COUNT);
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const std::string_view& raw_query, const DocumentFilter& filter,
+                                                     const TermStatistics& statistics) const {
+    return FindTopFilteredDocuments(policy, raw_query, filter, PageCursor(), MAX_RESULT_DOCUMENT_COUNT, &statistics);
+}
+
+inline bool SearchServer::Selection::Contains(uint32_t ordinal) const {
+    if (!documents) {
+        return true;
+    }
+    if (!bits.empty()) {
+        return (bits[ordinal / 64] >> (ordinal % 64)) & 1;
+    }
+    return documents->Contains(ordinal);
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopFilteredDocuments(ExecutionPolicy&& policy, const std::string_view& raw_query, const DocumentFilter& filter,
+                                                             const PageCursor& after, size_t page_size,
+                                                             const TermStatistics* statistics) const {
+    const auto [query, plan] = PlanQuery(raw_query, statistics);
+    Selection selection;
+    SelectForPlan(filter, plan, selection);
+    // Every kind of selection gets its own acceptor: a branch over the kinds in each test is measurable
+    if (!selection.documents) {
+        return FindTopPlannedDocuments(policy, query, plan, []([[maybe_unused]] uint32_t ordinal) {
+            return true;
+        }, after, page_size);
+    }
+    if (!selection.bits.empty()) {
+        const std::vector<uint64_t>& bits = selection.bits;
+        return FindTopPlannedDocuments(policy, query, plan, [&bits](uint32_t ordinal) {
+            return (bits[ordinal / 64] >> (ordinal % 64)) & 1;
+        }, after, page_size);
+    }
+    return FindTopPlannedDocuments(policy, query, plan, [selected = selection.documents](uint32_t ordinal) {
+        return selected->Contains(ordinal);
+    }, after, page_size);
+}
+
+template <typename ExecutionPolicy, typename DocumentAcceptor>
+std::vector<Document> SearchServer::FindTopAcceptedDocuments(ExecutionPolicy&& policy, const std::string_view& raw_query,
+                                                             DocumentAcceptor is_accepted, const PageCursor& after,
+                                                             size_t page_size, const TermStatistics* statistics) const {
+    //LOG_DURATION_STREAM("Operation time", std::cout);
+    const auto [query, plan] = PlanQuery(raw_query, statistics);
+    return FindTopPlannedDocuments(policy, query, plan, is_accepted, after, page_size);
+}
+
+template <typename ExecutionPolicy, typename DocumentAcceptor>
+std::vector<Document> SearchServer::FindTopPlannedDocuments(ExecutionPolicy&& policy, const Query& query, const QueryPlan& plan,
+                                                            DocumentAcceptor is_accepted, const PageCursor& after, size_t page_size) const {
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, AutomaticExecution>) {
+        if (plan.parallel) {
+            return FindTopPlannedDocuments(std::execution::par, query, plan, is_accepted, after, page_size);
+        }
+        return FindTopPlannedDocuments(std::execution::seq, query, plan, is_accepted, after, page_size);
+    } else {
+        auto found_documents = FindAllDocuments(policy, query, plan, is_accepted);
+
+        if (!after.IsFirstPage()) {
+            found_documents.erase(std::remove_if(found_documents.begin(), found_documents.end(), [&after](const Document& document) {
+                return !after.Precedes(document);
+            }), found_documents.end());
+        }
+        // Only the page itself is ordered, the rest of the results is just left behind it
+        if (found_documents.size() > page_size) {
+            std::partial_sort(policy, found_documents.begin(), found_documents.begin() + page_size, found_documents.end(), RanksBefore);
+            found_documents.resize(page_size);
+        } else {
+            sort(policy, found_documents.begin(), found_documents.end(), RanksBefore);
+        }
+        return found_documents;
+    }
+}
+
+template <typename Scorer, typename TieBreak, typename Filter>
+std::vector<Document> SearchServer::FindTopDocumentsWith(const std::string_view& raw_query, Filter filter) const {
+    const Query query = ParseQuery(raw_query);
+    const QueryPlan plan = BuildQueryPlan(query);
+    const size_t document_count = id_to_ordinal_.size();
+    const CollectionStats stats{document_count, document_count == 0 ? 0.0 : static_cast<double>(total_word_count_) / document_count};
+
+    Bitmap selection;
+    const Bitmap* selected = nullptr;
+    if constexpr (std::is_same_v<Filter, DocumentFilter>) {
+        selected = SelectDocuments(filter, selection);
+    }
+    // Filters known at compile time give a mask, so rejected documents are scored with zero weight instead of a branch
+    constexpr bool is_mask_filter = std::is_same_v<Filter, AnyDocument> || IsStatusFilter<Filter>::value;
+    const auto is_accepted = [&](uint32_t ordinal) -> bool {
+        if constexpr (std::is_same_v<Filter, AnyDocument>) {
+            return true;
+        } else if constexpr (IsStatusFilter<Filter>::value) {
+            return statuses_[ordinal] == Filter::STATUS;
+        } else if constexpr (std::is_same_v<Filter, DocumentFilter>) {
+            return !selected || selected->Contains(ordinal);
+        } else {
+            return filter(document_ids_[ordinal], statuses_[ordinal], ratings_[ordinal]);
+        }
+    };
+
+    using Relevance = typename Scorer::Relevance;
+    std::vector<Relevance> posting_relevances;
+    // Calls func(ordinal, relevance) for every posting of the plus words and prefetch(ordinal) for
+    // documents PREFETCH_DISTANCE postings ahead of sparse lists
+    const auto for_each_scored_posting = [&](auto func, auto prefetch) {
+        for (const QueryPlan::Group& group : plan.plus_groups) {
+            for (const QueryPlan::Term& term : group.terms) {
+                const PostingList& postings = *FindPostings(term.word);
+                const size_t posting_count = postings.Size();
+                const Relevance word_weight = static_cast<Relevance>(
+                    GetFuzzyWeight(term.distance) * Scorer::ComputeWordWeight(posting_count, stats));
+                // Scoring is a separate pass without writes to the accumulators, so it can be vectorized
+                posting_relevances.resize(posting_count);
+                const uint32_t* ordinals = postings.Ordinals();
+                const uint32_t* counts = postings.Counts();
+                Relevance* relevance_data = posting_relevances.data();
+                const size_t prefetch_end = IsPrefetched(postings) && posting_count > PREFETCH_DISTANCE ? posting_count - PREFETCH_DISTANCE : 0;
+                for (size_t i = 0; i < posting_count; ++i) {
+                    const uint32_t ordinal = ordinals[i];
+                    if (i < prefetch_end) {
+                        Prefetch(&inv_word_counts_[ordinals[i + PREFETCH_DISTANCE]]);
+                        if constexpr (Scorer::USES_WORD_COUNT) {
+                            Prefetch(&document_terms_[ordinals[i + PREFETCH_DISTANCE]]);
+                        }
+                    }
+                    uint32_t word_count = 0;
+                    if constexpr (Scorer::USES_WORD_COUNT) {
+                        word_count = document_terms_[ordinal].word_count;
+                    }
+                    relevance_data[i] = Scorer::ComputeRelevance(counts[i], inv_word_counts_[ordinal], word_count,
+                                                                 word_weight, stats);
+                }
+                for (size_t i = 0; i < posting_count; ++i) {
+                    if (i < prefetch_end) {
+                        prefetch(ordinals[i + PREFETCH_DISTANCE]);
+                    }
+                    func(ordinals[i], relevance_data[i]);
+                }
+            }
+        }
+    };
+
+    // Ordinals of the found documents, ascending, with their relevance
+    std::vector<std::pair<uint32_t, Relevance>> found;
+    if (plan.estimated_cost * DENSE_ACCUMULATION_RATIO >= document_ids_.size()) {
+        std::vector<Relevance> relevances(document_ids_.size());
+        std::vector<uint8_t> is_found(document_ids_.size());
+        for_each_scored_posting([&](uint32_t ordinal, Relevance relevance) {
+            if constexpr (is_mask_filter) {
+                const uint8_t accepted = is_accepted(ordinal);
+                relevances[ordinal] += accepted * relevance;
+                is_found[ordinal] |= accepted;
+            } else if (is_accepted(ordinal)) {
+                relevances[ordinal] += relevance;
+                is_found[ordinal] = 1;
+            }
+        }, [&](uint32_t ordinal) {
+            Prefetch(&relevances[ordinal]);
+            Prefetch(&is_found[ordinal]);
+        });
+        for (const QueryPlan::Group& group : plan.minus_groups) {
+            for (const QueryPlan::Term& term : group.terms) {
+                const PostingList& postings = *FindPostings(term.word);
+                const uint32_t* ordinals = postings.Ordinals();
+                for (size_t i = 0, posting_count = postings.Size(); i < posting_count; ++i) {
+                    is_found[ordinals[i]] = 0;
+                }
+            }
+        }
+        for (const Phrase& phrase : query.phrases) {
+            std::vector<uint8_t> contains_phrase(document_ids_.size());
+            for (const uint32_t ordinal : FindPhraseDocuments(phrase)) {
+                contains_phrase[ordinal] = 1;
+            }
+            for (size_t ordinal = 0; ordinal < is_found.size(); ++ordinal) {
+                is_found[ordinal] &= contains_phrase[ordinal];
+            }
+        }
+        for (uint32_t ordinal = 0; ordinal < is_found.size(); ++ordinal) {
+            if (is_found[ordinal]) {
+                found.push_back({ordinal, relevances[ordinal]});
+            }
+        }
+    } else {
+        // The stable sort keeps the order of the words, so the sums equal those of the dense arrays
+        std::vector<std::pair<uint32_t, Relevance>> hits;
+        for_each_scored_posting([&](uint32_t ordinal, Relevance relevance) {
+            if (is_accepted(ordinal)) {
+                hits.push_back({ordinal, relevance});
+            }
+        }, []([[maybe_unused]] uint32_t ordinal) {
+        });
+        std::stable_sort(hits.begin(), hits.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.first < rhs.first;
+        });
+        for (const auto& [ordinal, relevance] : hits) {
+            if (!found.empty() && found.back().first == ordinal) {
+                found.back().second += relevance;
+            } else {
+                found.push_back({ordinal, relevance});
+            }
+        }
+        for (const QueryPlan::Group& group : plan.minus_groups) {
+            for (const QueryPlan::Term& term : group.terms) {
+                const PostingList& postings = *FindPostings(term.word);
+                found.erase(std::remove_if(found.begin(), found.end(), [&postings](const auto& document) {
+                                return postings.Contains(document.first);
+                            }), found.end());
+            }
+        }
+        for (const Phrase& phrase : query.phrases) {
+            const std::vector<uint32_t> phrase_documents = FindPhraseDocuments(phrase);
+            found.erase(std::remove_if(found.begin(), found.end(), [&phrase_documents](const auto& document) {
+                            return !std::binary_search(phrase_documents.begin(), phrase_documents.end(), document.first);
+                        }), found.end());
+        }
+    }
+
+    const bool boost_proximity = options_.store_positions && options_.proximity_weight != 0.0 && query.plus_words.size() > 1;
+    std::vector<Document> found_documents;
+    for (const auto& [ordinal, relevance] : found) {
+        const double boost = boost_proximity ? ComputeProximityBoost(query.plus_words, ordinal) : 0.0;
+        found_documents.push_back({document_ids_[ordinal], relevance + boost, ratings_[ordinal]});
+    }
+    const size_t page_size = std::min<size_t>(found_documents.size(), MAX_RESULT_DOCUMENT_COUNT);
+    std::partial_sort(found_documents.begin(), found_documents.begin() + page_size, found_documents.end(), TieBreak());
+    found_documents.resize(page_size);
+    return found_documents;
 }
 
 template <class ExecutionPolicy>
 void SearchServer::RemoveDocument(ExecutionPolicy&& policy, int document_id) {
-    document_ids.erase(document_id);
-    documents_.erase(document_id);
-    
-    std::deque<std::string> words;
-
-    for(auto [word, _]: id_to_word_freqs_[document_id]) {
-        words.push_back(word);
+    const auto ordinal_it = id_to_ordinal_.find(document_id);
+    if(ordinal_it == id_to_ordinal_.end()) {
+        return;
     }
-    for_each(policy, words.begin(), words.end(),
-                [&](const std::string& word) {
-                    word_to_document_freqs_.at(word).erase(document_id);
+    const uint32_t ordinal = ordinal_it->second;
+    RemoveDocumentData(document_id, ordinal);
+
+    // Terms of a document are unique, so every task erases from its own posting list
+    const DocumentTerms& record = document_terms_[ordinal];
+    const auto first = forward_index_.begin() + record.offset;
+    for_each(policy, first, first + record.size,
+                [&](const TermFrequency& entry) {
+                    ErasePosting(entry.term_id, ordinal);
                 });
-    
-    id_to_word_freqs_.erase(document_id);
+
+    ReleaseDocumentTerms(ordinal);
+    ReclaimOrdinals();
+}
+
+template <typename DocumentIds>
+void SearchServer::RemoveDocuments(const DocumentIds& document_ids) {
+    RemoveDocuments(std::execution::seq, document_ids);
+}
+
+template <class ExecutionPolicy, typename DocumentIds>
+void SearchServer::RemoveDocuments(ExecutionPolicy&& policy, const DocumentIds& document_ids) {
+    std::vector<std::pair<int, uint32_t>> removed;
+    for (const int document_id : document_ids) {
+        const auto it = id_to_ordinal_.find(document_id);
+        if (it != id_to_ordinal_.end()) {
+            removed.push_back(*it);
+        }
+    }
+    std::sort(removed.begin(), removed.end());
+    removed.erase(std::unique(removed.begin(), removed.end()), removed.end());
+
+    // (term id, ordinal) pairs grouped by term, so that each posting list is handled by one task
+    std::vector<std::pair<uint32_t, uint32_t>> term_documents;
+    for (const auto& [_, ordinal] : removed) {
+        const DocumentTerms& record = document_terms_[ordinal];
+        for (size_t i = record.offset; i < record.offset + record.size; ++i) {
+            term_documents.push_back({forward_index_[i].term_id, ordinal});
+        }
+    }
+    std::sort(policy, term_documents.begin(), term_documents.end());
+
+    std::vector<std::pair<size_t, size_t>> groups;
+    for (size_t i = 0; i < term_documents.size(); ++i) {
+        if (i == 0 || term_documents[i].first != term_documents[i - 1].first) {
+            groups.push_back({i, i});
+        }
+        ++groups.back().second;
+    }
+    std::for_each(policy, groups.begin(), groups.end(),
+                  [&](const std::pair<size_t, size_t>& group) {
+                      ErasePostings(term_documents[group.first].first, term_documents.data() + group.first,
+                                    term_documents.data() + group.second);
+                  });
+
+    for (const auto& [document_id, ordinal] : removed) {
+        RemoveDocumentData(document_id, ordinal);
+        ReleaseDocumentTerms(ordinal);
+    }
+    ReclaimOrdinals();
 }
 
 template <class ExecutionPolicy>
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(ExecutionPolicy policy, const std::string_view& raw_query, int document_id) const {
-    if(document_ids.find(document_id) == document_ids.end()) {
-        throw std::out_of_range("Document with id " + std::to_string(document_id) + " doesn't exist");
-    }
+    const uint32_t ordinal = GetOrdinal(document_id);
     const Query query = ParseQuery(raw_query, std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>);
     
     if(std::any_of(policy, query.minus_words.begin(), query.minus_words.end(),
                 [&](const std::string_view& word) {
-            return (word_to_document_freqs_.count(std::string(word)) && word_to_document_freqs_.at(std::string(word)).count(document_id));
+            const auto* postings = FindPostings(word);
+            return postings && postings->Contains(ordinal);
+        })) {
+        return {std::vector<std::string_view>(), statuses_[ordinal]};
+    }
+    if(std::any_of(policy, query.minus_prefixes.begin(), query.minus_prefixes.end(),
+                [&](const std::string_view& prefix) {
+            const std::vector<uint32_t> term_ids = ExpandPrefix(prefix, options_.max_prefix_expansions);
+            return std::any_of(term_ids.begin(), term_ids.end(), [&](uint32_t term_id) {
+                return term_postings_[term_id].Contains(ordinal);
+            });
         })) {
-        return {{}, documents_.at(document_id).status};
+        return {std::vector<std::string_view>(), statuses_[ordinal]};
+    }
+    if(!std::all_of(query.phrases.begin(), query.phrases.end(), [&](const Phrase& phrase) {
+            return ContainsPhrase(phrase, ordinal);
+        })) {
+        return {std::vector<std::string_view>(), statuses_[ordinal]};
     }
     
     std::vector<std::string_view> matched_words(query.plus_words.size());
     
     auto it = std::copy_if(policy, query.plus_words.begin(), query.plus_words.end(), matched_words.begin(), [&](const std::string_view& word) {
-        return (word_to_document_freqs_.count(std::string(word)) && word_to_document_freqs_.at(std::string(word)).count(document_id));
+        const auto* postings = FindPostings(word);
+        return postings && postings->Contains(ordinal);
     });
+    matched_words.erase(it, matched_words.end());
+    AddExpandedMatches(query, ordinal, matched_words);
     
-    std::sort(policy, matched_words.begin(), it);
-    matched_words.erase(std::unique(policy, matched_words.begin(), it), matched_words.end());
-    return {matched_words, documents_.at(document_id).status};
+    std::sort(policy, matched_words.begin(), matched_words.end());
+    matched_words.erase(std::unique(policy, matched_words.begin(), matched_words.end()), matched_words.end());
+    return {matched_words, statuses_[ordinal]};
 }
 
-template <typename DocumentPredicate, typename ExecutionPolicy>
-std::vector<Document> SearchServer::FindAllDocuments(ExecutionPolicy&& policy, const Query& query, DocumentPredicate document_predicate) const {
-    ConcurrentMap<int, double> document_to_relevance;
-    for_each(policy, query.plus_words.begin(), query.plus_words.end(),
-    [&](const std::string_view& word) {
-        if (word_to_document_freqs_.count(std::string(word)) == 0) {
-            return;
+template <typename ExecutionPolicy, typename DocumentAcceptor>
+std::vector<Document> SearchServer::FindAllDocuments(ExecutionPolicy&& policy, const Query& query, const QueryPlan& plan,
+                                                     DocumentAcceptor is_accepted) const {
+    std::vector<Document> found_documents;
+    const auto is_counted = []([[maybe_unused]] uint32_t ordinal) {
+        return false;
+    };
+    const auto count_match = []([[maybe_unused]] size_t part, [[maybe_unused]] uint32_t ordinal) {
+    };
+    for (const auto& [ordinal, relevance] : FindMatches(policy, query, plan, is_accepted, is_counted, count_match)) {
+        found_documents.push_back({document_ids_[ordinal], relevance, ratings_[ordinal]});
+    }
+    return found_documents;
+}
+
+template <typename ExecutionPolicy>
+SearchResult SearchServer::Search(ExecutionPolicy&& policy, const std::string_view& raw_query, const SearchOptions& options) const {
+    if (options.rating_bucket_width < 0) {
+        throw std::invalid_argument("Rating bucket width must not be negative");
+    }
+    const auto [query, plan] = PlanQuery(raw_query, nullptr);
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, AutomaticExecution>) {
+        if (plan.parallel) {
+            return SearchPlanned(std::execution::par, query, plan, options);
+        }
+        return SearchPlanned(std::execution::seq, query, plan, options);
+    } else {
+        return SearchPlanned(policy, query, plan, options);
+    }
+}
+
+template <typename ExecutionPolicy>
+SearchResult SearchServer::SearchPlanned(ExecutionPolicy&& policy, const Query& query, const QueryPlan& plan,
+                                         const SearchOptions& options) const {
+    // A facet counts the matches of the filter without its restriction on the faceted dimension. Documents
+    // only a facet needs are counted together with the matches, but not scored
+    Selection accepted;
+    SelectForPlan(options.filter, plan, accepted);
+    Selection any_status;
+    if (options.count_statuses) {
+        SelectForPlan(options.filter.WithoutStatusRestriction(), plan, any_status);
+    }
+    const bool count_ratings = options.rating_bucket_width > 0;
+    Selection any_rating;
+    if (count_ratings) {
+        SelectForPlan(options.filter.WithoutRatingRestriction(), plan, any_rating);
+    }
+    std::vector<SearchResult> counters(GetMatchPartCount<ExecutionPolicy>());
+    const auto matches = FindMatches(policy, query, plan, [&](uint32_t ordinal) {
+        return accepted.Contains(ordinal);
+    }, [&](uint32_t ordinal) {
+        return (options.count_statuses && any_status.Contains(ordinal)) || (count_ratings && any_rating.Contains(ordinal));
+    }, [&](size_t part, uint32_t ordinal) {
+        SearchResult& counter = counters[part];
+        if (accepted.Contains(ordinal)) {
+            ++counter.total_hits;
+        }
+        if (options.count_statuses && any_status.Contains(ordinal)) {
+            ++counter.status_counts[static_cast<size_t>(statuses_[ordinal])];
         }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(std::string(word));
-        for (const auto [document_id, term_freq] : word_to_document_freqs_.at(std::string(word))) {
-            const auto& document_data = documents_.at(document_id);
-            if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
+        if (count_ratings && any_rating.Contains(ordinal)) {
+            // Rounded down, so negative ratings fall into buckets like positive ones
+            const int remainder = ratings_[ordinal] % options.rating_bucket_width;
+            ++counter.rating_counts[ratings_[ordinal] - (remainder < 0 ? remainder + options.rating_bucket_width : remainder)];
+        }
+    });
+
+    SearchResult result = std::move(counters[0]);
+    for (size_t i = 1; i < counters.size(); ++i) {
+        result.total_hits += counters[i].total_hits;
+        for (size_t status = 0; status < DOCUMENT_STATUS_COUNT; ++status) {
+            result.status_counts[status] += counters[i].status_counts[status];
+        }
+        for (const auto& [bucket, count] : counters[i].rating_counts) {
+            result.rating_counts[bucket] += count;
+        }
+    }
+
+    // Every thread keeps its own top of a part of the matches, the tops are merged after
+    size_t part_count = 1;
+    if constexpr (!std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>) {
+        part_count = std::clamp<size_t>(matches.size() / 4096, 1, GetMatchPartCount<ExecutionPolicy>());
+    }
+    std::vector<std::vector<Document>> tops(part_count);
+    std::vector<size_t> part_indexes(part_count);
+    std::iota(part_indexes.begin(), part_indexes.end(), 0);
+    std::for_each(policy, part_indexes.begin(), part_indexes.end(), [&](size_t part_index) {
+        std::vector<Document>& top = tops[part_index];
+        const size_t last = matches.size() * (part_index + 1) / part_count;
+        for (size_t i = matches.size() * part_index / part_count; i < last; ++i) {
+            const auto [ordinal, relevance] = matches[i];
+            const Document document{document_ids_[ordinal], relevance, ratings_[ordinal]};
+            if (options.after.Precedes(document)) {
+                top.push_back(document);
             }
         }
+        if (top.size() > options.top_k) {
+            std::nth_element(top.begin(), top.begin() + options.top_k, top.end(), RanksBefore);
+            top.resize(options.top_k);
+        }
     });
+    for (const std::vector<Document>& top : tops) {
+        result.documents.insert(result.documents.end(), top.begin(), top.end());
+    }
+    const size_t top_k = std::min(options.top_k, result.documents.size());
+    std::partial_sort(result.documents.begin(), result.documents.begin() + top_k, result.documents.end(), RanksBefore);
+    result.documents.resize(top_k);
+    return result;
+}
 
-    for_each(policy, query.minus_words.begin(), query.minus_words.end(),
-    [&](const std::string_view& word) {
-        if (word_to_document_freqs_.count(std::string(word)) == 0) {
+template <typename ExecutionPolicy>
+size_t SearchServer::GetMatchPartCount() {
+    if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>) {
+        return 1;
+    } else {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+template <typename ExecutionPolicy, typename DocumentAcceptor, typename DocumentCounter, typename MatchCounter>
+std::vector<std::pair<uint32_t, double>> SearchServer::FindMatches(ExecutionPolicy&& policy, const Query& query, const QueryPlan& plan,
+                                                                   DocumentAcceptor is_accepted, DocumentCounter is_counted,
+                                                                   MatchCounter count_match) const {
+    // Documents of minus words are known before scoring, so they never get into the accumulator
+    Bitmap excluded;
+    if (plan.exclusion == QueryPlan::Exclusion::BITMAP) {
+        for (const QueryPlan::Group& group : plan.minus_groups) {
+            for (const QueryPlan::Term& term : group.terms) {
+                const PostingList& postings = *FindPostings(term.word);
+                const uint32_t* ordinals = postings.Ordinals();
+                for (size_t i = 0, posting_count = postings.Size(); i < posting_count; ++i) {
+                    excluded.Add(ordinals[i]);
+                }
+            }
+        }
+    }
+    // The filters go first: they reject most postings of a selective query and cost less than a bitmap search
+    const auto select = [&](uint32_t ordinal) {
+        const MatchSelection selection = is_accepted(ordinal) ? MatchSelection::SCORED
+                                         : is_counted(ordinal) ? MatchSelection::COUNTED : MatchSelection::SKIPPED;
+        return selection != MatchSelection::SKIPPED && excluded.Contains(ordinal) ? MatchSelection::SKIPPED : selection;
+    };
+
+    std::vector<const PostingList*> probed;
+    if (plan.exclusion == QueryPlan::Exclusion::PROBE) {
+        for (const QueryPlan::Group& group : plan.minus_groups) {
+            for (const QueryPlan::Term& term : group.terms) {
+                probed.push_back(FindPostings(term.word));
+            }
+        }
+    }
+    std::vector<std::vector<uint32_t>> phrase_documents;
+    for (const Phrase& phrase : query.phrases) {
+        phrase_documents.push_back(FindPhraseDocuments(phrase));
+    }
+    const bool boost_proximity = options_.store_positions && options_.proximity_weight != 0.0 && query.plus_words.size() > 1;
+    // Checks a document having a plus word against the rest of the query, counts it and keeps it if it is scored
+    const auto add_match = [&](size_t part, uint32_t ordinal, MatchSelection selection, double relevance,
+                               std::vector<std::pair<uint32_t, double>>& matches) {
+        if (std::any_of(probed.begin(), probed.end(), [ordinal](const PostingList* postings) {
+                return postings->Contains(ordinal);
+            })) {
             return;
         }
-        for (const auto [document_id, _] : word_to_document_freqs_.at(std::string(word))) {
-            document_to_relevance.Erase(document_id);
+        if (!std::all_of(phrase_documents.begin(), phrase_documents.end(), [ordinal](const std::vector<uint32_t>& ordinals) {
+                return std::binary_search(ordinals.begin(), ordinals.end(), ordinal);
+            })) {
+            return;
+        }
+        count_match(part, ordinal);
+        if (selection == MatchSelection::SCORED) {
+            const double boost = boost_proximity ? ComputeProximityBoost(query.plus_words, ordinal) : 0.0;
+            matches.push_back({ordinal, relevance + boost});
+        }
+    };
+
+    std::vector<std::pair<uint32_t, double>> matches;
+    const size_t document_count = document_ids_.size();
+    if (plan.estimated_cost * DENSE_ACCUMULATION_RATIO >= document_count) {
+        // Every task scores its own range of ordinals into its own slice of the accumulators and then
+        // collects the matches of the range
+        std::vector<double> relevances(document_count);
+        std::vector<MatchSelection> selections(document_count);
+        const size_t part_count = GetMatchPartCount<ExecutionPolicy>();
+        std::vector<std::vector<std::pair<uint32_t, double>>> part_matches(part_count);
+        std::vector<size_t> parts(part_count);
+        std::iota(parts.begin(), parts.end(), 0);
+        std::for_each(policy, parts.begin(), parts.end(), [&](size_t part) {
+            const auto first_ordinal = static_cast<uint32_t>(document_count * part / part_count);
+            const auto last_ordinal = static_cast<uint32_t>(document_count * (part + 1) / part_count);
+            for (const QueryPlan::Group& group : plan.plus_groups) {
+                ScoreGroup(plan, group, first_ordinal, last_ordinal, select, [&](uint32_t ordinal, double relevance) {
+                    relevances[ordinal] += relevance;
+                    selections[ordinal] = MatchSelection::SCORED;
+                }, [&](uint32_t ordinal) {
+                    selections[ordinal] = MatchSelection::COUNTED;
+                }, [&](uint32_t ordinal) {
+                    Prefetch(&relevances[ordinal]);
+                    Prefetch(&selections[ordinal]);
+                });
+            }
+            for (uint32_t ordinal = first_ordinal; ordinal < last_ordinal; ++ordinal) {
+                if (selections[ordinal] != MatchSelection::SKIPPED) {
+                    add_match(part, ordinal, selections[ordinal], relevances[ordinal], part_matches[part]);
+                }
+            }
+        });
+        for (const auto& part : part_matches) {
+            matches.insert(matches.end(), part.begin(), part.end());
+        }
+    } else {
+        // Few postings to visit, clearing accumulators for all documents would cost more than a map
+        ConcurrentMap<uint32_t, std::pair<double, MatchSelection>> document_to_relevance;
+        for_each(policy, plan.plus_groups.begin(), plan.plus_groups.end(),
+        [&](const QueryPlan::Group& group) {
+            ScoreGroup(plan, group, 0, static_cast<uint32_t>(document_count), select, [&](uint32_t ordinal, double relevance) {
+                auto& accumulator = document_to_relevance[ordinal].ref_to_value;
+                accumulator.first += relevance;
+                accumulator.second = MatchSelection::SCORED;
+            }, [&](uint32_t ordinal) {
+                document_to_relevance[ordinal].ref_to_value.second = MatchSelection::COUNTED;
+            }, []([[maybe_unused]] uint32_t ordinal) {
+            });
+        });
+        for (const auto& [ordinal, accumulator] : document_to_relevance.BuildOrdinaryMap()) {
+            add_match(0, ordinal, accumulator.second, accumulator.first, matches);
+        }
+    }
+    return matches;
+}
+
+template <typename Selector, typename Accumulate, typename Mark, typename PrefetchAccumulator>
+void SearchServer::ScoreGroup(const QueryPlan& plan, const QueryPlan::Group& group, uint32_t first_ordinal, uint32_t last_ordinal,
+                              Selector select, Accumulate accumulate, Mark mark, PrefetchAccumulator prefetch_accumulator) const {
+    if (group.terms.size() == 1) {
+        const PostingList& postings = *FindPostings(group.terms[0].word);
+        const double inverse_document_freq = GetFuzzyWeight(group.terms[0].distance)
+                                             * ComputeWordInverseDocumentFreq(group.terms[0].document_count, plan.document_count);
+        const uint32_t* ordinals = postings.Ordinals();
+        const uint32_t* counts = postings.Counts();
+        const size_t last = postings.LowerBound(last_ordinal);
+        const bool prefetch = IsPrefetched(postings);
+        for (size_t i = postings.LowerBound(first_ordinal); i < last; ++i) {
+            if (prefetch && i + PREFETCH_DISTANCE < last) {
+                Prefetch(&inv_word_counts_[ordinals[i + PREFETCH_DISTANCE]]);
+                prefetch_accumulator(ordinals[i + PREFETCH_DISTANCE]);
+            }
+            const MatchSelection selection = select(ordinals[i]);
+            if (selection == MatchSelection::SCORED) {
+                accumulate(ordinals[i], counts[i] * inv_word_counts_[ordinals[i]] * inverse_document_freq);
+            } else if (selection == MatchSelection::COUNTED) {
+                mark(ordinals[i]);
+            }
+        }
+        return;
+    }
+    // Postings of all expansions of a word are merged, so each document gets one accumulator update
+    std::vector<std::pair<const PostingList*, double>> postings;
+    for (const QueryPlan::Term& term : group.terms) {
+        postings.push_back({FindPostings(term.word), GetFuzzyWeight(term.distance)
+                            * ComputeWordInverseDocumentFreq(term.document_count, plan.document_count)});
+    }
+    MergePostings(postings, first_ordinal, last_ordinal, [&](uint32_t ordinal, double relevance) {
+        const MatchSelection selection = select(ordinal);
+        if (selection == MatchSelection::SCORED) {
+            accumulate(ordinal, relevance);
+        } else if (selection == MatchSelection::COUNTED) {
+            mark(ordinal);
         }
     });
-    
-    std::vector<Document> found_documents;
-    for (const auto [document_id, relevance] : document_to_relevance.BuildOrdinaryMap()) {
-        found_documents.push_back({document_id, relevance, documents_.at(document_id).rating});
+}
+
+template <typename Callback>
+void SearchServer::MergePostings(const std::vector<std::pair<const PostingList*, double>>& posting_lists,
+                                 uint32_t first_ordinal, uint32_t last_ordinal, Callback callback) const {
+    struct Cursor {
+        const uint32_t* ordinal;
+        const uint32_t* ordinals_end;
+        const uint32_t* count;
+        double weight;
+    };
+    const auto later = [](const Cursor& lhs, const Cursor& rhs) {
+        return *lhs.ordinal > *rhs.ordinal;
+    };
+    std::vector<Cursor> heap;
+    for (const auto& [postings, weight] : posting_lists) {
+        const size_t first = postings->LowerBound(first_ordinal);
+        const size_t last = postings->LowerBound(last_ordinal);
+        if (first != last) {
+            heap.push_back({postings->Ordinals() + first, postings->Ordinals() + last, postings->Counts() + first, weight});
+        }
     }
-    return found_documents;
-}
\ No newline at end of file
+    std::make_heap(heap.begin(), heap.end(), later);
+    while (!heap.empty()) {
+        const uint32_t ordinal = *heap.front().ordinal;
+        double relevance = 0.0;
+        while (!heap.empty() && *heap.front().ordinal == ordinal) {
+            std::pop_heap(heap.begin(), heap.end(), later);
+            Cursor& cursor = heap.back();
+            relevance += *cursor.count++ * inv_word_counts_[ordinal] * cursor.weight;
+            if (++cursor.ordinal == cursor.ordinals_end) {
+                heap.pop_back();
+            } else {
+                std::push_heap(heap.begin(), heap.end(), later);
+            }
+        }
+        callback(ordinal, relevance);
+    }
+}
@@ -0,0 +1,287 @@
+#include "shard_broker.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <deque>
+#include <exception>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "search_server.h"
+#include "sharded_search_server.h"
+
+using namespace std;
+
+namespace {
+
+// Payload of a successful response, or the error of the shard thrown
+string TakePayload(Frame& response, MessageType type) {
+    if (response.type == MessageType::ERROR) {
+        ThrowError(response.payload);
+    }
+    if (response.type != type) {
+        throw runtime_error("Unexpected response type "s + to_string(static_cast<int>(response.type)));
+    }
+    return move(response.payload);
+}
+
+string MakeAddDocumentPayload(int document_id, const string_view& document, DocumentStatus status,
+                              const vector<int>& ratings, const DocumentAttributes& attributes) {
+    MessageWriter writer;
+    writer.PutInt32(document_id);
+    writer.PutString(document);
+    writer.PutUint8(static_cast<uint8_t>(status));
+    writer.PutUint32(static_cast<uint32_t>(ratings.size()));
+    for (const int rating : ratings) {
+        writer.PutInt32(rating);
+    }
+    WriteDocumentAttributes(writer, attributes);
+    return writer.GetData();
+}
+
+}  // namespace
+
+ShardBroker::Connection::Connection(const string& socket_path)
+    : socket_(ConnectUnixSocket(socket_path)) {
+}
+
+uint32_t ShardBroker::Connection::Send(MessageType type, string_view payload, Clock::time_point deadline) {
+    const uint32_t request_id = next_request_id_++;
+    string frame;
+    AppendFrame(frame, request_id, type, payload);
+    size_t offset = 0;
+    while (offset < frame.size()) {
+        const ssize_t size = send(socket_.Get(), frame.data() + offset, frame.size() - offset, MSG_NOSIGNAL);
+        if (size >= 0) {
+            offset += size;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            WaitFor(POLLOUT, deadline);
+        } else if (errno != EINTR) {
+            throw system_error(errno, generic_category(), "send"s);
+        }
+    }
+    return request_id;
+}
+
+Frame ShardBroker::Connection::Receive(uint32_t request_id, Clock::time_point deadline) {
+    Frame response;
+    while (true) {
+        if (const size_t frame_size = ExtractFrame(input_, response)) {
+            input_.erase(0, frame_size);
+            if (response.request_id != request_id) {
+                throw runtime_error("Response to request "s + to_string(response.request_id) + " instead of "s
+                                    + to_string(request_id));
+            }
+            return response;
+        }
+        char buffer[64 * 1024];
+        const ssize_t size = read(socket_.Get(), buffer, sizeof(buffer));
+        if (size > 0) {
+            input_.append(buffer, size);
+        } else if (size == 0) {
+            throw runtime_error("Shard closed the connection"s);
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            WaitFor(POLLIN, deadline);
+        } else if (errno != EINTR) {
+            throw system_error(errno, generic_category(), "read"s);
+        }
+    }
+}
+
+bool ShardBroker::Connection::IsClosed() const {
+    pollfd poll_fd{socket_.Get(), POLLIN, 0};
+    return poll(&poll_fd, 1, 0) != 0;
+}
+
+void ShardBroker::Connection::WaitFor(short events, Clock::time_point deadline) const {
+    while (true) {
+        const auto timeout = chrono::ceil<chrono::milliseconds>(deadline - Clock::now()).count();
+        if (timeout <= 0) {
+            throw runtime_error("Shard timed out"s);
+        }
+        pollfd poll_fd{socket_.Get(), events, 0};
+        const int ready = poll(&poll_fd, 1, static_cast<int>(timeout));
+        if (ready > 0) {
+            return;
+        }
+        if (ready < 0 && errno != EINTR) {
+            throw system_error(errno, generic_category(), "poll"s);
+        }
+    }
+}
+
+ShardBroker::ShardBroker(vector<string> socket_paths, const BrokerOptions& options)
+    : options_(options) {
+    if (socket_paths.empty()) {
+        throw invalid_argument("Broker needs at least one shard"s);
+    }
+    if (options_.pipeline_depth == 0) {
+        throw invalid_argument("Pipeline depth must be positive"s);
+    }
+    for (string& socket_path : socket_paths) {
+        shards_.push_back(make_unique<Shard>());
+        shards_.back()->socket_path = move(socket_path);
+    }
+}
+
+void ShardBroker::AddDocument(int document_id, const string_view& document, DocumentStatus status,
+                              const vector<int>& ratings, const DocumentAttributes& attributes) {
+    Call(SelectShard(document_id, shards_.size()), MessageType::ADD_DOCUMENT,
+         MakeAddDocumentPayload(document_id, document, status, ratings, attributes));
+}
+
+void ShardBroker::AddDocuments(const vector<DocumentRecord>& documents) {
+    // The whole batch is one call, so it has one deadline rather than one per document
+    const Clock::time_point deadline = Clock::now() + options_.timeout;
+    vector<unique_ptr<Connection>> connections(shards_.size());
+    vector<deque<uint32_t>> pending(shards_.size());
+    exception_ptr error;
+    const auto receive_oldest = [&](size_t shard) {
+        Frame response = connections[shard]->Receive(pending[shard].front(), deadline);
+        pending[shard].pop_front();
+        try {
+            TakePayload(response, MessageType::ADD_DOCUMENT);
+        } catch (const exception&) {
+            if (!error) {
+                error = current_exception();
+            }
+        }
+    };
+
+    for (const DocumentRecord& document : documents) {
+        const size_t shard = SelectShard(document.id, shards_.size());
+        if (!connections[shard]) {
+            connections[shard] = AcquireConnection(shard);
+        }
+        if (pending[shard].size() >= options_.pipeline_depth) {
+            receive_oldest(shard);
+        }
+        pending[shard].push_back(connections[shard]->Send(
+            MessageType::ADD_DOCUMENT,
+            MakeAddDocumentPayload(document.id, document.text, document.status, document.ratings, document.attributes),
+            deadline));
+    }
+    for (size_t shard = 0; shard < shards_.size(); ++shard) {
+        while (!pending[shard].empty()) {
+            receive_oldest(shard);
+        }
+        if (connections[shard]) {
+            ReleaseConnection(shard, move(connections[shard]));
+        }
+    }
+    if (error) {
+        rethrow_exception(error);
+    }
+}
+
+void ShardBroker::RemoveDocument(int document_id) {
+    Call(SelectShard(document_id, shards_.size()), MessageType::REMOVE_DOCUMENT, [document_id] {
+        MessageWriter writer;
+        writer.PutInt32(document_id);
+        return writer.GetData();
+    }());
+}
+
+vector<Document> ShardBroker::FindTopDocuments(const string_view& raw_query, const DocumentFilter& filter) const {
+    // Both rounds share the deadline of the call
+    const Clock::time_point deadline = Clock::now() + options_.timeout;
+    MessageWriter statistics_request;
+    statistics_request.PutString(raw_query);
+    TermStatistics statistics;
+    for (const string& response : Scatter(MessageType::TERM_STATISTICS, statistics_request.GetData(), deadline)) {
+        MessageReader reader(response);
+        statistics += ReadTermStatistics(reader);
+    }
+    statistics.LimitExpansions(options_.max_prefix_expansions, options_.max_fuzzy_expansions);
+
+    MessageWriter documents_request;
+    documents_request.PutString(raw_query);
+    WriteDocumentFilter(documents_request, filter);
+    WriteTermStatistics(documents_request, statistics);
+    vector<Document> documents;
+    for (const string& response : Scatter(MessageType::FIND_TOP_DOCUMENTS, documents_request.GetData(), deadline)) {
+        MessageReader reader(response);
+        const vector<Document> shard_documents = ReadDocuments(reader);
+        documents.insert(documents.end(), shard_documents.begin(), shard_documents.end());
+    }
+    const size_t result_size = min<size_t>(documents.size(), MAX_RESULT_DOCUMENT_COUNT);
+    partial_sort(documents.begin(), documents.begin() + result_size, documents.end(), RanksBefore);
+    documents.resize(result_size);
+    return documents;
+}
+
+vector<Document> ShardBroker::FindTopDocuments(const string_view& raw_query, DocumentStatus status) const {
+    return FindTopDocuments(raw_query, DocumentFilter(status));
+}
+
+int ShardBroker::GetDocumentCount() const {
+    int document_count = 0;
+    for (const string& response : Scatter(MessageType::DOCUMENT_COUNT, {}, Clock::now() + options_.timeout)) {
+        MessageReader reader(response);
+        document_count += static_cast<int>(reader.GetUint64());
+    }
+    return document_count;
+}
+
+size_t ShardBroker::GetShardCount() const {
+    return shards_.size();
+}
+
+unique_ptr<ShardBroker::Connection> ShardBroker::AcquireConnection(size_t shard) const {
+    Shard& target = *shards_[shard];
+    {
+        lock_guard lock(target.mutex);
+        while (!target.idle_connections.empty()) {
+            unique_ptr<Connection> connection = move(target.idle_connections.back());
+            target.idle_connections.pop_back();
+            if (!connection->IsClosed()) {
+                return connection;
+            }
+        }
+    }
+    return make_unique<Connection>(target.socket_path);
+}
+
+void ShardBroker::ReleaseConnection(size_t shard, unique_ptr<Connection> connection) const {
+    Shard& target = *shards_[shard];
+    lock_guard lock(target.mutex);
+    if (target.idle_connections.size() < options_.max_idle_connections) {
+        target.idle_connections.push_back(move(connection));
+    }
+}
+
+vector<string> ShardBroker::Scatter(MessageType type, const string& payload, Clock::time_point deadline) const {
+    // A failure anywhere drops the connections of this call, none of them is left with an unread response
+    vector<unique_ptr<Connection>> connections;
+    vector<uint32_t> request_ids;
+    for (size_t shard = 0; shard < shards_.size(); ++shard) {
+        connections.push_back(AcquireConnection(shard));
+        request_ids.push_back(connections.back()->Send(type, payload, deadline));
+    }
+    vector<Frame> responses;
+    for (size_t shard = 0; shard < shards_.size(); ++shard) {
+        responses.push_back(connections[shard]->Receive(request_ids[shard], deadline));
+    }
+    for (size_t shard = 0; shard < shards_.size(); ++shard) {
+        ReleaseConnection(shard, move(connections[shard]));
+    }
+    vector<string> payloads;
+    for (Frame& response : responses) {
+        payloads.push_back(TakePayload(response, type));
+    }
+    return payloads;
+}
+
+string ShardBroker::Call(size_t shard, MessageType type, const string& payload) const {
+    const Clock::time_point deadline = Clock::now() + options_.timeout;
+    unique_ptr<Connection> connection = AcquireConnection(shard);
+    const uint32_t request_id = connection->Send(type, payload, deadline);
+    Frame response = connection->Receive(request_id, deadline);
+    ReleaseConnection(shard, move(connection));
+    return TakePayload(response, type);
+}
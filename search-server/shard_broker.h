@@ -0,0 +1,112 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "document.h"
+#include "document_filter.h"
+#include "search_server.h"
+#include "shard_protocol.h"
+#include "socket_util.h"
+
+struct BrokerOptions {
+    // Limit of every call; a shard not answering in time fails the call with a runtime_error
+    std::chrono::milliseconds timeout{1000};
+    // Connections kept open per shard between calls
+    size_t max_idle_connections = 8;
+    // Requests sent ahead of their responses on one connection by AddDocuments
+    size_t pipeline_depth = 64;
+    // Expansion caps of the IndexOptions of the shards, the broker chooses expansions for the whole collection
+    size_t max_prefix_expansions = IndexOptions().max_prefix_expansions;
+    size_t max_fuzzy_expansions = IndexOptions().max_fuzzy_expansions;
+};
+
+struct DocumentRecord {
+    int id = 0;
+    std::string text;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+    DocumentAttributes attributes = DocumentAttributes();
+};
+
+// Client of ShardServer processes, one per socket path, holding parts of one collection.
+// Documents go to shards by SelectShard(), like in ShardedSearchServer. Queries are scattered
+// to all shards twice: for term statistics and for the top documents scored with their sum,
+// so IDF is global. Errors of SearchServer on a shard are rethrown as invalid_argument or
+// out_of_range, transport failures and timeouts as runtime_error. Calls from several threads
+// run concurrently over separate pooled connections. Unlike ShardedSearchServer, the broker does not
+// order writes against queries: a document added between the two rounds of a query is scored with
+// frequencies that do not count it yet
+class ShardBroker {
+public:
+    explicit ShardBroker(std::vector<std::string> socket_paths, const BrokerOptions& options = BrokerOptions());
+
+    ShardBroker(const ShardBroker&) = delete;
+    ShardBroker& operator=(const ShardBroker&) = delete;
+
+    void AddDocument(int document_id, const std::string_view& document, DocumentStatus status,
+                     const std::vector<int>& ratings, const DocumentAttributes& attributes = DocumentAttributes());
+
+    // Pipelined: requests to a shard are sent without waiting for the previous responses.
+    // All documents are tried, the first error is rethrown afterwards
+    void AddDocuments(const std::vector<DocumentRecord>& documents);
+
+    void RemoveDocument(int document_id);
+
+    std::vector<Document> FindTopDocuments(const std::string_view& raw_query,
+                                           const DocumentFilter& filter = DocumentFilter(DocumentStatus::ACTUAL)) const;
+
+    std::vector<Document> FindTopDocuments(const std::string_view& raw_query, DocumentStatus status) const;
+
+    int GetDocumentCount() const;
+
+    size_t GetShardCount() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    class Connection {
+    public:
+        explicit Connection(const std::string& socket_path);
+
+        uint32_t Send(MessageType type, std::string_view payload, Clock::time_point deadline);
+
+        // Responses come in the order of requests, so request_id must be the oldest unanswered one.
+        // An ERROR response leaves the connection usable, so it is returned rather than thrown
+        Frame Receive(uint32_t request_id, Clock::time_point deadline);
+
+        // An idle connection has nothing to read, so being readable means the shard closed it,
+        // for example by restarting
+        bool IsClosed() const;
+
+    private:
+        UniqueFd socket_;
+        uint32_t next_request_id_ = 0;
+        std::string input_;
+
+        void WaitFor(short events, Clock::time_point deadline) const;
+    };
+
+    struct Shard {
+        std::string socket_path;
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Connection>> idle_connections;
+    };
+
+    BrokerOptions options_;
+    mutable std::vector<std::unique_ptr<Shard>> shards_;
+
+    // Idle connections closed by the shard are dropped rather than reused
+    std::unique_ptr<Connection> AcquireConnection(size_t shard) const;
+
+    // Connections with unanswered requests or a failed transport must not be released
+    void ReleaseConnection(size_t shard, std::unique_ptr<Connection> connection) const;
+
+    // Sends one request to every shard and returns their responses in the order of shards
+    std::vector<std::string> Scatter(MessageType type, const std::string& payload, Clock::time_point deadline) const;
+
+    std::string Call(size_t shard, MessageType type, const std::string& payload) const;
+};
@@ -0,0 +1,284 @@
+#include "shard_protocol.h"
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+void MessageWriter::PutUint8(uint8_t value) {
+    data_.push_back(static_cast<char>(value));
+}
+
+void MessageWriter::PutUint32(uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        PutUint8(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+void MessageWriter::PutInt32(int32_t value) {
+    PutUint32(static_cast<uint32_t>(value));
+}
+
+void MessageWriter::PutUint64(uint64_t value) {
+    PutUint32(static_cast<uint32_t>(value));
+    PutUint32(static_cast<uint32_t>(value >> 32));
+}
+
+void MessageWriter::PutDouble(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    PutUint64(bits);
+}
+
+void MessageWriter::PutString(string_view value) {
+    PutUint32(static_cast<uint32_t>(value.size()));
+    data_.append(value);
+}
+
+const string& MessageWriter::GetData() const {
+    return data_;
+}
+
+void MessageWriter::Clear() {
+    data_.clear();
+}
+
+MessageReader::MessageReader(string_view data)
+    : data_(data) {
+}
+
+uint8_t MessageReader::GetUint8() {
+    return static_cast<uint8_t>(Take(1)[0]);
+}
+
+uint32_t MessageReader::GetUint32() {
+    const string_view bytes = Take(4);
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) {
+        value = value << 8 | static_cast<uint8_t>(bytes[i]);
+    }
+    return value;
+}
+
+int32_t MessageReader::GetInt32() {
+    return static_cast<int32_t>(GetUint32());
+}
+
+uint64_t MessageReader::GetUint64() {
+    const uint64_t low = GetUint32();
+    return static_cast<uint64_t>(GetUint32()) << 32 | low;
+}
+
+double MessageReader::GetDouble() {
+    const uint64_t bits = GetUint64();
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+string_view MessageReader::GetString() {
+    return Take(GetUint32());
+}
+
+bool MessageReader::AtEnd() const {
+    return data_.empty();
+}
+
+string_view MessageReader::Take(size_t size) {
+    if (data_.size() < size) {
+        throw invalid_argument("Truncated message"s);
+    }
+    const string_view result = data_.substr(0, size);
+    data_.remove_prefix(size);
+    return result;
+}
+
+void AppendFrame(string& output, uint32_t request_id, MessageType type, string_view payload) {
+    MessageWriter header;
+    header.PutUint32(static_cast<uint32_t>(payload.size()));
+    header.PutUint32(request_id);
+    header.PutUint8(static_cast<uint8_t>(type));
+    output += header.GetData();
+    output += payload;
+}
+
+size_t ExtractFrame(string_view input, Frame& frame) {
+    if (input.size() < FRAME_HEADER_SIZE) {
+        return 0;
+    }
+    MessageReader header(input.substr(0, FRAME_HEADER_SIZE));
+    const uint32_t payload_size = header.GetUint32();
+    if (payload_size > MAX_FRAME_PAYLOAD_SIZE) {
+        throw invalid_argument("Frame of "s + to_string(payload_size) + " bytes is too large"s);
+    }
+    if (input.size() < FRAME_HEADER_SIZE + payload_size) {
+        return 0;
+    }
+    frame.request_id = header.GetUint32();
+    frame.type = static_cast<MessageType>(header.GetUint8());
+    frame.payload.assign(input.substr(FRAME_HEADER_SIZE, payload_size));
+    return FRAME_HEADER_SIZE + payload_size;
+}
+
+void WriteAttributeValue(MessageWriter& writer, const AttributeValue& value) {
+    writer.PutUint8(static_cast<uint8_t>(value.GetType()));
+    if (value.GetType() == AttributeType::INTEGER) {
+        writer.PutUint64(static_cast<uint64_t>(value.GetInteger()));
+    } else {
+        writer.PutDouble(value.GetReal());
+    }
+}
+
+AttributeValue ReadAttributeValue(MessageReader& reader) {
+    const uint8_t type = reader.GetUint8();
+    if (type == static_cast<uint8_t>(AttributeType::INTEGER)) {
+        return static_cast<int64_t>(reader.GetUint64());
+    }
+    if (type == static_cast<uint8_t>(AttributeType::REAL)) {
+        return reader.GetDouble();
+    }
+    throw invalid_argument("Unknown attribute type "s + to_string(type));
+}
+
+void WriteDocumentAttributes(MessageWriter& writer, const DocumentAttributes& attributes) {
+    writer.PutUint32(static_cast<uint32_t>(attributes.size()));
+    for (const auto& [name, value] : attributes) {
+        writer.PutString(name);
+        WriteAttributeValue(writer, value);
+    }
+}
+
+DocumentAttributes ReadDocumentAttributes(MessageReader& reader) {
+    DocumentAttributes attributes;
+    for (uint32_t count = reader.GetUint32(); count > 0; --count) {
+        const string_view name = reader.GetString();
+        attributes.emplace(name, ReadAttributeValue(reader));
+    }
+    return attributes;
+}
+
+void WriteDocumentFilter(MessageWriter& writer, const DocumentFilter& filter) {
+    uint8_t status_mask = 0;
+    if (filter.HasStatusRestriction()) {
+        for (size_t status = 0; status < DOCUMENT_STATUS_COUNT; ++status) {
+            if (filter.IsStatusAllowed(static_cast<DocumentStatus>(status))) {
+                status_mask |= 1u << status;
+            }
+        }
+    }
+    writer.PutUint8(status_mask);
+    writer.PutInt32(filter.GetMinRating());
+    writer.PutInt32(filter.GetMaxRating());
+    writer.PutUint32(static_cast<uint32_t>(filter.GetAttributeRanges().size()));
+    for (const AttributeRange& range : filter.GetAttributeRanges()) {
+        writer.PutString(range.name);
+        WriteAttributeValue(writer, range.min);
+        WriteAttributeValue(writer, range.max);
+    }
+}
+
+DocumentFilter ReadDocumentFilter(MessageReader& reader) {
+    DocumentFilter filter;
+    const uint8_t status_mask = reader.GetUint8();
+    for (size_t status = 0; status < DOCUMENT_STATUS_COUNT; ++status) {
+        if ((status_mask >> status) & 1) {
+            filter.AllowStatus(static_cast<DocumentStatus>(status));
+        }
+    }
+    filter.MinRating(reader.GetInt32());
+    filter.MaxRating(reader.GetInt32());
+    for (uint32_t count = reader.GetUint32(); count > 0; --count) {
+        const string_view name = reader.GetString();
+        const AttributeValue min = ReadAttributeValue(reader);
+        filter.AttributeBetween(name, min, ReadAttributeValue(reader));
+    }
+    return filter;
+}
+
+namespace {
+
+void WriteExpansions(MessageWriter& writer, const TermStatistics::Expansions& expansions) {
+    writer.PutUint32(static_cast<uint32_t>(expansions.size()));
+    for (const auto& [query_word, words] : expansions) {
+        writer.PutString(query_word);
+        writer.PutUint32(static_cast<uint32_t>(words.size()));
+        for (const auto& [word, distance] : words) {
+            writer.PutString(word);
+            writer.PutUint8(static_cast<uint8_t>(distance));
+        }
+    }
+}
+
+TermStatistics::Expansions ReadExpansions(MessageReader& reader) {
+    TermStatistics::Expansions expansions;
+    const uint32_t query_word_count = reader.GetUint32();
+    for (uint32_t i = 0; i < query_word_count; ++i) {
+        auto& words = expansions[string(reader.GetString())];
+        const uint32_t word_count = reader.GetUint32();
+        for (uint32_t j = 0; j < word_count; ++j) {
+            const string_view word = reader.GetString();
+            words.emplace(word, reader.GetUint8());
+        }
+    }
+    return expansions;
+}
+
+}  // namespace
+
+void WriteTermStatistics(MessageWriter& writer, const TermStatistics& statistics) {
+    writer.PutUint64(statistics.document_count);
+    writer.PutUint32(static_cast<uint32_t>(statistics.document_freqs.size()));
+    for (const auto& [word, document_freq] : statistics.document_freqs) {
+        writer.PutString(word);
+        writer.PutUint64(document_freq);
+    }
+    WriteExpansions(writer, statistics.prefix_expansions);
+    WriteExpansions(writer, statistics.fuzzy_expansions);
+}
+
+TermStatistics ReadTermStatistics(MessageReader& reader) {
+    TermStatistics statistics;
+    statistics.document_count = reader.GetUint64();
+    const uint32_t word_count = reader.GetUint32();
+    for (uint32_t i = 0; i < word_count; ++i) {
+        const string_view word = reader.GetString();
+        statistics.document_freqs.emplace(word, reader.GetUint64());
+    }
+    statistics.prefix_expansions = ReadExpansions(reader);
+    statistics.fuzzy_expansions = ReadExpansions(reader);
+    return statistics;
+}
+
+void WriteDocuments(MessageWriter& writer, const vector<Document>& documents) {
+    writer.PutUint32(static_cast<uint32_t>(documents.size()));
+    for (const Document& document : documents) {
+        writer.PutInt32(document.id);
+        writer.PutDouble(document.relevance);
+        writer.PutInt32(document.rating);
+    }
+}
+
+vector<Document> ReadDocuments(MessageReader& reader) {
+    const uint32_t document_count = reader.GetUint32();
+    vector<Document> documents;
+    for (uint32_t i = 0; i < document_count; ++i) {
+        const int id = reader.GetInt32();
+        const double relevance = reader.GetDouble();
+        documents.emplace_back(id, relevance, reader.GetInt32());
+    }
+    return documents;
+}
+
+void ThrowError(string_view payload) {
+    MessageReader reader(payload);
+    const auto code = static_cast<ErrorCode>(reader.GetUint8());
+    const string message(reader.GetString());
+    switch (code) {
+        case ErrorCode::INVALID_ARGUMENT:
+            throw invalid_argument(message);
+        case ErrorCode::OUT_OF_RANGE:
+            throw out_of_range(message);
+        default:
+            throw runtime_error(message);
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "attributes.h"
+#include "document.h"
+#include "document_filter.h"
+#include "term_statistics.h"
+
+// Binary protocol between ShardBroker and ShardServer. Every message is a frame:
+// payload size (u32), request id (u32), message type (u8), payload. Integers are little-endian.
+// A response carries the id and the type of its request, or ERROR. Responses on one connection
+// come in the order of requests, so a client may send many requests before reading the replies
+
+enum class MessageType : uint8_t {
+    // query -> TermStatistics
+    TERM_STATISTICS = 1,
+    // query, DocumentFilter, TermStatistics -> documents
+    FIND_TOP_DOCUMENTS = 2,
+    // id, text, status, ratings, attributes -> nothing
+    ADD_DOCUMENT = 3,
+    // id -> nothing
+    REMOVE_DOCUMENT = 4,
+    // nothing -> u64
+    DOCUMENT_COUNT = 5,
+    // ErrorCode, message
+    ERROR = 255,
+};
+
+// Exception classes a shard reports back, so the broker rethrows what SearchServer threw
+enum class ErrorCode : uint8_t {
+    INVALID_ARGUMENT = 1,
+    OUT_OF_RANGE = 2,
+    INTERNAL = 3,
+};
+
+const size_t FRAME_HEADER_SIZE = 9;
+const size_t MAX_FRAME_PAYLOAD_SIZE = 64 << 20;
+
+struct Frame {
+    uint32_t request_id = 0;
+    MessageType type = MessageType::ERROR;
+    std::string payload;
+};
+
+class MessageWriter {
+public:
+    void PutUint8(uint8_t value);
+
+    void PutUint32(uint32_t value);
+
+    void PutInt32(int32_t value);
+
+    void PutUint64(uint64_t value);
+
+    void PutDouble(double value);
+
+    void PutString(std::string_view value);
+
+    const std::string& GetData() const;
+
+    // Starts a new message in the same buffer
+    void Clear();
+
+private:
+    std::string data_;
+};
+
+// Throws invalid_argument when the data ends before a value
+class MessageReader {
+public:
+    explicit MessageReader(std::string_view data);
+
+    uint8_t GetUint8();
+
+    uint32_t GetUint32();
+
+    int32_t GetInt32();
+
+    uint64_t GetUint64();
+
+    double GetDouble();
+
+    std::string_view GetString();
+
+    bool AtEnd() const;
+
+private:
+    std::string_view data_;
+
+    std::string_view Take(size_t size);
+};
+
+void AppendFrame(std::string& output, uint32_t request_id, MessageType type, std::string_view payload);
+
+// Returns the size of the frame at the start of input, or 0 if it has not arrived completely.
+// Throws invalid_argument for a payload larger than MAX_FRAME_PAYLOAD_SIZE
+size_t ExtractFrame(std::string_view input, Frame& frame);
+
+// Type (u8) and the value as u64 bits
+void WriteAttributeValue(MessageWriter& writer, const AttributeValue& value);
+
+AttributeValue ReadAttributeValue(MessageReader& reader);
+
+void WriteDocumentAttributes(MessageWriter& writer, const DocumentAttributes& attributes);
+
+DocumentAttributes ReadDocumentAttributes(MessageReader& reader);
+
+void WriteDocumentFilter(MessageWriter& writer, const DocumentFilter& filter);
+
+DocumentFilter ReadDocumentFilter(MessageReader& reader);
+
+void WriteTermStatistics(MessageWriter& writer, const TermStatistics& statistics);
+
+TermStatistics ReadTermStatistics(MessageReader& reader);
+
+void WriteDocuments(MessageWriter& writer, const std::vector<Document>& documents);
+
+std::vector<Document> ReadDocuments(MessageReader& reader);
+
+// Throws the exception described by the payload of an ERROR frame
+[[noreturn]] void ThrowError(std::string_view payload);
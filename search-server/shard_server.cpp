@@ -0,0 +1,195 @@
+#include "shard_server.h"
+
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+ShardServer::ShardServer(SearchServer& server, const string& socket_path)
+    : server_(server)
+    , socket_path_(socket_path)
+    , listener_(ListenUnixSocket(socket_path)) {
+    int stop_pipe[2];
+    if (pipe2(stop_pipe, O_NONBLOCK | O_CLOEXEC) < 0) {
+        throw system_error(errno, generic_category(), "pipe"s);
+    }
+    stop_read_ = UniqueFd(stop_pipe[0]);
+    stop_write_ = UniqueFd(stop_pipe[1]);
+}
+
+ShardServer::~ShardServer() {
+    unlink(socket_path_.c_str());
+}
+
+void ShardServer::Serve() {
+    vector<pollfd> poll_fds;
+    while (true) {
+        poll_fds.clear();
+        poll_fds.push_back({stop_read_.Get(), POLLIN, 0});
+        poll_fds.push_back({listener_.Get(), POLLIN, 0});
+        for (const Client& client : clients_) {
+            const size_t pending_output = client.output.size() - client.output_offset;
+            short events = !client.input_closed && pending_output < MAX_PENDING_OUTPUT ? POLLIN : 0;
+            if (pending_output > 0) {
+                events |= POLLOUT;
+            }
+            poll_fds.push_back({client.socket.Get(), events, 0});
+        }
+        if (poll(poll_fds.data(), poll_fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw system_error(errno, generic_category(), "poll"s);
+        }
+        if (poll_fds[0].revents != 0) {
+            return;
+        }
+
+        // Clients accepted now are not in poll_fds yet, they are polled from the next round on
+        auto client = clients_.begin();
+        for (size_t i = 2; i < poll_fds.size(); ++i) {
+            const short revents = poll_fds[i].revents;
+            bool is_open = true;
+            if (revents & (POLLIN | POLLHUP | POLLERR)) {
+                is_open = ReadRequests(*client);
+            }
+            if (is_open && client->output.size() > client->output_offset) {
+                is_open = WriteResponses(*client);
+            }
+            if (is_open && client->input_closed && client->output.empty()) {
+                is_open = false;
+            }
+            client = is_open ? next(client) : clients_.erase(client);
+        }
+        if (poll_fds[1].revents != 0) {
+            AcceptClients();
+        }
+    }
+}
+
+void ShardServer::Stop() {
+    const char byte = 0;
+    // The pipe holding a byte already is as good as a successful write
+    [[maybe_unused]] const ssize_t written = write(stop_write_.Get(), &byte, 1);
+}
+
+void ShardServer::AcceptClients() {
+    while (true) {
+        UniqueFd socket = AcceptConnection(listener_);
+        if (socket.Get() < 0) {
+            return;
+        }
+        clients_.push_back({move(socket), {}, {}, 0});
+    }
+}
+
+bool ShardServer::ReadRequests(Client& client) {
+    char buffer[64 * 1024];
+    while (true) {
+        const ssize_t size = read(client.socket.Get(), buffer, sizeof(buffer));
+        if (size > 0) {
+            client.input.append(buffer, size);
+            continue;
+        }
+        if (size == 0) {
+            client.input_closed = true;
+            break;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        return false;
+    }
+
+    size_t offset = 0;
+    Frame request;
+    try {
+        while (const size_t frame_size = ExtractFrame(string_view(client.input).substr(offset), request)) {
+            offset += frame_size;
+            HandleRequest(request, client.output);
+        }
+    } catch (const invalid_argument&) {
+        // The frame boundaries are lost, nothing else can be read from this client
+        return false;
+    }
+    client.input.erase(0, offset);
+    return true;
+}
+
+bool ShardServer::WriteResponses(Client& client) {
+    while (client.output_offset < client.output.size()) {
+        const ssize_t size = send(client.socket.Get(), client.output.data() + client.output_offset,
+                                  client.output.size() - client.output_offset, MSG_NOSIGNAL);
+        if (size >= 0) {
+            client.output_offset += size;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return true;
+        } else if (errno != EINTR) {
+            return false;
+        }
+    }
+    client.output.clear();
+    client.output_offset = 0;
+    return true;
+}
+
+void ShardServer::HandleRequest(const Frame& request, string& output) {
+    MessageWriter error;
+    try {
+        AppendFrame(output, request.request_id, request.type, Execute(request));
+        return;
+    } catch (const invalid_argument& e) {
+        error.PutUint8(static_cast<uint8_t>(ErrorCode::INVALID_ARGUMENT));
+        error.PutString(e.what());
+    } catch (const out_of_range& e) {
+        error.PutUint8(static_cast<uint8_t>(ErrorCode::OUT_OF_RANGE));
+        error.PutString(e.what());
+    } catch (const exception& e) {
+        error.PutUint8(static_cast<uint8_t>(ErrorCode::INTERNAL));
+        error.PutString(e.what());
+    }
+    AppendFrame(output, request.request_id, MessageType::ERROR, error.GetData());
+}
+
+string ShardServer::Execute(const Frame& request) {
+    MessageReader reader(request.payload);
+    MessageWriter response;
+    if (request.type == MessageType::TERM_STATISTICS) {
+        WriteTermStatistics(response, server_.GetTermStatistics(reader.GetString()));
+    } else if (request.type == MessageType::FIND_TOP_DOCUMENTS) {
+        const string_view raw_query = reader.GetString();
+        const DocumentFilter filter = ReadDocumentFilter(reader);
+        const TermStatistics statistics = ReadTermStatistics(reader);
+        WriteDocuments(response, server_.FindTopDocuments(raw_query, filter, statistics));
+    } else if (request.type == MessageType::ADD_DOCUMENT) {
+        const int document_id = reader.GetInt32();
+        const string_view document = reader.GetString();
+        const uint8_t status = reader.GetUint8();
+        if (status >= DOCUMENT_STATUS_COUNT) {
+            throw invalid_argument("Unknown document status "s + to_string(status));
+        }
+        vector<int> ratings;
+        for (uint32_t rating_count = reader.GetUint32(); rating_count > 0; --rating_count) {
+            ratings.push_back(reader.GetInt32());
+        }
+        server_.AddDocument(document_id, document, static_cast<DocumentStatus>(status), ratings,
+                            ReadDocumentAttributes(reader));
+    } else if (request.type == MessageType::REMOVE_DOCUMENT) {
+        server_.RemoveDocument(reader.GetInt32());
+    } else if (request.type == MessageType::DOCUMENT_COUNT) {
+        response.PutUint64(server_.GetDocumentCount());
+    } else {
+        throw invalid_argument("Unknown message type "s + to_string(static_cast<int>(request.type)));
+    }
+    return response.GetData();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <list>
+#include <string>
+
+#include "search_server.h"
+#include "shard_protocol.h"
+#include "socket_util.h"
+
+// Serves one SearchServer over the shard protocol on a Unix-domain socket. One thread runs
+// Serve(): it multiplexes all connections with poll() and answers the requests of every
+// connection in order, so clients may pipeline them
+class ShardServer {
+public:
+    // Listens from construction on, so clients may connect before Serve() starts
+    ShardServer(SearchServer& server, const std::string& socket_path);
+
+    ShardServer(const ShardServer&) = delete;
+    ShardServer& operator=(const ShardServer&) = delete;
+
+    ~ShardServer();
+
+    // Returns after Stop()
+    void Serve();
+
+    // Safe to call from other threads and from signal handlers
+    void Stop();
+
+private:
+    struct Client {
+        UniqueFd socket;
+        std::string input;
+        std::string output;
+        size_t output_offset = 0;
+        // The client sent everything; the connection closes once the responses are flushed
+        bool input_closed = false;
+    };
+
+    // A client which does not read its responses stops being read until it catches up
+    static const size_t MAX_PENDING_OUTPUT = 1 << 20;
+
+    SearchServer& server_;
+    std::string socket_path_;
+    UniqueFd listener_;
+    UniqueFd stop_read_;
+    UniqueFd stop_write_;
+    std::list<Client> clients_;
+
+    void AcceptClients();
+
+    // Both return false when the connection has to be closed. Requests which arrive together
+    // with the end of input are still answered
+    bool ReadRequests(Client& client);
+
+    bool WriteResponses(Client& client);
+
+    void HandleRequest(const Frame& request, std::string& output);
+
+    std::string Execute(const Frame& request);
+};
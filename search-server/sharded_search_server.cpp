@@ -0,0 +1,138 @@
+#include "sharded_search_server.h"
+
+#include <algorithm>
+#include <execution>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std;
+
+size_t SelectShard(int document_id, size_t shard_count) {
+    const uint64_t hash = static_cast<uint32_t>(document_id) * 0x9E3779B97F4A7C15ull;
+    return (hash >> 32) % shard_count;
+}
+
+ShardedSearchServer::Shard::Shard(const string& stop_words_text, const IndexOptions& options, size_t core)
+    : server_(stop_words_text, options)
+    , thread_([this] {
+        Run();
+    }) {
+#ifdef __linux__
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(core, &cpus);
+    // Pinning is an optimization only, a restricted affinity mask of the process is not an error
+    pthread_setaffinity_np(thread_.native_handle(), sizeof(cpus), &cpus);
+#endif
+}
+
+ShardedSearchServer::Shard::~Shard() {
+    {
+        lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    has_tasks_.notify_one();
+    thread_.join();
+}
+
+void ShardedSearchServer::Shard::Run() {
+    while (true) {
+        function<void()> task;
+        {
+            unique_lock lock(mutex_);
+            has_tasks_.wait(lock, [this] {
+                return stopping_ || !tasks_.empty();
+            });
+            if (tasks_.empty()) {
+                return;
+            }
+            task = move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+ShardedSearchServer::ShardedSearchServer(const string& stop_words_text, size_t shard_count, const IndexOptions& options)
+    : options_(options) {
+    const size_t core_count = max(1u, thread::hardware_concurrency());
+    if (shard_count == 0) {
+        shard_count = core_count;
+    }
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_.push_back(make_unique<Shard>(stop_words_text, options, i % core_count));
+    }
+}
+
+future<void> ShardedSearchServer::AddDocument(int document_id, const string_view& document, DocumentStatus status,
+                                              const vector<int>& ratings, const DocumentAttributes& attributes) {
+    unique_lock lock(submit_mutex_);
+    return GetShard(document_id).Submit([document_id, document = string(document), status, ratings, attributes](SearchServer& server) {
+        server.AddDocument(document_id, document, status, ratings, attributes);
+    });
+}
+
+future<void> ShardedSearchServer::RemoveDocument(int document_id) {
+    unique_lock lock(submit_mutex_);
+    return GetShard(document_id).Submit([document_id](SearchServer& server) {
+        server.RemoveDocument(document_id);
+    });
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(const string_view& raw_query, const DocumentFilter& filter) const {
+    // Shard queues run tasks in order of submission, so writes submitted before the query are seen by
+    // both rounds and writes submitted after it by none
+    shared_lock lock(submit_mutex_);
+    TermStatistics statistics;
+    for (const TermStatistics& shard_statistics : Scatter([&raw_query](SearchServer& server) {
+             return server.GetTermStatistics(raw_query);
+         })) {
+        statistics += shard_statistics;
+    }
+    statistics.LimitExpansions(options_.max_prefix_expansions, options_.max_fuzzy_expansions);
+    // Workers are pinned one per core, so each shard searches sequentially and the shards are the parallelism
+    vector<Document> documents;
+    for (const vector<Document>& shard_documents : Scatter([&](SearchServer& server) {
+             return server.FindTopDocuments(execution::seq, raw_query, filter, statistics);
+         })) {
+        documents.insert(documents.end(), shard_documents.begin(), shard_documents.end());
+    }
+    lock.unlock();
+    // Every shard returns its own top, the global top is among them
+    const size_t result_size = min<size_t>(documents.size(), MAX_RESULT_DOCUMENT_COUNT);
+    partial_sort(documents.begin(), documents.begin() + result_size, documents.end(), RanksBefore);
+    documents.resize(result_size);
+    return documents;
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(const string_view& raw_query, DocumentStatus status) const {
+    return FindTopDocuments(raw_query, DocumentFilter(status));
+}
+
+tuple<vector<string>, DocumentStatus> ShardedSearchServer::MatchDocument(const string_view& raw_query, int document_id) const {
+    return GetShard(document_id).Submit([&raw_query, document_id](SearchServer& server) {
+        const auto [words, status] = server.MatchDocument(raw_query, document_id);
+        return tuple<vector<string>, DocumentStatus>(vector<string>(words.begin(), words.end()), status);
+    }).get();
+}
+
+int ShardedSearchServer::GetDocumentCount() const {
+    int document_count = 0;
+    for (const int shard_document_count : Scatter([](SearchServer& server) {
+             return server.GetDocumentCount();
+         })) {
+        document_count += shard_document_count;
+    }
+    return document_count;
+}
+
+size_t ShardedSearchServer::GetShardCount() const {
+    return shards_.size();
+}
+
+ShardedSearchServer::Shard& ShardedSearchServer::GetShard(int document_id) const {
+    return *shards_[SelectShard(document_id, shards_.size())];
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "search_server.h"
+
+// Shard of a document among shard_count shards. Fibonacci hashing spreads sequential ids evenly
+size_t SelectShard(int document_id, size_t shard_count);
+
+// Search server partitioned by document id into shards. Every shard is a SearchServer owned by
+// its own worker thread pinned to a core, so indexing scales across cores and shards never lock.
+// Queries are scattered to all shards in two rounds: the first one collects document frequencies,
+// the second one scores with them, so rankings are the same as on a single SearchServer. The first
+// round also collects all words of prefixes and misspelled words, and the second one scores the
+// words chosen from them for the whole collection. Every shard searches sequentially, a query runs
+// in parallel across the shards only
+class ShardedSearchServer {
+public:
+    // Zero shard_count means one shard per hardware thread
+    explicit ShardedSearchServer(const std::string& stop_words_text, size_t shard_count = 0,
+                                 const IndexOptions& options = IndexOptions());
+
+    ShardedSearchServer(const ShardedSearchServer&) = delete;
+    ShardedSearchServer& operator=(const ShardedSearchServer&) = delete;
+
+    // Indexing is asynchronous; the future throws the errors of SearchServer::AddDocument.
+    // Later requests to the same shard see the document anyway. Submitting waits for the queries
+    // being submitted, so no shard changes between the two rounds of a query. A steady stream of
+    // queries may delay writers, the standard library does not promise writer priority
+    std::future<void> AddDocument(int document_id, const std::string_view& document, DocumentStatus status,
+                                  const std::vector<int>& ratings, const DocumentAttributes& attributes = DocumentAttributes());
+
+    std::future<void> RemoveDocument(int document_id);
+
+    std::vector<Document> FindTopDocuments(const std::string_view& raw_query,
+                                           const DocumentFilter& filter = DocumentFilter(DocumentStatus::ACTUAL)) const;
+
+    std::vector<Document> FindTopDocuments(const std::string_view& raw_query, DocumentStatus status) const;
+
+    // Words are copied, since shards keep changing after the call
+    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::string_view& raw_query, int document_id) const;
+
+    int GetDocumentCount() const;
+
+    size_t GetShardCount() const;
+
+private:
+    class Shard {
+    public:
+        Shard(const std::string& stop_words_text, const IndexOptions& options, size_t core);
+
+        ~Shard();
+
+        // Runs func(server) on the shard thread after all previously submitted tasks
+        template <typename Func>
+        auto Submit(Func func) -> std::future<decltype(func(std::declval<SearchServer&>()))>;
+
+    private:
+        SearchServer server_;
+        std::mutex mutex_;
+        std::condition_variable has_tasks_;
+        std::deque<std::function<void()>> tasks_;
+        bool stopping_ = false;
+        std::thread thread_;
+
+        void Run();
+    };
+
+    IndexOptions options_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    // Held exclusively while a write is submitted and shared while both rounds of a query are
+    mutable std::shared_mutex submit_mutex_;
+
+    Shard& GetShard(int document_id) const;
+
+    // Runs func(server) on every shard and returns the results in the order of shards
+    template <typename Func>
+    auto Scatter(Func func) const -> std::vector<decltype(func(std::declval<SearchServer&>()))>;
+};
+
+template <typename Func>
+auto ShardedSearchServer::Shard::Submit(Func func) -> std::future<decltype(func(std::declval<SearchServer&>()))> {
+    using Result = decltype(func(std::declval<SearchServer&>()));
+    auto task = std::make_shared<std::packaged_task<Result()>>([this, func = std::move(func)]() mutable {
+        return func(server_);
+    });
+    std::future<Result> result = task->get_future();
+    {
+        std::lock_guard lock(mutex_);
+        tasks_.push_back([task] {
+            (*task)();
+        });
+    }
+    has_tasks_.notify_one();
+    return result;
+}
+
+template <typename Func>
+auto ShardedSearchServer::Scatter(Func func) const -> std::vector<decltype(func(std::declval<SearchServer&>()))> {
+    using Result = decltype(func(std::declval<SearchServer&>()));
+    std::vector<std::future<Result>> futures;
+    for (const auto& shard : shards_) {
+        futures.push_back(shard->Submit(func));
+    }
+    // Tasks may refer to arguments of the caller, so all of them finish before any error is rethrown
+    for (const std::future<Result>& future : futures) {
+        future.wait();
+    }
+    std::vector<Result> results;
+    for (std::future<Result>& future : futures) {
+        results.push_back(future.get());
+    }
+    return results;
+}
@@ -0,0 +1,145 @@
+#include "socket_util.h"
+
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <utility>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+UniqueFd::UniqueFd(int fd)
+    : fd_(fd) {
+}
+
+UniqueFd::UniqueFd(UniqueFd&& other) noexcept
+    : fd_(exchange(other.fd_, -1)) {
+}
+
+UniqueFd& UniqueFd::operator=(UniqueFd&& other) noexcept {
+    if (this != &other) {
+        Reset();
+        fd_ = exchange(other.fd_, -1);
+    }
+    return *this;
+}
+
+UniqueFd::~UniqueFd() {
+    Reset();
+}
+
+int UniqueFd::Get() const {
+    return fd_;
+}
+
+void UniqueFd::Reset() {
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+namespace {
+
+sockaddr_un MakeAddress(const string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw system_error(ENAMETOOLONG, generic_category(), path);
+    }
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+UniqueFd MakeSocket(int domain = AF_UNIX) {
+    UniqueFd socket_fd(socket(domain, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0));
+    if (socket_fd.Get() < 0) {
+        throw system_error(errno, generic_category(), "socket"s);
+    }
+    return socket_fd;
+}
+
+sockaddr_in MakeAddress(const string& address, uint16_t port) {
+    sockaddr_in result{};
+    result.sin_family = AF_INET;
+    result.sin_port = htons(port);
+    if (inet_pton(AF_INET, address.c_str(), &result.sin_addr) != 1) {
+        throw system_error(EINVAL, generic_category(), address);
+    }
+    return result;
+}
+
+}  // namespace
+
+UniqueFd ListenUnixSocket(const string& path) {
+    const sockaddr_un address = MakeAddress(path);
+    UniqueFd listener = MakeSocket();
+    unlink(path.c_str());
+    if (bind(listener.Get(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+        throw system_error(errno, generic_category(), "bind "s + path);
+    }
+    if (listen(listener.Get(), SOMAXCONN) < 0) {
+        throw system_error(errno, generic_category(), "listen "s + path);
+    }
+    return listener;
+}
+
+UniqueFd ConnectUnixSocket(const string& path) {
+    const sockaddr_un address = MakeAddress(path);
+    UniqueFd connection = MakeSocket();
+    // Unix sockets connect at once or fail with EAGAIN when the backlog of the listener is full
+    if (connect(connection.Get(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+        throw system_error(errno, generic_category(), "connect "s + path);
+    }
+    return connection;
+}
+
+UniqueFd AcceptConnection(const UniqueFd& listener) {
+    UniqueFd connection(accept4(listener.Get(), nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC));
+    if (connection.Get() < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != ECONNABORTED) {
+        throw system_error(errno, generic_category(), "accept"s);
+    }
+    return connection;
+}
+
+UniqueFd ListenTcpSocket(const string& address, uint16_t port) {
+    const sockaddr_in socket_address = MakeAddress(address, port);
+    UniqueFd listener = MakeSocket(AF_INET);
+    const int enable = 1;
+    setsockopt(listener.Get(), SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    if (bind(listener.Get(), reinterpret_cast<const sockaddr*>(&socket_address), sizeof(socket_address)) < 0) {
+        throw system_error(errno, generic_category(), "bind "s + address);
+    }
+    if (listen(listener.Get(), SOMAXCONN) < 0) {
+        throw system_error(errno, generic_category(), "listen "s + address);
+    }
+    return listener;
+}
+
+UniqueFd ConnectTcpSocket(const string& address, uint16_t port) {
+    const sockaddr_in socket_address = MakeAddress(address, port);
+    UniqueFd connection = MakeSocket(AF_INET);
+    if (connect(connection.Get(), reinterpret_cast<const sockaddr*>(&socket_address), sizeof(socket_address)) < 0
+        && errno != EINPROGRESS) {
+        throw system_error(errno, generic_category(), "connect "s + address);
+    }
+    // Requests and responses are small, batching them is up to the caller
+    const int enable = 1;
+    setsockopt(connection.Get(), IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    return connection;
+}
+
+uint16_t GetLocalPort(const UniqueFd& socket) {
+    sockaddr_in address{};
+    socklen_t size = sizeof(address);
+    if (getsockname(socket.Get(), reinterpret_cast<sockaddr*>(&address), &size) < 0) {
+        throw system_error(errno, generic_category(), "getsockname"s);
+    }
+    return ntohs(address.sin_port);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Owner of a file descriptor, closes it on destruction
+class UniqueFd {
+public:
+    UniqueFd() = default;
+
+    explicit UniqueFd(int fd);
+
+    UniqueFd(UniqueFd&& other) noexcept;
+
+    UniqueFd& operator=(UniqueFd&& other) noexcept;
+
+    ~UniqueFd();
+
+    int Get() const;
+
+    void Reset();
+
+private:
+    int fd_ = -1;
+};
+
+// Socket functions throw system_error. Sockets are non-blocking and close on exec
+
+// Replaces a stale socket file left at path
+UniqueFd ListenUnixSocket(const std::string& path);
+
+UniqueFd ConnectUnixSocket(const std::string& path);
+
+// Accepts from Unix and TCP listeners alike. Returns an empty UniqueFd when no connection is pending
+UniqueFd AcceptConnection(const UniqueFd& listener);
+
+// IPv4 TCP counterparts; port 0 asks the system for a free port
+UniqueFd ListenTcpSocket(const std::string& address, uint16_t port);
+
+// The connection may still be in progress, it is established once the socket is writable
+UniqueFd ConnectTcpSocket(const std::string& address, uint16_t port);
+
+uint16_t GetLocalPort(const UniqueFd& socket);
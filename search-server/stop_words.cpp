@@ -0,0 +1,51 @@
+#include "stop_words.h"
+
+#include <cstring>
+
+using namespace std;
+
+StopWords::StopWords(const set<string, less<>>& words) {
+    size_t capacity = 1;
+    // At most a half of the slots is used, so probe sequences stay short
+    while (capacity < 2 * words.size()) {
+        capacity *= 2;
+    }
+    slots_.resize(capacity);
+    for (const string& word : words) {
+        if (word.empty()) {
+            continue;
+        }
+        const uint64_t hash = Hash(word);
+        size_t index = hash & (capacity - 1);
+        while (slots_[index].length != 0) {
+            index = (index + 1) & (capacity - 1);
+        }
+        slots_[index] = {hash, static_cast<uint32_t>(words_.size()), static_cast<uint32_t>(word.size())};
+        words_ += word;
+        length_mask_ |= uint64_t(1) << min(word.size(), MAX_MASKED_LENGTH);
+        ++size_;
+    }
+}
+
+size_t StopWords::Size() const {
+    return size_;
+}
+
+uint64_t StopWords::Hash(string_view word) {
+    // The first and the last 8 bytes (overlapping for short words) mixed with the length,
+    // then the whole word for long ones
+    uint64_t head = 0;
+    uint64_t tail = 0;
+    const size_t chunk = min<size_t>(word.size(), sizeof(uint64_t));
+    memcpy(&head, word.data(), chunk);
+    memcpy(&tail, word.data() + word.size() - chunk, chunk);
+    uint64_t hash = word.size() * 0x9E3779B97F4A7C15ull ^ head * 0xC2B2AE3D27D4EB4Full ^ tail * 0x165667B19E3779F9ull;
+    for (size_t i = 2 * sizeof(uint64_t); i < word.size(); i += sizeof(uint64_t)) {
+        uint64_t middle = 0;
+        memcpy(&middle, word.data() + i - sizeof(uint64_t), sizeof(uint64_t));
+        hash = (hash ^ middle) * 0xFF51AFD7ED558CCDull;
+    }
+    hash ^= hash >> 29;
+    hash *= 0xBF58476D1CE4E5B9ull;
+    return hash ^ (hash >> 32);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Immutable set of stop words built for fast rejection of ordinary words.
+// A bitmask of word lengths rejects most words without hashing them, the rest is looked up
+// in an open addressing table whose slots keep the full hash, so a word is compared at most
+// with the stop words of the same hash
+class StopWords {
+public:
+    StopWords() = default;
+
+    explicit StopWords(const std::set<std::string, std::less<>>& words);
+
+    bool Contains(std::string_view word) const;
+
+    size_t Size() const;
+
+private:
+    struct Slot {
+        uint64_t hash = 0;
+        uint32_t offset = 0;
+        // Zero for an empty slot
+        uint32_t length = 0;
+    };
+
+    // Words of length from 63 share the last bit
+    static constexpr size_t MAX_MASKED_LENGTH = 63;
+
+    // All stop words back to back, referenced by the slots
+    std::string words_;
+    std::vector<Slot> slots_;
+    uint64_t length_mask_ = 0;
+    size_t size_ = 0;
+
+    static uint64_t Hash(std::string_view word);
+};
+
+inline bool StopWords::Contains(std::string_view word) const {
+    const size_t length_bit = word.size() < MAX_MASKED_LENGTH ? word.size() : MAX_MASKED_LENGTH;
+    if (((length_mask_ >> length_bit) & 1) == 0) {
+        return false;
+    }
+    const uint64_t hash = Hash(word);
+    const size_t slot_mask = slots_.size() - 1;
+    for (size_t index = hash & slot_mask;; index = (index + 1) & slot_mask) {
+        const Slot& slot = slots_[index];
+        if (slot.length == 0) {
+            return false;
+        }
+        if (slot.hash == hash && slot.length == word.size()
+            && std::string_view(words_.data() + slot.offset, slot.length) == word) {
+            return true;
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#include "term_statistics.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "query_plan.h"
+
+using namespace std;
+
+namespace {
+
+void AddExpansions(TermStatistics::Expansions& expansions, const TermStatistics::Expansions& other) {
+    for (const auto& [query_word, words] : other) {
+        expansions[query_word].insert(words.begin(), words.end());
+    }
+}
+
+}  // namespace
+
+TermStatistics& TermStatistics::operator+=(const TermStatistics& other) {
+    document_count += other.document_count;
+    for (const auto& [word, document_freq] : other.document_freqs) {
+        document_freqs[word] += document_freq;
+    }
+    AddExpansions(prefix_expansions, other.prefix_expansions);
+    AddExpansions(fuzzy_expansions, other.fuzzy_expansions);
+    return *this;
+}
+
+void TermStatistics::LimitExpansions(size_t max_prefix_expansions, size_t max_fuzzy_expansions) {
+    const auto limit = [this](Expansions& expansions, size_t max_expansions) {
+        for (auto& [query_word, words] : expansions) {
+            if (words.size() <= max_expansions) {
+                continue;
+            }
+            vector<QueryPlan::Term> terms;
+            for (const auto& [word, distance] : words) {
+                terms.push_back({word, document_freqs.at(word), distance});
+            }
+            nth_element(terms.begin(), terms.begin() + max_expansions, terms.end(), IsPreferredExpansion);
+            map<string, int, less<>> kept;
+            for (auto it = terms.begin(); it != terms.begin() + max_expansions; ++it) {
+                kept.emplace(it->word, it->distance);
+            }
+            words = move(kept);
+        }
+    };
+    limit(prefix_expansions, max_prefix_expansions);
+    limit(fuzzy_expansions, max_fuzzy_expansions);
+}
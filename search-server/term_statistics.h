@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+// Collection statistics of the words of a query. Statistics of several servers holding
+// parts of one collection add up to the statistics of the whole collection
+struct TermStatistics {
+    // Dictionary words every query word expands to, with their edit distances
+    using Expansions = std::map<std::string, std::map<std::string, int, std::less<>>, std::less<>>;
+
+    size_t document_count = 0;
+    std::map<std::string, size_t, std::less<>> document_freqs;
+    // All words of the prefixes and misspelled plus words, since a part of the collection cannot
+    // tell which of them are within the caps. Their counts are in document_freqs
+    Expansions prefix_expansions;
+    Expansions fuzzy_expansions;
+
+    TermStatistics& operator+=(const TermStatistics& other);
+
+    // Keeps the expansions a single server holding the whole collection would choose
+    void LimitExpansions(size_t max_prefix_expansions, size_t max_fuzzy_expansions);
+};
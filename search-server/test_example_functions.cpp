@@ -1,9 +1,29 @@
 #include "test_example_functions.h"
 #include "search_server.h"
+#include "sharded_search_server.h"
+#include "shard_broker.h"
+#include "shard_server.h"
+#include "search_frontend.h"
+#include "request_queue.h"
+#include "query_log.h"
 
 #include <algorithm>
 #include <numeric>
 #include <cmath>
+#include <execution>
+#include <chrono>
+#include <sstream>
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+#include <deque>
+#include <memory_resource>
+#include <limits>
+#include <thread>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -20,6 +40,26 @@ void AssertImpl(bool value, const string& expr_str, const string& file, const st
     }
 }
 
+vector<int> GetIds(const vector<Document>& documents) {
+    vector<int> result;
+    for (const Document& document : documents) {
+        result.push_back(document.id);
+    }
+    return result;
+}
+
+vector<int> GetSortedIds(const vector<Document>& documents) {
+    vector<int> result = GetIds(documents);
+    sort(result.begin(), result.end());
+    return result;
+}
+
+bool HaveSameResults(const vector<Document>& lhs, const vector<Document>& rhs) {
+    return lhs.size() == rhs.size() && equal(lhs.begin(), lhs.end(), rhs.begin(), [](const Document& l, const Document& r) {
+        return l.id == r.id && l.rating == r.rating && abs(l.relevance - r.relevance) < EPS;
+    });
+}
+
 // Тест проверяет исключение документов содержащих минус слова
 void TestFindTopDocumentsMinusWords() {
     const int doc_id = 42;
@@ -220,6 +260,1342 @@ void TestExcludeStopWordsFromAddedDocumentContent() {
     }
 }
 
+// Тест проверяет частоты слов документа и их удаление вместе с документом
+void TestGetWordFrequencies() {
+    SearchServer server("in the"s);
+    server.AddDocument(1, "white cat and white dog in the city"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "black dog"s, DocumentStatus::ACTUAL, {2});
+
+    // Слова возвращаются в лексикографическом порядке, стоп-слова не учитываются
+    {
+        vector<pair<string, double>> frequencies;
+        for (const auto [word, freq] : server.GetWordFrequencies(1)) {
+            frequencies.push_back({string(word), freq});
+        }
+        const vector<pair<string, double>> expected = {
+            {"and"s, 1.0 / 6}, {"cat"s, 1.0 / 6}, {"city"s, 1.0 / 6}, {"dog"s, 1.0 / 6}, {"white"s, 2.0 / 6}};
+        ASSERT_EQUAL(frequencies.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_EQUAL(frequencies[i].first, expected[i].first);
+            ASSERT(abs(frequencies[i].second - expected[i].second) < EPS);
+        }
+    }
+
+    // Для несуществующего документа возвращается пустой набор
+    ASSERT(server.GetWordFrequencies(3).empty());
+
+    // После удаления документа его слова не находятся, а остальные документы не затронуты
+    {
+        server.RemoveDocument(1);
+        ASSERT(server.GetWordFrequencies(1).empty());
+        ASSERT(server.FindTopDocuments("white cat"s).empty());
+        ASSERT_EQUAL(server.GetWordFrequencies(2).size(), 2u);
+        ASSERT_EQUAL(server.FindTopDocuments("dog"s).size(), 1u);
+
+        server.RemoveDocument(execution::par, 2);
+        ASSERT_EQUAL(server.GetDocumentCount(), 0);
+        ASSERT(server.FindTopDocuments("dog"s).empty());
+    }
+}
+
+// Тест проверяет операции над сжатым битовым множеством
+void TestBitmap() {
+    // Разреженное и плотное множества с несколькими старшими ключами
+    Bitmap sparse;
+    Bitmap dense;
+    for (uint32_t value = 0; value < 200000; value += 3) {
+        sparse.Add(value * 7);
+        dense.Add(value);
+    }
+    ASSERT(sparse.Contains(21));
+    ASSERT(!sparse.Contains(22));
+    ASSERT(dense.Contains(199998));
+    ASSERT(!dense.Contains(199999));
+
+    Bitmap intersection = dense;
+    intersection &= sparse;
+    size_t expected_size = 0;
+    for (uint32_t value = 0; value < 200000; value += 3) {
+        expected_size += value % 7 == 0 && (value / 7) % 3 == 0;
+    }
+    ASSERT_EQUAL(intersection.Size(), expected_size);
+
+    Bitmap united = sparse;
+    united |= dense;
+    ASSERT_EQUAL(united.Size(), sparse.Size() + dense.Size() - intersection.Size());
+
+    vector<uint32_t> values;
+    intersection.ForEach([&values](uint32_t value) {
+        values.push_back(value);
+    });
+    ASSERT(is_sorted(values.begin(), values.end()));
+    ASSERT_EQUAL(values.size(), expected_size);
+
+    // Преобразование в обычный битовый массив и обратно сохраняет множество
+    const vector<uint64_t> bits = united.ToBitset(150000);
+    ASSERT_EQUAL(bits.size(), (150000u + 63) / 64);
+    ASSERT((bits[3 * 7 / 64] >> (3 * 7 % 64)) & 1);
+    ASSERT(!((bits[1] >> 1) & 1));
+    const Bitmap restored = Bitmap::FromBitset(bits);
+    Bitmap truncated = united;
+    for (uint32_t value = 150000; value < 1400000; ++value) {
+        truncated.Remove(value);
+    }
+    ASSERT_EQUAL(restored.Size(), truncated.Size());
+    Bitmap common = restored;
+    common &= truncated;
+    ASSERT_EQUAL(common.Size(), truncated.Size());
+
+    // Удаление всех элементов делает множество пустым
+    for (const uint32_t value : values) {
+        intersection.Remove(value);
+    }
+    ASSERT(intersection.Empty());
+}
+
+// Тест проверяет фильтрацию результатов поиска по статусу и диапазону рейтинга через DocumentFilter
+void TestFindTopDocumentsWithDocumentFilter() {
+    SearchServer server(""s);
+    server.AddDocument(1, "cat in the park"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "cat in the city"s, DocumentStatus::BANNED, {5});
+    server.AddDocument(3, "dog in the park"s, DocumentStatus::ACTUAL, {3});
+    server.AddDocument(4, "cat and dog"s, DocumentStatus::IRRELEVANT, {4});
+    server.AddDocument(5, "cat"s, DocumentStatus::ACTUAL, {7});
+
+    ASSERT_EQUAL(GetSortedIds(server.FindTopDocuments("cat dog"s, DocumentFilter())), vector<int>({1, 2, 3, 4, 5}));
+    ASSERT_EQUAL(GetSortedIds(server.FindTopDocuments("cat dog"s, DocumentFilter(DocumentStatus::ACTUAL))), vector<int>({1, 3, 5}));
+    ASSERT_EQUAL(GetSortedIds(server.FindTopDocuments("cat dog"s, DocumentFilter(DocumentStatus::ACTUAL).AllowStatus(DocumentStatus::BANNED))),
+                 vector<int>({1, 2, 3, 5}));
+    ASSERT_EQUAL(GetSortedIds(server.FindTopDocuments("cat dog"s, DocumentFilter().MinRating(3).MaxRating(5))), vector<int>({2, 3, 4}));
+
+    // Результаты совпадают с поиском по эквивалентному предикату
+    const DocumentFilter filter = DocumentFilter(DocumentStatus::ACTUAL).MinRating(2);
+    ASSERT_EQUAL(GetSortedIds(server.FindTopDocuments(execution::par, "cat dog -city"s, filter)), vector<int>({3, 5}));
+    ASSERT_EQUAL(GetSortedIds(server.FindTopDocuments("cat dog -city"s, [](int, DocumentStatus status, int rating) {
+                     return status == DocumentStatus::ACTUAL && rating >= 2;
+                 })), vector<int>({3, 5}));
+
+    // Удаленные документы не попадают в индексы статусов и рейтингов
+    server.RemoveDocument(5);
+    ASSERT_EQUAL(GetSortedIds(server.FindTopDocuments("cat"s, DocumentFilter().MinRating(6))), vector<int>());
+}
+
+// Тест проверяет, что идентификаторы документов перебираются по возрастанию независимо от порядка добавления
+void TestDocumentIdIteration() {
+    SearchServer server(""s);
+    for (const int id : {7, 3, 42, 0, 15}) {
+        server.AddDocument(id, "cat number "s + to_string(id), DocumentStatus::ACTUAL, {id});
+    }
+    server.RemoveDocument(42);
+    server.AddDocument(5, "dog"s, DocumentStatus::BANNED, {1});
+
+    const vector<int> ids(server.begin(), server.end());
+    ASSERT_EQUAL(ids, vector<int>({0, 3, 5, 7, 15}));
+    ASSERT_EQUAL(server.GetDocumentCount(), 5);
+
+    // Метаданные документов остаются привязанными к своим идентификаторам
+    const auto found = server.FindTopDocuments("cat number 15"s);
+    ASSERT(!found.empty());
+    ASSERT_EQUAL(found[0].id, 15);
+    ASSERT_EQUAL(found[0].rating, 15);
+    ASSERT(get<DocumentStatus>(server.MatchDocument("dog"s, 5)) == DocumentStatus::BANNED);
+}
+
+// Тест проверяет поиск после многократного добавления и удаления документов
+void TestAddRemoveCycles() {
+    SearchServer server(""s);
+    size_t metadata_bytes = 0;
+    for (int round = 0; round < 20; ++round) {
+        // В каждом раунде добавляется новая партия документов, а предыдущая удаляется
+        for (int i = 0; i < 50; ++i) {
+            const int id = round * 50 + i;
+            server.AddDocument(id, "cat word"s + to_string(i), i % 2 == 0 ? DocumentStatus::ACTUAL : DocumentStatus::BANNED, {id});
+        }
+        if (round > 0) {
+            for (int i = 0; i < 50; ++i) {
+                server.RemoveDocument((round - 1) * 50 + i);
+            }
+        }
+        ASSERT_EQUAL(server.GetDocumentCount(), 50);
+
+        const auto found = server.FindTopDocuments("word7"s, DocumentStatus::BANNED);
+        ASSERT_EQUAL(found.size(), 1u);
+        ASSERT_EQUAL(found[0].id, round * 50 + 7);
+        ASSERT_EQUAL(found[0].rating, round * 50 + 7);
+        ASSERT_EQUAL(GetSortedIds(server.FindTopDocuments("word4"s, DocumentFilter().MinRating(round * 50))),
+                     vector<int>({round * 50 + 4}));
+        ASSERT_EQUAL(server.GetWordFrequencies(round * 50 + 3).size(), 2u);
+        ASSERT(get<DocumentStatus>(server.MatchDocument("cat"s, round * 50 + 1)) == DocumentStatus::BANNED);
+
+        // Номера удаленных документов переиспользуются, поэтому память метаданных не растет
+        if (round == 3) {
+            metadata_bytes = server.GetMemoryStats().metadata.bytes;
+        } else if (round > 3) {
+            ASSERT(server.GetMemoryStats().metadata.bytes <= metadata_bytes);
+        }
+    }
+}
+
+// Тест проверяет поиск по фразам в кавычках и бонус за близость слов запроса
+void TestPhraseQueries() {
+    IndexOptions options;
+    options.store_positions = true;
+    SearchServer server("in the"s, options);
+    server.AddDocument(1, "white cat in the city"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "cat white and black"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(3, "black cat in the white city"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(4, "a white cat a white cat"s, DocumentStatus::ACTUAL, {1});
+
+    ASSERT_EQUAL(GetSortedIds(server.FindTopDocuments("\"white cat\""s)), vector<int>({1, 4}));
+    ASSERT_EQUAL(GetSortedIds(server.FindTopDocuments(execution::par, "\"white cat\" -city"s)), vector<int>({4}));
+    // Стоп-слова внутри фразы пропускаются, но их позиции учитываются
+    ASSERT_EQUAL(GetSortedIds(server.FindTopDocuments("\"cat in the city\""s)), vector<int>({1}));
+    ASSERT_EQUAL(GetSortedIds(server.FindTopDocuments("\"cat in the white\""s)), vector<int>({3}));
+    ASSERT(server.FindTopDocuments("\"city cat\""s).empty());
+
+    ASSERT_EQUAL(get<vector<string_view>>(server.MatchDocument("\"white cat\" black"s, 2)).size(), 0u);
+    ASSERT_EQUAL(get<vector<string_view>>(server.MatchDocument("\"white cat\" black"s, 1)).size(), 2u);
+
+    // Позиции удаленных документов не мешают поиску по фразам в оставшихся
+    server.RemoveDocument(4);
+    server.RemoveDocument(execution::par, 2);
+    ASSERT_EQUAL(GetSortedIds(server.FindTopDocuments("\"white cat\""s)), vector<int>({1}));
+
+    try {
+        server.FindTopDocuments("\"white cat"s);
+        ASSERT_HINT(false, "Unterminated phrase must be rejected"s);
+    } catch (const invalid_argument&) {
+    }
+
+    // Без индекса позиций фразы недоступны
+    {
+        SearchServer plain_server(""s);
+        plain_server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, {1});
+        try {
+            plain_server.FindTopDocuments("\"white cat\""s);
+            ASSERT_HINT(false, "Phrase query without positions must be rejected"s);
+        } catch (const invalid_argument&) {
+        }
+    }
+
+    // Документ, в котором слова запроса стоят рядом, получает больший бонус
+    {
+        IndexOptions proximity_options;
+        proximity_options.store_positions = true;
+        proximity_options.proximity_weight = 1.0;
+        SearchServer proximity_server(""s, proximity_options);
+        proximity_server.AddDocument(1, "cat and a small white dog"s, DocumentStatus::ACTUAL, {1});
+        proximity_server.AddDocument(2, "dog cat and a small white"s, DocumentStatus::ACTUAL, {1});
+        proximity_server.AddDocument(3, "bird"s, DocumentStatus::ACTUAL, {1});
+        const auto found = proximity_server.FindTopDocuments("cat dog"s);
+        ASSERT_EQUAL(found.size(), 2u);
+        ASSERT_EQUAL(found[0].id, 2);
+        ASSERT(abs(found[0].relevance - found[1].relevance - (1.0 - 1.0 / 5)) < EPS);
+    }
+}
+
+// Тест проверяет поиск по префиксам слов
+void TestPrefixQueries() {
+    SearchServer server(""s);
+    server.AddDocument(1, "catalog of things"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "cat and dog"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(3, "category theory cats"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(4, "dog only"s, DocumentStatus::ACTUAL, {1});
+
+    ASSERT_EQUAL(GetSortedIds(server.FindTopDocuments("cat*"s)), vector<int>({1, 2, 3}));
+    ASSERT_EQUAL(GetSortedIds(server.FindTopDocuments(execution::par, "cat* -dog"s)), vector<int>({1, 3}));
+    ASSERT_EQUAL(GetSortedIds(server.FindTopDocuments("dog -categ*"s)), vector<int>({2, 4}));
+    ASSERT(server.FindTopDocuments("bird*"s).empty());
+
+    // Релевантность префикса равна сумме релевантностей всех подходящих слов документа
+    {
+        const auto by_prefix = server.FindTopDocuments("categ*"s);
+        const auto by_words = server.FindTopDocuments("category cats"s);
+        ASSERT_EQUAL(by_prefix.size(), 1u);
+        ASSERT(abs(by_prefix[0].relevance - server.FindTopDocuments("category"s)[0].relevance) < EPS);
+        ASSERT(by_words[0].relevance > by_prefix[0].relevance);
+        ASSERT(abs(server.FindTopDocuments("cat*"s, [](int id, DocumentStatus, int) { return id == 3; })[0].relevance
+                   - by_words[0].relevance) < EPS);
+    }
+
+    const vector<string_view> expected_words = {"cat"sv, "dog"sv};
+    ASSERT_EQUAL(get<vector<string_view>>(server.MatchDocument("ca* dog"s, 2)), expected_words);
+    ASSERT_EQUAL(get<vector<string_view>>(server.MatchDocument(execution::par, "ca* dog"s, 2)), expected_words);
+    ASSERT(get<vector<string_view>>(server.MatchDocument("dog -ca*"s, 2)).empty());
+
+    // Число раскрытий префикса ограничено, остаются самые частые слова
+    {
+        IndexOptions options;
+        options.max_prefix_expansions = 1;
+        SearchServer limited_server(""s, options);
+        limited_server.AddDocument(1, "cab"s, DocumentStatus::ACTUAL, {1});
+        limited_server.AddDocument(2, "cat"s, DocumentStatus::ACTUAL, {1});
+        limited_server.AddDocument(3, "cat"s, DocumentStatus::ACTUAL, {1});
+        limited_server.AddDocument(4, "dog"s, DocumentStatus::ACTUAL, {1});
+        ASSERT_EQUAL(GetSortedIds(limited_server.FindTopDocuments("ca*"s)), vector<int>({2, 3}));
+    }
+
+    // Одиночная звездочка не является префиксом и ищется как обычное слово
+    {
+        server.AddDocument(5, "rated * by users"s, DocumentStatus::ACTUAL, {1});
+        ASSERT_EQUAL(GetSortedIds(server.FindTopDocuments("*"s)), vector<int>({5}));
+        ASSERT_EQUAL(GetSortedIds(server.FindTopDocuments("users -*"s)), vector<int>());
+        const vector<string_view> expected_star = {"*"sv};
+        ASSERT_EQUAL(get<vector<string_view>>(server.MatchDocument("* cat*"s, 5)), expected_star);
+    }
+}
+
+// Тест проверяет пакетное удаление документов, в том числе параллельное
+void TestRemoveDocuments() {
+    IndexOptions options;
+    options.store_positions = true;
+    const auto make_server = [&options]() {
+        SearchServer server("and"s, options);
+        for (int id = 0; id < 300; ++id) {
+            const string text = "word"s + to_string(id % 7) + " common and word"s + to_string(id % 13) + " item"s + to_string(id);
+            server.AddDocument(id, text, static_cast<DocumentStatus>(id % 4), {id % 10});
+        }
+        return server;
+    };
+
+    vector<int> to_remove;
+    for (int id = 0; id < 300; id += 3) {
+        to_remove.push_back(id);
+    }
+    to_remove.push_back(1000);
+    to_remove.push_back(3);
+
+    SearchServer one_by_one = make_server();
+    for (const int id : to_remove) {
+        one_by_one.RemoveDocument(execution::par, id);
+    }
+    SearchServer sequential = make_server();
+    sequential.RemoveDocuments(to_remove);
+    SearchServer parallel = make_server();
+    parallel.RemoveDocuments(execution::par, to_remove);
+
+    // Все способы удаления приводят к одинаковому состоянию индекса
+    const auto check_same_index = [&](int document_count) {
+        for (const SearchServer* server : {&sequential, &parallel}) {
+            ASSERT_EQUAL(server->GetDocumentCount(), document_count);
+            ASSERT_EQUAL(vector<int>(server->begin(), server->end()), vector<int>(one_by_one.begin(), one_by_one.end()));
+            for (const string& query : {"common"s, "word3 -word5"s, "item8 item7"s, "\"common word4\""s, "wor*"s}) {
+                const auto expected = one_by_one.FindTopDocuments(query, DocumentFilter());
+                const auto actual = server->FindTopDocuments(query, DocumentFilter());
+                ASSERT_EQUAL(actual.size(), expected.size());
+                for (size_t i = 0; i < expected.size(); ++i) {
+                    ASSERT_EQUAL(actual[i].id, expected[i].id);
+                    ASSERT(abs(actual[i].relevance - expected[i].relevance) < EPS);
+                }
+            }
+            ASSERT(server->FindTopDocuments("item6"s, DocumentFilter()).empty());
+            ASSERT(server->GetWordFrequencies(9).empty());
+        }
+    };
+    check_same_index(200);
+
+    // Удаление большей части документов перенумеровывает оставшиеся
+    to_remove.clear();
+    for (int id = 1; id < 300; id += 3) {
+        to_remove.push_back(id);
+    }
+    for (const int id : to_remove) {
+        one_by_one.RemoveDocument(id);
+    }
+    sequential.RemoveDocuments(to_remove);
+    parallel.RemoveDocuments(execution::par, to_remove);
+    check_same_index(100);
+}
+
+// Тест проверяет очистку словаря и списков документов после удалений
+void TestVacuum() {
+    IndexOptions options;
+    options.store_positions = true;
+    SearchServer server(""s, options);
+    for (int id = 0; id < 100; ++id) {
+        server.AddDocument(id, "common unique"s + to_string(id) + " common"s, DocumentStatus::ACTUAL, {1});
+    }
+    vector<int> to_remove;
+    for (int id = 0; id < 90; ++id) {
+        to_remove.push_back(id);
+    }
+    server.RemoveDocuments(to_remove);
+
+    // Полный проход удаляет слова без документов и освобождает лишнюю память списков
+    VacuumReport total;
+    while (!total.pass_completed) {
+        const VacuumReport report = server.Vacuum(chrono::microseconds(0));
+        total.terms_removed += report.terms_removed;
+        total.posting_lists_shrunk += report.posting_lists_shrunk;
+        total.bytes_reclaimed += report.bytes_reclaimed;
+        total.pass_completed = report.pass_completed;
+    }
+    ASSERT_EQUAL(total.terms_removed, 90u);
+    ASSERT_EQUAL(total.posting_lists_shrunk, 1u);
+    ASSERT(total.bytes_reclaimed > 0);
+
+    // Повторный проход ничего не находит
+    const VacuumReport second = server.Vacuum(chrono::seconds(1));
+    ASSERT(second.pass_completed);
+    ASSERT_EQUAL(second.terms_removed, 0u);
+    ASSERT_EQUAL(second.bytes_reclaimed, 0u);
+
+    // Освобожденные идентификаторы слов переиспользуются новыми словами без влияния на поиск
+    server.AddDocument(200, "fresh common words"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(201, "unique5 returns"s, DocumentStatus::ACTUAL, {1});
+    ASSERT_EQUAL(server.FindTopDocuments("fresh"s).size(), 1u);
+    ASSERT_EQUAL(server.FindTopDocuments("unique5"s)[0].id, 201);
+    ASSERT_EQUAL(server.FindTopDocuments("unique5*"s).size(), 1u);
+    ASSERT_EQUAL(server.FindTopDocuments("\"common unique95\""s)[0].id, 95);
+    ASSERT_EQUAL(server.FindTopDocuments("common"s).size(), 5u);
+    vector<string> words;
+    for (const auto [word, _] : server.GetWordFrequencies(200)) {
+        words.push_back(string(word));
+    }
+    ASSERT_EQUAL(words, vector<string>({"common"s, "fresh"s, "words"s}));
+}
+
+// Тест проверяет план выполнения запроса и его влияние на поиск
+void TestQueryPlan() {
+    IndexOptions options;
+    options.parallel_query_cost = 30;
+    SearchServer server(""s, options);
+    for (int id = 0; id < 20; ++id) {
+        const string rare = id < 2 ? " rare"s : ""s;
+        const string minus = id % 10 == 0 ? " spam"s : ""s;
+        server.AddDocument(id, "common word"s + rare + minus, DocumentStatus::ACTUAL, {id});
+    }
+
+    // Слова упорядочены по числу документов, слова без документов пропускаются
+    {
+        const string query = "common rare missing -spam"s;
+        const QueryPlan plan = server.Explain(query);
+        ASSERT_EQUAL(plan.plus_groups.size(), 2u);
+        ASSERT_EQUAL(plan.plus_groups[0].query_word, "rare"sv);
+        ASSERT_EQUAL(plan.plus_groups[1].query_word, "common"sv);
+        ASSERT_EQUAL(plan.skipped_words, vector<string_view>({"missing"sv}));
+        ASSERT(plan.exclusion == QueryPlan::Exclusion::BITMAP);
+        ASSERT_EQUAL(plan.estimated_cost, 24u);
+        ASSERT(!plan.parallel);
+    }
+    // Длинные списки минус-слов проверяются для каждого найденного документа
+    {
+        const QueryPlan plan = server.Explain("rare -common -word"s);
+        ASSERT(plan.exclusion == QueryPlan::Exclusion::PROBE);
+        ASSERT_EQUAL(plan.estimated_cost, 2u);
+        ASSERT(server.FindTopDocuments("rare -common"s).empty());
+    }
+    ASSERT(server.Explain("common word"s).parallel);
+    ASSERT(server.Explain("nothing -spam"s).exclusion == QueryPlan::Exclusion::NONE);
+
+    // План не влияет на результат
+    ASSERT_EQUAL(GetIds(server.FindTopDocuments("common rare -spam"s)), vector<int>({1, 19, 18, 17, 16}));
+    ASSERT_EQUAL(GetIds(server.FindTopDocuments(execution::seq, "common word -spam"s)),
+                 GetIds(server.FindTopDocuments("common word -spam"s)));
+    ostringstream out;
+    out << server.Explain("rare co* -spam"s);
+    ASSERT_EQUAL(out.str(), "sequential, cost 24\nplus: rare (2), co* -> common (20)\nminus [bitmap]: spam (2)\nskipped:\n"s);
+}
+
+// Тест проверяет поиск с исправлением опечаток
+void TestFuzzyMatching() {
+    ASSERT_EQUAL(LevenshteinAutomaton("kitten"s, 3).Distance("sitting"s), 3);
+    ASSERT_EQUAL(LevenshteinAutomaton("kitten"s, 2).Distance("sitting"s), 3);
+    ASSERT_EQUAL(LevenshteinAutomaton("cat"s, 2).Distance("act"s), 2);
+    ASSERT_EQUAL(LevenshteinAutomaton("cat"s, 1).Distance("cat"s), 0);
+
+    IndexOptions options;
+    options.max_edit_distance = 1;
+    options.fuzzy_penalty = 0.5;
+    SearchServer server(""s, options);
+    server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "black dog"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(3, "funny kitten"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(4, "cats and dogs"s, DocumentStatus::ACTUAL, {1});
+
+    // Слова с опечаткой находят документы, точное совпадение ранжируется выше
+    ASSERT_EQUAL(GetIds(server.FindTopDocuments("kat"s)), vector<int>({1}));
+    ASSERT_EQUAL(GetIds(server.FindTopDocuments("blak"s)), vector<int>({2}));
+    ASSERT_EQUAL(GetIds(server.FindTopDocuments("cat"s)), vector<int>({1, 4}));
+    ASSERT(abs(server.FindTopDocuments("kat"s)[0].relevance - 0.5 * server.FindTopDocuments("cat"s)[0].relevance) < EPS);
+    ASSERT(server.FindTopDocuments("dgo"s).empty());
+
+    // Минус-слова не расширяются
+    ASSERT_EQUAL(GetIds(server.FindTopDocuments("cat -dog"s)), vector<int>({1, 4}));
+    const vector<string_view> expected_words = {"cats"sv};
+    ASSERT_EQUAL(get<vector<string_view>>(server.MatchDocument("cat"s, 4)), expected_words);
+    ASSERT_EQUAL(get<vector<string_view>>(server.MatchDocument(execution::par, "cat"s, 4)), expected_words);
+    {
+        ostringstream out;
+        out << server.Explain("cat"s);
+        ASSERT_EQUAL(out.str(), "sequential, cost 2\nplus: cat~ -> cat cats~1 (2)\nminus [none]:\nskipped:\n"s);
+    }
+
+    // Слова, удаленные из словаря, больше не предлагаются
+    server.RemoveDocument(2);
+    while (!server.Vacuum(chrono::seconds(1)).pass_completed) {
+    }
+    ASSERT(server.FindTopDocuments("blak"s).empty());
+    server.AddDocument(5, "blank page"s, DocumentStatus::ACTUAL, {1});
+    ASSERT_EQUAL(GetIds(server.FindTopDocuments("blak"s)), vector<int>({5}));
+
+    // Без включенного режима опечатки не исправляются
+    ASSERT(SearchServer(""s).FindTopDocuments("kat"s).empty());
+    {
+        IndexOptions wide_options;
+        wide_options.max_edit_distance = 2;
+        SearchServer wide_server(""s, wide_options);
+        wide_server.AddDocument(3, "funny kitten"s, DocumentStatus::ACTUAL, {1});
+        ASSERT_EQUAL(GetIds(wide_server.FindTopDocuments("kitn"s)), vector<int>({3}));
+        wide_options.max_edit_distance = 3;
+        try {
+            SearchServer invalid_server(""s, wide_options);
+            ASSERT_HINT(false, "Edit distance above 2 must be rejected"s);
+        } catch (const invalid_argument&) {
+        }
+    }
+}
+
+// Тест проверяет постраничную выдачу результатов с курсором
+void TestPagination() {
+    SearchServer server(""s);
+    for (int id = 0; id < 12; ++id) {
+        server.AddDocument(id, id % 3 == 0 ? "cat dog"s : "cat"s, DocumentStatus::ACTUAL, {id % 4});
+    }
+    server.AddDocument(12, "cat dog"s, DocumentStatus::BANNED, {10});
+
+    // Страницы продолжают друг друга, равные по релевантности и рейтингу документы упорядочены по id
+    const vector<Document> first_page = server.FindTopDocuments("cat dog"s, PageCursor(), 5);
+    ASSERT_EQUAL(GetIds(first_page), vector<int>({3, 6, 9, 0, 7}));
+    ASSERT_EQUAL(GetIds(first_page), GetIds(server.FindTopDocuments("cat dog"s)));
+    const vector<Document> second_page = server.FindTopDocuments("cat dog"s, PageCursor(first_page.back()), 5);
+    ASSERT_EQUAL(GetIds(second_page), vector<int>({11, 2, 10, 1, 5}));
+    const vector<Document> last_page = server.FindTopDocuments("cat dog"s, PageCursor(second_page.back()), 5);
+    ASSERT_EQUAL(GetIds(last_page), vector<int>({4, 8}));
+    ASSERT(server.FindTopDocuments("cat dog"s, PageCursor(last_page.back()), 5).empty());
+    ASSERT_EQUAL(GetIds(server.FindTopDocuments("cat dog"s, PageCursor(), 2, DocumentFilter(DocumentStatus::BANNED))), vector<int>({12}));
+
+    // Курсор передается клиенту в виде строки
+    {
+        const string token = PageCursor(first_page.back()).ToString();
+        ASSERT_EQUAL(GetIds(server.FindTopDocuments("cat dog"s, PageCursor::FromString(token), 5)), GetIds(second_page));
+        ASSERT(PageCursor::FromString(""s).IsFirstPage());
+        try {
+            PageCursor::FromString("3:2"s);
+            ASSERT_HINT(false, "Malformed cursor must be rejected"s);
+        } catch (const invalid_argument&) {
+        }
+    }
+
+    // Релевантности, попарно близкие в пределах EPS, не образуют цикла: каждая страница
+    // из одного документа продолжает предыдущую, и каждый документ выдается ровно один раз
+    {
+        const vector<Document> chain = {{1, 0.0, 10}, {2, 0.8e-6, 5}, {3, 1.6e-6, 0}};
+        vector<int> paged_ids;
+        PageCursor cursor;
+        for (size_t page = 0; page <= chain.size(); ++page) {
+            const Document* best = nullptr;
+            for (const Document& document : chain) {
+                if (cursor.Precedes(document) && (!best || RanksBefore(document, *best))) {
+                    best = &document;
+                }
+            }
+            if (!best) {
+                break;
+            }
+            paged_ids.push_back(best->id);
+            cursor = PageCursor(*best);
+        }
+        sort(paged_ids.begin(), paged_ids.end());
+        ASSERT_EQUAL(paged_ids, vector<int>({1, 2, 3}));
+        for (const Document& lhs : chain) {
+            for (const Document& rhs : chain) {
+                ASSERT(!(RanksBefore(lhs, rhs) && RanksBefore(rhs, lhs)));
+            }
+        }
+    }
+
+    // Ленивый пагинатор запрашивает страницы по мере перебора
+    {
+        vector<size_t> page_sizes;
+        vector<int> all_ids;
+        for (const auto page : PaginateTopDocuments(server, "cat dog"s, 5)) {
+            page_sizes.push_back(page.size());
+            for (const int id : GetIds(vector<Document>(page.begin(), page.end()))) {
+                all_ids.push_back(id);
+            }
+        }
+        ASSERT_EQUAL(page_sizes, vector<size_t>({5, 5, 2}));
+        ASSERT_EQUAL(all_ids, vector<int>({3, 6, 9, 0, 7, 11, 2, 10, 1, 5, 4, 8}));
+
+        int fetch_count = 0;
+        const LazyPaginator<int> numbers([&fetch_count](const vector<int>& previous_page) {
+            ++fetch_count;
+            return previous_page.empty() ? vector<int>({1, 2}) : vector<int>({previous_page.back() + 1});
+        });
+        auto it = numbers.begin();
+        ASSERT_EQUAL(fetch_count, 1);
+        ++it;
+        ++it;
+        ASSERT_EQUAL((*it).size(), 1u);
+        ASSERT_EQUAL(*(*it).begin(), 4);
+        ASSERT_EQUAL(fetch_count, 3);
+    }
+}
+
+// Тест проверяет поиск с задаваемыми при компиляции способом оценки, фильтром и порядком результатов
+void TestScoringPolicies() {
+    {
+        SearchServer server("and"s);
+        server.AddDocument(1, "white cat and fancy collar"s, DocumentStatus::ACTUAL, {8, -3});
+        server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, {7, 2, 7});
+        server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::ACTUAL, {5, -12, 2, 1});
+        server.AddDocument(4, "groomed starling eugene"s, DocumentStatus::BANNED, {9});
+        server.AddDocument(5, "fluffy dog and collar"s, DocumentStatus::IRRELEVANT, {1});
+
+        // Поиск по умолчанию совпадает с FindTopDocuments, фильтр задается типом или значением
+        for (const string& query : {"fluffy groomed cat"s, "fluff* -dog"s, "collar cat -white"s, "eugene"s}) {
+            ASSERT(HaveSameResults(server.FindTopDocumentsWith(query), server.FindTopDocuments(query)));
+            ASSERT(HaveSameResults(server.FindTopDocumentsWith(query, AnyDocument()), server.FindTopDocuments(query, DocumentFilter())));
+            ASSERT(HaveSameResults(server.FindTopDocumentsWith(query, StatusIs<DocumentStatus::BANNED>()),
+                                server.FindTopDocuments(query, DocumentStatus::BANNED)));
+            ASSERT(HaveSameResults(server.FindTopDocumentsWith(query, DocumentFilter().MinRating(2)),
+                                server.FindTopDocuments(query, DocumentFilter().MinRating(2))));
+            const auto is_even = [](int document_id, DocumentStatus, int) {
+                return document_id % 2 == 0;
+            };
+            ASSERT(HaveSameResults(server.FindTopDocumentsWith<TfIdfScorer, ExactRelevance>(query, is_even),
+                                server.FindTopDocuments(query, is_even)));
+        }
+    }
+    {
+        SearchServer server(""s);
+        server.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, {1});
+        server.AddDocument(2, "cat cat bird mouse"s, DocumentStatus::ACTUAL, {1});
+        server.AddDocument(3, "dog"s, DocumentStatus::ACTUAL, {1});
+
+        // BM25 учитывает насыщение частоты слова и длину документа, у TF-IDF здесь равные релевантности
+        const vector<Document> documents = server.FindTopDocumentsWith<Bm25Scorer>("cat"s);
+        ASSERT_EQUAL(documents.size(), 2u);
+        ASSERT_EQUAL(documents[0].id, 2);
+        ASSERT(abs(documents[0].relevance - 0.538145) < EPS);
+        ASSERT(abs(documents[1].relevance - 0.499176) < EPS);
+        ASSERT_EQUAL(server.FindTopDocuments("cat"s)[0].id, 1);
+    }
+    {
+        IndexOptions options;
+        options.store_positions = true;
+        SearchServer server(""s, options);
+        for (int id = 0; id < 500; ++id) {
+            const string rare = id % 50 == 0 ? " rare"s + to_string(id % 3) : ""s;
+            server.AddDocument(id, "common word"s + to_string(id % 7) + rare + " filler"s, DocumentStatus::ACTUAL, {id % 5});
+        }
+
+        // Редкие слова накапливаются без массивов по всем документам, частые — в массивах; результат тот же
+        for (const string& query : {"rare0 rare1"s, "rare* -word3"s, "\"rare2 filler\""s, "rare1 word2"s, "common -rare0"s}) {
+            ASSERT(HaveSameResults(server.FindTopDocumentsWith(query), server.FindTopDocuments(query)));
+            ASSERT(HaveSameResults(server.FindTopDocumentsWith(query, DocumentFilter().MaxRating(2)),
+                                   server.FindTopDocuments(query, DocumentFilter().MaxRating(2))));
+        }
+        ASSERT_EQUAL(GetSortedIds(server.FindTopDocumentsWith("rare1"s)), vector<int>({100, 250, 400}));
+    }
+}
+
+// Тест проверяет совпадение результатов поиска со счетом во float и в double
+void TestFloatScoring() {
+    SearchServer server("and with"s);
+    const vector<string> words = {"cat"s, "dog"s, "tail"s, "collar"s, "eyes"s, "fluffy"s, "groomed"s, "white"s};
+    for (int id = 0; id < 200; ++id) {
+        string text;
+        for (int i = 0; i <= id % 13; ++i) {
+            text += words[(id * 7 + i * i) % words.size()] + " "s;
+        }
+        server.AddDocument(id, text, DocumentStatus::ACTUAL, {id % 9});
+    }
+
+    // Счет во float дает те же документы в том же порядке, что и счет в double, релевантности совпадают в пределах EPS
+    for (const string& query : {"cat"s, "fluffy groomed -tail"s, "white eyes collar dog"s}) {
+        const vector<Document> expected = server.FindTopDocuments(query);
+        const vector<Document> found = server.FindTopDocumentsWith<FloatTfIdfScorer>(query);
+        ASSERT_EQUAL(GetIds(found), GetIds(expected));
+        ASSERT_EQUAL(GetIds(found), GetIds(server.FindTopDocumentsWith<TfIdfScorer>(query)));
+        for (size_t i = 0; i < found.size(); ++i) {
+            ASSERT(abs(found[i].relevance - expected[i].relevance) < EPS);
+        }
+    }
+
+    // Целые счетчики слов вдвое уменьшают списки документов по сравнению с парами {номер, double}.
+    // В каждом списке 256 документов, поэтому емкость списков совпадает с их размером, а пропуски добавляют 1/32
+    SearchServer full_server(""s);
+    for (int id = 0; id < 256; ++id) {
+        string text;
+        for (const string& word : words) {
+            text += word + " "s;
+        }
+        full_server.AddDocument(id, text + words[id % words.size()], DocumentStatus::ACTUAL, {1});
+    }
+    const size_t double_layout_bytes = words.size() * 256 * sizeof(pair<uint32_t, double>);
+    ASSERT(full_server.GetMemoryStats().postings.bytes <= double_layout_bytes / 2 + double_layout_bytes / 20);
+}
+
+// Тест проверяет поиск в таблице стоп-слов
+void TestStopWords() {
+    const string long_word(70, 'a');
+    const StopWords stop_words(set<string, less<>>{"a"s, "in"s, "the"s, "and"s, "without"s, long_word});
+    ASSERT_EQUAL(stop_words.Size(), 6u);
+    for (const string& word : {"a"s, "in"s, "the"s, "and"s, "without"s, long_word}) {
+        ASSERT_HINT(stop_words.Contains(word), word);
+    }
+    // Слова той же длины, префиксы и длинные слова с общим началом не считаются стоп-словами
+    for (const string& word : {"b"s, "on"s, "thee"s, "th"s, "ant"s, "withour"s, ""s, string(69, 'a'), long_word + "a"s}) {
+        ASSERT_HINT(!stop_words.Contains(word), word);
+    }
+    ASSERT(!StopWords().Contains("a"s));
+
+    // Результат совпадает с обычным множеством на большом наборе слов
+    set<string, less<>> words;
+    for (int i = 0; i < 10000; ++i) {
+        words.insert("w"s + to_string(i * 7));
+    }
+    const StopWords many_stop_words(words);
+    for (int i = 0; i < 70000; ++i) {
+        const string word = "w"s + to_string(i);
+        ASSERT_EQUAL(many_stop_words.Contains(word), words.count(word) > 0);
+    }
+}
+
+// Тест проверяет, что сервер из нескольких частей ищет так же, как один сервер
+void TestShardedSearchServer() {
+    SearchServer server("and with"s);
+    ShardedSearchServer sharded_server("and with"s, 3);
+    ASSERT_EQUAL(sharded_server.GetShardCount(), 3u);
+    const vector<string> words = {"cat"s, "dog"s, "tail"s, "collar"s, "eyes"s, "fluffy"s, "groomed"s, "white"s, "and"s};
+    for (int id = 0; id < 300; ++id) {
+        string text;
+        for (int i = 0; i <= id % 11; ++i) {
+            text += words[(id * 5 + i * i * 3) % words.size()] + " "s;
+        }
+        const DocumentStatus status = id % 7 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        server.AddDocument(id, text, status, {id % 13, id % 5});
+        sharded_server.AddDocument(id, text, status, {id % 13, id % 5});
+    }
+    ASSERT_EQUAL(sharded_server.GetDocumentCount(), 300);
+
+    // Глобальные частоты слов дают те же результаты, что и один сервер
+    for (const string& query : {"cat"s, "fluffy groomed -tail"s, "white eyes collar dog"s, "nothing"s}) {
+        ASSERT(HaveSameResults(sharded_server.FindTopDocuments(query), server.FindTopDocuments(query)));
+        ASSERT(HaveSameResults(sharded_server.FindTopDocuments(query, DocumentStatus::BANNED),
+                               server.FindTopDocuments(query, DocumentStatus::BANNED)));
+    }
+    const string match_query = "cat dog tail"s;
+    for (const int id : {3, 7, 42}) {
+        const auto [sharded_words, sharded_status] = sharded_server.MatchDocument(match_query, id);
+        const auto [words, status] = server.MatchDocument(match_query, id);
+        ASSERT(sharded_words == vector<string>(words.begin(), words.end()));
+        ASSERT(sharded_status == status);
+    }
+
+    // Префиксы и опечатки раскрываются в слова, выбранные по всей коллекции, а не по каждой части
+    {
+        IndexOptions options;
+        options.max_prefix_expansions = 2;
+        options.max_edit_distance = 1;
+        options.max_fuzzy_expansions = 2;
+        SearchServer capped_server(""s, options);
+        ShardedSearchServer capped_sharded_server(""s, 3, options);
+        const vector<string> expansions = {"cab"s, "cad"s, "cam"s, "can"s, "cap"s, "car"s, "cat"s};
+        for (int id = 0; id < 200; ++id) {
+            // Частоты слов в частях различаются, а некоторые слова встречаются одинаково часто
+            const string text = expansions[(id * id) % 7] + " "s + expansions[id % 5] + " fish"s;
+            capped_server.AddDocument(id, text, DocumentStatus::ACTUAL, {id % 10});
+            capped_sharded_server.AddDocument(id, text, DocumentStatus::ACTUAL, {id % 10});
+        }
+        for (const string& query : {"ca*"s, "cax"s, "fish -ca*"s, "cat ca*"s, "cab cax"s}) {
+            ASSERT_HINT(HaveSameResults(capped_sharded_server.FindTopDocuments(query), capped_server.FindTopDocuments(query)), query);
+        }
+    }
+
+    // Ошибки индексации передаются через future
+    try {
+        sharded_server.AddDocument(5, "duplicate"s, DocumentStatus::ACTUAL, {}).get();
+        ASSERT_HINT(false, "Duplicate id must be rejected"s);
+    } catch (const invalid_argument&) {
+    }
+    sharded_server.RemoveDocument(5);
+    server.RemoveDocument(5);
+    ASSERT_EQUAL(sharded_server.GetDocumentCount(), 299);
+    ASSERT(HaveSameResults(sharded_server.FindTopDocuments("tail cat"s), server.FindTopDocuments("tail cat"s)));
+    try {
+        sharded_server.FindTopDocuments("cat --dog"s);
+        ASSERT_HINT(false, "Invalid query must be rejected"s);
+    } catch (const invalid_argument&) {
+    }
+}
+
+// Тест проверяет поиск через брокер по частям индекса в других процессах (здесь — потоках)
+void TestShardBroker() {
+    const string socket_prefix = "/tmp/search-server-test-"s + to_string(getpid()) + "-"s;
+    vector<string> socket_paths;
+    deque<SearchServer> shard_indexes;
+    deque<ShardServer> shards;
+    vector<thread> shard_threads;
+    for (int i = 0; i < 3; ++i) {
+        socket_paths.push_back(socket_prefix + to_string(i));
+        shards.emplace_back(shard_indexes.emplace_back("and with"s), socket_paths.back());
+        shard_threads.emplace_back([&shard = shards.back()] {
+            shard.Serve();
+        });
+    }
+    {
+        BrokerOptions options;
+        options.pipeline_depth = 4;
+        ShardBroker broker(socket_paths, options);
+        SearchServer server("and with"s);
+        const vector<string> words = {"cat"s, "dog"s, "tail"s, "collar"s, "eyes"s, "fluffy"s, "groomed"s, "and"s};
+        vector<DocumentRecord> documents;
+        for (int id = 0; id < 200; ++id) {
+            string text;
+            for (int i = 0; i <= id % 9; ++i) {
+                text += words[(id * 3 + i * i) % words.size()] + " "s;
+            }
+            documents.push_back({id, text, id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, {id % 7, -id % 3}});
+            server.AddDocument(id, text, documents.back().status, documents.back().ratings);
+        }
+        broker.AddDocuments(documents);
+        ASSERT_EQUAL(broker.GetDocumentCount(), 200);
+
+        // Выдача через брокер совпадает с выдачей одного сервера
+        for (const string& query : {"cat"s, "fluffy groomed -tail"s, "eyes collar dog"s, "nothing"s, "c* -col*"s}) {
+            ASSERT(HaveSameResults(broker.FindTopDocuments(query), server.FindTopDocuments(query)));
+            ASSERT(HaveSameResults(broker.FindTopDocuments(query, DocumentFilter(DocumentStatus::BANNED).MinRating(2)),
+                                   server.FindTopDocuments(query, DocumentFilter(DocumentStatus::BANNED).MinRating(2))));
+        }
+
+        // Ошибки сервера передаются брокеру, соединения после них остаются пригодными
+        try {
+            broker.AddDocuments({{7, "duplicate"s, DocumentStatus::ACTUAL, {}}, {1000, "cat"s, DocumentStatus::ACTUAL, {}}});
+            ASSERT_HINT(false, "Duplicate id must be rejected"s);
+        } catch (const invalid_argument&) {
+        }
+        try {
+            broker.FindTopDocuments("cat --dog"s);
+            ASSERT_HINT(false, "Invalid query must be rejected"s);
+        } catch (const invalid_argument&) {
+        }
+        try {
+            broker.RemoveDocument(5000);
+            ASSERT_HINT(false, "Missing document must be reported"s);
+        } catch (const out_of_range&) {
+        }
+        broker.RemoveDocument(7);
+        ASSERT_EQUAL(broker.GetDocumentCount(), 200);
+    }
+
+    // Запросы, пришедшие вместе с концом ввода, получают ответы до закрытия соединения
+    {
+        UniqueFd socket = ConnectUnixSocket(socket_paths[0]);
+        string requests;
+        AppendFrame(requests, 1, MessageType::DOCUMENT_COUNT, {});
+        AppendFrame(requests, 2, MessageType::DOCUMENT_COUNT, {});
+        ASSERT_EQUAL(send(socket.Get(), requests.data(), requests.size(), MSG_NOSIGNAL), static_cast<ssize_t>(requests.size()));
+        shutdown(socket.Get(), SHUT_WR);
+        string responses;
+        pollfd poll_fd{socket.Get(), POLLIN, 0};
+        while (poll(&poll_fd, 1, 5000) > 0) {
+            char buffer[4096];
+            const ssize_t size = read(socket.Get(), buffer, sizeof(buffer));
+            if (size <= 0) {
+                break;
+            }
+            responses.append(buffer, size);
+        }
+        Frame response;
+        const size_t first_size = ExtractFrame(responses, response);
+        ASSERT(first_size > 0);
+        ASSERT_EQUAL(response.request_id, 1u);
+        ASSERT(ExtractFrame(string_view(responses).substr(first_size), response) > 0);
+        ASSERT_EQUAL(response.request_id, 2u);
+        ASSERT_EQUAL(MessageReader(response.payload).GetUint64(), static_cast<uint64_t>(shard_indexes[0].GetDocumentCount()));
+    }
+
+    // Часть, которая не отвечает, приводит к ошибке по истечении времени ожидания
+    {
+        SearchServer silent_index(""s);
+        ShardServer silent_shard(silent_index, socket_prefix + "silent"s);
+        BrokerOptions options;
+        options.timeout = chrono::milliseconds(50);
+        ShardBroker broker({socket_paths[0], socket_prefix + "silent"s}, options);
+        try {
+            broker.GetDocumentCount();
+            ASSERT_HINT(false, "Silent shard must time out"s);
+        } catch (const runtime_error&) {
+        }
+    }
+
+    // Соединения из пула, закрытые перезапущенной частью, заменяются новыми
+    {
+        ShardBroker broker(socket_paths);
+        const int document_count = broker.GetDocumentCount();
+        const vector<Document> before = broker.FindTopDocuments("cat"s);
+        shards.back().Stop();
+        shard_threads.back().join();
+        shards.pop_back();
+        shards.emplace_back(shard_indexes.back(), socket_paths.back());
+        shard_threads.back() = thread([&shard = shards.back()] {
+            shard.Serve();
+        });
+        ASSERT_EQUAL(broker.GetDocumentCount(), document_count);
+        ASSERT_EQUAL(broker.FindTopDocuments("cat"s).size(), before.size());
+    }
+
+    for (size_t i = 0; i < shards.size(); ++i) {
+        shards[i].Stop();
+        shard_threads[i].join();
+    }
+}
+
+// Тест проверяет сетевой интерфейс: формат ответов и их порядок при конвейерной отправке запросов
+void TestSearchFrontend() {
+    SearchServer server("and with"s);
+    server.AddDocument(1, "white cat and fluffy tail"s, DocumentStatus::ACTUAL, {5});
+    server.AddDocument(2, "black dog"s, DocumentStatus::BANNED, {2});
+    server.AddDocument(3, "fluffy dog with collar"s, DocumentStatus::ACTUAL, {1, 3});
+
+    // Формат ответов
+    ASSERT_EQUAL(SearchFrontend::Execute(server, "PING"s), "OK"s);
+    ASSERT_EQUAL(SearchFrontend::Execute(server, "FIND nothing"s), "OK 0"s);
+    ASSERT_EQUAL(SearchFrontend::Execute(server, "FIND cat -tail"s), "OK 0"s);
+    ASSERT_EQUAL(SearchFrontend::Execute(server, "MATCH 3 fluffy cat collar"s), "OK ACTUAL collar fluffy"s);
+    ASSERT_EQUAL(SearchFrontend::Execute(server, "MATCH 2 dog"s), "OK BANNED dog"s);
+    ASSERT_EQUAL(SearchFrontend::Execute(server, "MATCH x dog"s).substr(0, 6), "ERROR "s);
+    ASSERT_EQUAL(SearchFrontend::Execute(server, "FIND cat --tail"s).substr(0, 6), "ERROR "s);
+    ASSERT_EQUAL(SearchFrontend::Execute(server, "DELETE 1"s).substr(0, 6), "ERROR "s);
+
+    // Запросы, отправленные без ожидания ответов, получают ответы в том же порядке
+    FrontendOptions options;
+    options.worker_count = 3;
+    options.max_pipelined_requests = 2;
+    SearchFrontend frontend(server, options);
+    thread serving([&frontend] {
+        frontend.Serve();
+    });
+    vector<string> requests;
+    string request_text;
+    for (int i = 0; i < 100; ++i) {
+        requests.push_back(i % 3 == 0 ? "FIND fluffy"s : i % 3 == 1 ? "MATCH "s + to_string(i % 2 * 2 + 1) + " dog"s : "PING"s);
+        request_text += requests.back() + (i % 2 == 0 ? "\r\n"s : "\n"s);
+    }
+    {
+        UniqueFd socket = ConnectTcpSocket("127.0.0.1"s, frontend.GetPort());
+        pollfd poll_fd{socket.Get(), POLLOUT, 0};
+        for (size_t offset = 0; offset < request_text.size();) {
+            poll(&poll_fd, 1, 1000);
+            const ssize_t size = send(socket.Get(), request_text.data() + offset, request_text.size() - offset, MSG_NOSIGNAL);
+            offset += max<ssize_t>(size, 0);
+        }
+        string response_text;
+        poll_fd.events = POLLIN;
+        while (count(response_text.begin(), response_text.end(), '\n') < 100 && poll(&poll_fd, 1, 5000) > 0) {
+            char buffer[4096];
+            const ssize_t size = read(socket.Get(), buffer, sizeof(buffer));
+            if (size <= 0) {
+                break;
+            }
+            response_text.append(buffer, size);
+        }
+        istringstream responses(response_text);
+        string response;
+        for (const string& request : requests) {
+            ASSERT(getline(responses, response));
+            ASSERT_EQUAL(response, SearchFrontend::Execute(server, request));
+        }
+    }
+    frontend.Stop();
+    serving.join();
+}
+
+// Тест проверяет учёт памяти индекса по структурам и выделение памяти из заданного ресурса
+void TestMemoryStats() {
+    CountingMemoryResource upstream;
+    CountingMemoryResource default_resource;
+    IndexOptions options;
+    options.store_positions = true;
+    options.max_edit_distance = 1;
+    options.memory_resource = &upstream;
+    {
+        SearchServer server("and with"s, options);
+        // Структуры индекса не выделяют память из ресурса по умолчанию
+        pmr::memory_resource* previous_default = pmr::set_default_resource(&default_resource);
+        for (int id = 0; id < 300; ++id) {
+            server.AddDocument(id, "fluffy cat with collar number"s + to_string(id), static_cast<DocumentStatus>(id % 3), {id % 10});
+        }
+        const MemoryStats filled = server.GetMemoryStats();
+        for (int id = 0; id < 300; id += 2) {
+            server.RemoveDocument(id);
+        }
+        while (!server.Vacuum(chrono::seconds(1)).pass_completed) {
+        }
+        pmr::set_default_resource(previous_default);
+        ASSERT_EQUAL(default_resource.GetUsage().total_allocations, 0u);
+
+        // Вся память индекса учтена по структурам
+        const MemoryStats stats = server.GetMemoryStats();
+        ASSERT_EQUAL(stats.GetTotal().bytes, upstream.GetUsage().bytes);
+        ASSERT_EQUAL(stats.GetTotal().allocations, upstream.GetUsage().allocations);
+        for (const MemoryUsage* usage : {&filled.dictionary, &filled.postings, &filled.positions, &filled.fuzzy_index,
+                                         &filled.forward_index, &filled.metadata, &filled.filters}) {
+            ASSERT(usage->bytes > 0 && usage->allocations > 0);
+        }
+        ASSERT(stats.dictionary.bytes < filled.dictionary.bytes);
+        ASSERT(stats.postings.allocations < filled.postings.allocations);
+        ASSERT(stats.GetTotal().total_allocations >= filled.GetTotal().total_allocations);
+
+        // Перемещённый сервер продолжает работать с теми же ресурсами
+        SearchServer moved = move(server);
+        moved.AddDocument(1000, "fluffy dog"s, DocumentStatus::ACTUAL, {1});
+        ASSERT_EQUAL(moved.FindTopDocuments("dog"s).size(), 1u);
+        ASSERT_EQUAL(moved.GetMemoryStats().GetTotal().bytes, upstream.GetUsage().bytes);
+    }
+    ASSERT_EQUAL(upstream.GetUsage().bytes, 0u);
+
+    // Индекс в монотонном ресурсе ищет так же, как в обычном
+    pmr::monotonic_buffer_resource arena;
+    options.memory_resource = &arena;
+    SearchServer arena_server("and with"s, options);
+    SearchServer heap_server("and with"s);
+    for (int id = 0; id < 100; ++id) {
+        const string text = "cat number"s + to_string(id % 7) + (id % 3 == 0 ? " fluffy"s : " white"s);
+        arena_server.AddDocument(id, text, DocumentStatus::ACTUAL, {id});
+        heap_server.AddDocument(id, text, DocumentStatus::ACTUAL, {id});
+    }
+    const vector<Document> arena_result = arena_server.FindTopDocuments("fluffy number3"s);
+    const vector<Document> heap_result = heap_server.FindTopDocuments("fluffy number3"s);
+    ASSERT_EQUAL(arena_result.size(), heap_result.size());
+    for (size_t i = 0; i < arena_result.size(); ++i) {
+        ASSERT_EQUAL(arena_result[i].id, heap_result[i].id);
+    }
+}
+
+// Тест проверяет запись запросов в двоичный лог и его чтение
+void TestQueryLog() {
+    SearchServer server("and with"s);
+    server.AddDocument(1, "fluffy cat with collar"s, DocumentStatus::ACTUAL, {5});
+    server.AddDocument(2, "white dog"s, DocumentStatus::BANNED, {1});
+    const string path = "/tmp/search-server-test-"s + to_string(getpid()) + ".qlog"s;
+    {
+        QueryLogOptions options;
+        options.max_query_length = 10;
+        QueryLog log(path, options);
+        RequestQueue queue(server, &log);
+        queue.AddFindRequest("cat"s);
+        queue.AddFindRequest("dog"s, DocumentStatus::BANNED);
+        queue.AddFindRequest("dog"s, DocumentFilter().MinRating(2));
+        queue.AddFindRequest("cat dog"s, [](int document_id, DocumentStatus, int) {
+            return document_id == 2;
+        });
+        queue.AddFindRequest("fluffy white collar"s);
+        log.Flush();
+        ifstream input(path, ios::binary);
+        ASSERT_EQUAL(ReadQueryLog(input).size(), 5u);
+        // Диапазоны атрибутов сверх ограничений записи отбрасываются с пометкой
+        const DocumentFilter dated_filter = DocumentFilter(DocumentStatus::ACTUAL).AttributeBetween("date"s, 10, 20).AttributeAtLeast("price"s, 1.5);
+        log.Record("dated"s, &dated_filter, QueryLog::Now(), 1, 0);
+        DocumentFilter wide_filter;
+        for (int i = 0; i < 6; ++i) {
+            wide_filter.AttributeAtMost("a"s + to_string(i), i);
+        }
+        log.Record("wide"s, &wide_filter, QueryLog::Now(), 1, 0);
+
+        // Записи из нескольких потоков либо попадают в лог, либо учитываются как потерянные
+        vector<thread> threads;
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back([&log] {
+                for (int j = 0; j < 1000; ++j) {
+                    log.Record("parallel"s, nullptr, QueryLog::Now(), 1, 0);
+                }
+            });
+        }
+        for (thread& t : threads) {
+            t.join();
+        }
+        ASSERT_EQUAL(queue.GetNoResultRequests(), 1);
+    }
+    ifstream input(path, ios::binary);
+    const string data{istreambuf_iterator<char>(input), istreambuf_iterator<char>()};
+    remove(path.c_str());
+    istringstream full_log(data);
+    const vector<QueryLogRecord> records = ReadQueryLog(full_log);
+    ASSERT(records.size() > 7 && records.size() <= 4007);
+
+    ASSERT_EQUAL(records[0].query, "cat"s);
+    ASSERT_EQUAL(records[0].result_count, 1u);
+    ASSERT(records[0].filter.IsStatusAllowed(DocumentStatus::ACTUAL));
+    ASSERT(!records[0].filter.IsStatusAllowed(DocumentStatus::BANNED));
+    ASSERT(!records[0].has_custom_predicate);
+    ASSERT(records[0].timestamp_us > 0 && records[0].timestamp_us <= records[4].timestamp_us);
+    ASSERT(records[1].filter.IsStatusAllowed(DocumentStatus::BANNED));
+    ASSERT_EQUAL(records[1].result_count, 1u);
+    ASSERT_EQUAL(records[2].filter.GetMinRating(), 2);
+    ASSERT(!records[2].filter.HasStatusRestriction());
+    ASSERT_EQUAL(records[2].result_count, 0u);
+    ASSERT(records[3].has_custom_predicate);
+    // Длинный запрос обрезается и помечается
+    ASSERT_EQUAL(records[4].query, "fluffy whi"s);
+    ASSERT(records[4].is_query_truncated);
+    const vector<AttributeRange>& dated_ranges = records[5].filter.GetAttributeRanges();
+    ASSERT(!records[5].is_filter_truncated);
+    ASSERT(records[5].filter.IsStatusAllowed(DocumentStatus::ACTUAL) && !records[5].filter.IsStatusAllowed(DocumentStatus::BANNED));
+    ASSERT_EQUAL(dated_ranges.size(), 2u);
+    ASSERT_EQUAL(dated_ranges[0].name, "date"s);
+    ASSERT_EQUAL(dated_ranges[0].max.GetInteger(), 20);
+    ASSERT_EQUAL(dated_ranges[1].name, "price"s);
+    ASSERT_EQUAL(dated_ranges[1].min.GetReal(), 1.5);
+    ASSERT(records[6].is_filter_truncated);
+    ASSERT_EQUAL(records[6].filter.GetAttributeRanges().size(), 4u);
+    ASSERT(!records[0].is_query_truncated && !records[3].is_query_truncated);
+
+    // Оборванная последняя запись пропускается, чужой файл не читается
+    istringstream truncated_log(data.substr(0, data.size() - 3));
+    ASSERT_EQUAL(ReadQueryLog(truncated_log).size(), records.size() - 1);
+    istringstream not_a_log("hello"s);
+    try {
+        ReadQueryLog(not_a_log);
+        ASSERT_HINT(false, "Invalid log must be rejected"s);
+    } catch (const invalid_argument&) {
+    }
+}
+
+// Тест проверяет фильтрацию по диапазонам числовых атрибутов документов
+void TestAttributeFilters() {
+    IndexOptions options;
+    options.attributes = {{"date"s, AttributeType::INTEGER}, {"price"s, AttributeType::REAL}};
+    SearchServer server(""s, options);
+    server.AddDocument(1, "cat"s, DocumentStatus::ACTUAL, {1}, {{"date"s, 20240101}, {"price"s, 9.5}});
+    server.AddDocument(2, "cat"s, DocumentStatus::BANNED, {1}, {{"date"s, 20240215}, {"price"s, -3}});
+    server.AddDocument(3, "cat"s, DocumentStatus::ACTUAL, {1}, {{"price"s, 120.0}});
+    server.AddDocument(4, "cat"s, DocumentStatus::ACTUAL, {1});
+
+    const auto search = [&server](const DocumentFilter& filter) {
+        return server.FindTopDocuments("cat"s, PageCursor(), 1000, filter);
+    };
+
+    // Документы без атрибута не проходят фильтр по нему
+    ASSERT_EQUAL(GetSortedIds(search(DocumentFilter().AttributeAtLeast("date"s, 20240101))), vector<int>({1, 2}));
+    ASSERT_EQUAL(GetSortedIds(search(DocumentFilter().AttributeAtLeast("date"s, 20240102))), vector<int>({2}));
+    ASSERT_EQUAL(GetSortedIds(search(DocumentFilter(DocumentStatus::ACTUAL).AttributeAtLeast("date"s, 0))), vector<int>({1}));
+    ASSERT_EQUAL(GetSortedIds(search(DocumentFilter().AttributeBetween("price"s, -5, 10))), vector<int>({1, 2}));
+    ASSERT_EQUAL(GetSortedIds(search(DocumentFilter().AttributeAtMost("price"s, -3.0))), vector<int>({2}));
+    // Дробные границы целочисленного атрибута округляются внутрь диапазона
+    ASSERT_EQUAL(GetSortedIds(search(DocumentFilter().AttributeBetween("date"s, 20240100.5, 20240101.5))), vector<int>({1}));
+    // Несколько диапазонов пересекаются
+    ASSERT_EQUAL(GetSortedIds(search(DocumentFilter().AttributeAtLeast("price"s, 0).AttributeAtMost("date"s, 20240301))), vector<int>({1}));
+    ASSERT_EQUAL(GetSortedIds(search(DocumentFilter().AttributeAtLeast("price"s, 0).MinRating(2))), vector<int>());
+
+    // Неизвестный атрибут и дробное значение целочисленного атрибута отвергаются
+    try {
+        server.FindTopDocuments("cat"s, DocumentFilter().AttributeAtLeast("size"s, 1));
+        ASSERT_HINT(false, "Unknown attribute must be rejected"s);
+    } catch (const invalid_argument&) {
+    }
+    try {
+        server.AddDocument(5, "cat"s, DocumentStatus::ACTUAL, {1}, {{"date"s, 1.5}});
+        ASSERT_HINT(false, "Real value of an integer attribute must be rejected"s);
+    } catch (const invalid_argument&) {
+    }
+    ASSERT_EQUAL(server.GetDocumentCount(), 4);
+
+    // На большом числе документов фильтр совпадает с предикатом, в том числе после удалений
+    SearchServer large_server(""s, options);
+    map<int, double> prices;
+    for (int id = 0; id < 3000; ++id) {
+        const double price = (id * 7919 % 1000) / 10.0 - 20.0;
+        prices[id] = price;
+        large_server.AddDocument(id, "cat"s, DocumentStatus::ACTUAL, {1}, {{"price"s, price}});
+    }
+    for (int id = 0; id < 3000; id += 3) {
+        large_server.RemoveDocument(id);
+        prices.erase(id);
+    }
+    for (const auto& [min_price, max_price] : vector<pair<double, double>>{{-20.0, 79.9}, {0.0, 0.5}, {-1.0, -1.0}, {50.0, 10.0}}) {
+        vector<int> expected;
+        for (const auto& [id, price] : prices) {
+            if (min_price <= price && price <= max_price) {
+                expected.push_back(id);
+            }
+        }
+        ASSERT_EQUAL(GetSortedIds(large_server.FindTopDocuments(
+                         "cat"s, PageCursor(), 10000, DocumentFilter().AttributeBetween("price"s, min_price, max_price))),
+                     expected);
+    }
+    // Запрос по редкому слову проверяет документы по множеству фильтра, не разворачивая его в битовый массив
+    large_server.AddDocument(5000, "rare dog"s, DocumentStatus::ACTUAL, {1}, {{"price"s, 5.0}});
+    ASSERT_EQUAL(GetIds(large_server.FindTopDocuments("dog"s, DocumentFilter().AttributeBetween("price"s, 0, 10))), vector<int>({5000}));
+    ASSERT(large_server.FindTopDocuments("dog"s, DocumentFilter().AttributeAtLeast("price"s, 6)).empty());
+
+    // После переиспользования номеров удаленных документов атрибуты остаются при своих документах
+    SearchServer cycled_server(""s, options);
+    for (int round = 0; round < 10; ++round) {
+        for (int i = 0; i < 50; ++i) {
+            const int id = round * 50 + i;
+            cycled_server.AddDocument(id, "cat"s, DocumentStatus::ACTUAL, {1}, {{"date"s, id}});
+        }
+        if (round > 0) {
+            for (int i = 0; i < 50; ++i) {
+                cycled_server.RemoveDocument((round - 1) * 50 + i);
+            }
+        }
+        ASSERT_EQUAL(GetSortedIds(cycled_server.FindTopDocuments(
+                         "cat"s, PageCursor(), 1000, DocumentFilter().AttributeBetween("date"s, round * 50 - 10, round * 50 + 2))),
+                     vector<int>({round * 50, round * 50 + 1, round * 50 + 2}));
+    }
+
+    // Диапазоны передаются по протоколу частей индекса
+    MessageWriter writer;
+    WriteDocumentFilter(writer, DocumentFilter(DocumentStatus::ACTUAL).AttributeBetween("date"s, 5, 7.5));
+    MessageReader reader(writer.GetData());
+    const DocumentFilter decoded = ReadDocumentFilter(reader);
+    ASSERT_EQUAL(decoded.GetAttributeRanges().size(), 1u);
+    ASSERT_EQUAL(decoded.GetAttributeRanges()[0].name, "date"s);
+    ASSERT_EQUAL(decoded.GetAttributeRanges()[0].min.GetInteger(), 5);
+    ASSERT_EQUAL(decoded.GetAttributeRanges()[0].max.GetReal(), 7.5);
+}
+
+// Тест проверяет подсчёт общего числа совпадений и фасетов в том же проходе, что и поиск лучших документов
+void TestSearchFacets() {
+    SearchServer server("and"s);
+    server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "black cat"s, DocumentStatus::ACTUAL, {5});
+    server.AddDocument(3, "cat"s, DocumentStatus::BANNED, {5});
+    server.AddDocument(4, "cat and dog"s, DocumentStatus::ACTUAL, {12});
+    server.AddDocument(5, "fluffy cat"s, DocumentStatus::IRRELEVANT, {-3});
+    server.AddDocument(6, "cat"s, DocumentStatus::ACTUAL, {-1});
+    server.AddDocument(7, "parrot"s, DocumentStatus::ACTUAL, {3});
+
+    SearchOptions options;
+    options.filter = DocumentFilter(DocumentStatus::ACTUAL).MinRating(0);
+    options.top_k = 1;
+    options.count_statuses = true;
+    options.rating_bucket_width = 5;
+    const SearchResult result = server.Search("cat -dog"s, options);
+    ASSERT_EQUAL(result.total_hits, 2u);
+    ASSERT_EQUAL(result.documents.size(), 1u);
+    ASSERT_EQUAL(result.documents[0].id, server.FindTopDocuments("cat -dog"s, PageCursor(), 1, options.filter)[0].id);
+    // Фасет по статусу считается без ограничения на статус, но с ограничением на рейтинг
+    ASSERT_EQUAL(result.status_counts[static_cast<size_t>(DocumentStatus::ACTUAL)], 2u);
+    ASSERT_EQUAL(result.status_counts[static_cast<size_t>(DocumentStatus::BANNED)], 1u);
+    ASSERT_EQUAL(result.status_counts[static_cast<size_t>(DocumentStatus::IRRELEVANT)], 0u);
+    // Фасет по рейтингу - наоборот; отрицательные рейтинги округляются вниз
+    ASSERT_EQUAL(result.rating_counts, (map<int, size_t>{{-5, 1}, {0, 1}, {5, 1}}));
+
+    // Курсор сдвигает документы, но не счётчики
+    options.after = PageCursor(result.documents[0]);
+    const SearchResult next = server.Search("cat -dog"s, options);
+    ASSERT_EQUAL(next.total_hits, 2u);
+    ASSERT_EQUAL(next.documents.size(), 1u);
+    ASSERT(next.documents[0].id != result.documents[0].id);
+
+    // Без фасетов считаются только совпадения самого фильтра
+    const SearchResult plain = server.Search("cat"s, SearchOptions());
+    ASSERT_EQUAL(plain.total_hits, 4u);
+    ASSERT_EQUAL(plain.status_counts[static_cast<size_t>(DocumentStatus::ACTUAL)], 0u);
+    ASSERT(plain.rating_counts.empty());
+
+    // Параллельный подсчёт по частям совпадает с последовательным
+    SearchServer large_server(""s);
+    for (int id = 0; id < 20000; ++id) {
+        large_server.AddDocument(id, id % 3 == 0 ? "cat dog"s : "cat"s, static_cast<DocumentStatus>(id % 4), {id % 100 - 50});
+    }
+    SearchOptions large_options;
+    large_options.filter = DocumentFilter(DocumentStatus::ACTUAL).MaxRating(10);
+    large_options.top_k = 20;
+    large_options.count_statuses = true;
+    large_options.rating_bucket_width = 7;
+    const SearchResult sequential = large_server.Search(execution::seq, "cat -dog"s, large_options);
+    const SearchResult parallel = large_server.Search(execution::par, "cat -dog"s, large_options);
+    ASSERT_EQUAL(sequential.total_hits, large_server.FindTopDocuments("cat -dog"s, PageCursor(), 100000, large_options.filter).size());
+    ASSERT_EQUAL(parallel.total_hits, sequential.total_hits);
+    ASSERT(parallel.status_counts == sequential.status_counts);
+    ASSERT_EQUAL(parallel.rating_counts, sequential.rating_counts);
+    ASSERT(HaveSameResults(parallel.documents, sequential.documents));
+
+    // Запрос по редкому слову проверяет документы по множествам фильтров, не разворачивая их в битовые массивы
+    large_server.AddDocument(30000, "rare cat"s, DocumentStatus::BANNED, {5});
+    large_server.AddDocument(30001, "rare"s, DocumentStatus::ACTUAL, {20});
+    const SearchResult rare = large_server.Search("rare"s, large_options);
+    ASSERT_EQUAL(rare.total_hits, 0u);
+    ASSERT_EQUAL(rare.status_counts[static_cast<size_t>(DocumentStatus::BANNED)], 1u);
+    ASSERT_EQUAL(rare.status_counts[static_cast<size_t>(DocumentStatus::ACTUAL)], 0u);
+    ASSERT_EQUAL(rare.rating_counts, (map<int, size_t>{{14, 1}}));
+
+    options.rating_bucket_width = -1;
+    try {
+        server.Search("cat"s, options);
+        ASSERT_HINT(false, "Negative bucket width must be rejected"s);
+    } catch (const invalid_argument&) {
+    }
+}
+
+// Тест проверяет блочный список документов слова и поиск с плотными накопителями и со словарём
+void TestPostingList() {
+    pmr::monotonic_buffer_resource resource;
+    PostingList postings(&resource);
+    for (uint32_t ordinal = 0; ordinal < 300; ordinal += 3) {
+        postings.Append(ordinal, ordinal + 1);
+    }
+    ASSERT_EQUAL(postings.Size(), 100u);
+    // Поиск находит документы во всех блоках, включая неполный последний
+    for (uint32_t ordinal = 0; ordinal < 300; ++ordinal) {
+        ASSERT_EQUAL(postings.Contains(ordinal), ordinal % 3 == 0);
+        ASSERT_EQUAL(postings.LowerBound(ordinal), (ordinal + 2) / 3);
+    }
+    ASSERT_EQUAL(postings.Find(299), postings.Size());
+    ASSERT_EQUAL(postings.Counts()[postings.Find(150)], 151u);
+
+    // После удалений границы блоков сдвигаются
+    postings.Erase(postings.Find(0));
+    postings.EraseIf([&postings](size_t i) {
+        return postings.Ordinals()[i] % 2 == 0;
+    });
+    vector<uint32_t> expected;
+    for (uint32_t ordinal = 3; ordinal < 300; ordinal += 6) {
+        expected.push_back(ordinal);
+    }
+    ASSERT_EQUAL(vector<uint32_t>(postings.Ordinals(), postings.Ordinals() + postings.Size()), expected);
+    for (uint32_t ordinal = 0; ordinal < 300; ++ordinal) {
+        ASSERT_EQUAL(postings.Contains(ordinal), ordinal % 6 == 3);
+    }
+    postings.ShrinkToFit();
+    ASSERT(postings.Capacity() < 2 * postings.Size());
+    const PostingList copy(postings, pmr::get_default_resource());
+    ASSERT_EQUAL(vector<uint32_t>(copy.Counts(), copy.Counts() + copy.Size()),
+                 vector<uint32_t>(postings.Counts(), postings.Counts() + postings.Size()));
+
+    // Редкое слово ищется со словарём накопителей, частое - с плотными накопителями; результаты одинаковы,
+    // в том числе с упреждающей загрузкой
+    for (const size_t prefetch_min_documents : {size_t{0}, numeric_limits<size_t>::max()}) {
+        IndexOptions options;
+        options.prefetch_min_documents = prefetch_min_documents;
+        SearchServer server(""s, options);
+        const int document_count = 5000;
+        for (int id = 0; id < document_count; ++id) {
+            server.AddDocument(id, id % 500 == 0 ? "rare common"s : "common filler"s, DocumentStatus::ACTUAL, {id});
+        }
+        const double rare_relevance = 0.5 * log(document_count / 10.0);
+        const vector<Document> rare = server.FindTopDocuments("rare"s, PageCursor(), 100);
+        ASSERT_EQUAL(rare.size(), 10u);
+        const vector<Document> both = server.FindTopDocuments("rare common"s, PageCursor(), 100000);
+        ASSERT_EQUAL(both.size(), static_cast<size_t>(document_count));
+        for (size_t i = 0; i < rare.size(); ++i) {
+            ASSERT_EQUAL(rare[i].id, both[i].id);
+            ASSERT(abs(rare[i].relevance - rare_relevance) < 1e-9);
+            ASSERT(abs(both[i].relevance - rare_relevance) < 1e-9);
+        }
+        const vector<Document> parallel = server.FindTopDocuments(execution::par, "rare common -filler"s);
+        ASSERT_EQUAL(parallel.size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT));
+        ASSERT_EQUAL(parallel[0].id, rare[0].id);
+    }
+}
+
 // Функция TestSearchServer является точкой входа для запуска тестов
 void TestSearchServer() {
     RUN_TEST(TestExcludeStopWordsFromAddedDocumentContent);
@@ -230,6 +1606,29 @@ void TestSearchServer() {
     RUN_TEST(TestFindTopDocumentsWithLambdaFilter);
     RUN_TEST(TestFindTopDocumentsWithStatus);
     RUN_TEST(TestDocumentRelevanceCalculation);
+    RUN_TEST(TestGetWordFrequencies);
+    RUN_TEST(TestBitmap);
+    RUN_TEST(TestFindTopDocumentsWithDocumentFilter);
+    RUN_TEST(TestDocumentIdIteration);
+    RUN_TEST(TestAddRemoveCycles);
+    RUN_TEST(TestPhraseQueries);
+    RUN_TEST(TestPrefixQueries);
+    RUN_TEST(TestRemoveDocuments);
+    RUN_TEST(TestVacuum);
+    RUN_TEST(TestQueryPlan);
+    RUN_TEST(TestFuzzyMatching);
+    RUN_TEST(TestPagination);
+    RUN_TEST(TestScoringPolicies);
+    RUN_TEST(TestFloatScoring);
+    RUN_TEST(TestStopWords);
+    RUN_TEST(TestShardedSearchServer);
+    RUN_TEST(TestShardBroker);
+    RUN_TEST(TestSearchFrontend);
+    RUN_TEST(TestMemoryStats);
+    RUN_TEST(TestQueryLog);
+    RUN_TEST(TestAttributeFilters);
+    RUN_TEST(TestSearchFacets);
+    RUN_TEST(TestPostingList);
 }
 
 // --------- Окончание модульных тестов поисковой системы -----------
\ No newline at end of file
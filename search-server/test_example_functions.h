@@ -5,6 +5,8 @@
 #include <set>
 #include <map>
 
+#include "document.h"
+
 template <typename T>
 std::ostream& operator <<(std::ostream& out, const std::vector<T>& v) {
     out << "[";
@@ -82,6 +84,15 @@ void AssertImpl(bool value, const std::string& expr_str, const std::string& file
 
 #define ASSERT_HINT(expr, hint) AssertImpl(!!(expr), #expr, __FILE__, __FUNCTION__, __LINE__, (hint))
 
+// Идентификаторы найденных документов в порядке выдачи
+std::vector<int> GetIds(const std::vector<Document>& documents);
+
+// Идентификаторы найденных документов в порядке возрастания
+std::vector<int> GetSortedIds(const std::vector<Document>& documents);
+
+// Результаты поиска совпадают по идентификаторам, рейтингам и релевантности с точностью до EPS
+bool HaveSameResults(const std::vector<Document>& lhs, const std::vector<Document>& rhs);
+
 // -------- Начало модульных тестов поисковой системы ----------
 
 // Тест проверяет исключение документов содержащих минус слова
@@ -108,6 +119,75 @@ void TestDocumentRelevanceCalculation();
 // Тест проверяет, что поисковая система исключает стоп-слова при добавлении документов
 void TestExcludeStopWordsFromAddedDocumentContent();
 
+// Тест проверяет частоты слов документа и их удаление вместе с документом
+void TestGetWordFrequencies();
+
+// Тест проверяет операции над сжатым битовым множеством
+void TestBitmap();
+
+// Тест проверяет фильтрацию результатов поиска по статусу и диапазону рейтинга через DocumentFilter
+void TestFindTopDocumentsWithDocumentFilter();
+
+// Тест проверяет, что идентификаторы документов перебираются по возрастанию независимо от порядка добавления
+void TestDocumentIdIteration();
+
+// Тест проверяет поиск после многократного добавления и удаления документов
+void TestAddRemoveCycles();
+
+// Тест проверяет поиск по фразам в кавычках и бонус за близость слов запроса
+void TestPhraseQueries();
+
+// Тест проверяет поиск по префиксам слов
+void TestPrefixQueries();
+
+// Тест проверяет пакетное удаление документов, в том числе параллельное
+void TestRemoveDocuments();
+
+// Тест проверяет очистку словаря и списков документов после удалений
+void TestVacuum();
+
+// Тест проверяет план выполнения запроса и его влияние на поиск
+void TestQueryPlan();
+
+// Тест проверяет поиск с исправлением опечаток
+void TestFuzzyMatching();
+
+// Тест проверяет постраничную выдачу результатов с курсором
+void TestPagination();
+
+// Тест проверяет поиск с задаваемыми при компиляции способом оценки, фильтром и порядком результатов
+void TestScoringPolicies();
+
+// Тест проверяет совпадение результатов поиска со счетом во float и в double
+void TestFloatScoring();
+
+// Тест проверяет поиск в таблице стоп-слов
+void TestStopWords();
+
+// Тест проверяет, что сервер из нескольких частей ищет так же, как один сервер
+void TestShardedSearchServer();
+
+// Тест проверяет поиск через брокер по частям индекса в других процессах (здесь — потоках)
+void TestShardBroker();
+
+// Тест проверяет сетевой интерфейс: формат ответов и их порядок при конвейерной отправке запросов
+void TestSearchFrontend();
+
+// Тест проверяет учёт памяти индекса по структурам и выделение памяти из заданного ресурса
+void TestMemoryStats();
+
+// Тест проверяет запись запросов в двоичный лог и его чтение
+void TestQueryLog();
+
+// Тест проверяет фильтрацию по диапазонам числовых атрибутов документов
+void TestAttributeFilters();
+
+// Тест проверяет подсчёт общего числа совпадений и фасетов в том же проходе, что и поиск лучших документов
+void TestSearchFacets();
+
+// Тест проверяет блочный список документов слова и поиск с плотными накопителями и со словарём
+void TestPostingList();
+
 // Функция TestSearchServer является точкой входа для запуска тестов
 void TestSearchServer();
 
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Entry of the forward index: term id and the number of its occurrences in a document.
+// Together with the document length the count gives the exact term frequency.
+struct TermFrequency {
+    uint32_t term_id;
+    uint32_t count;
+};
+
+// Read-only view over the forward index record of one document.
+// Iterates (word, term frequency) pairs in lexicographic order of words.
+// The view is invalidated by any modification of the search server.
+class WordFrequencies {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<std::string_view, double>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator() = default;
+
+        Iterator(const TermFrequency* entry, const std::string_view* terms, double inv_word_count)
+            : entry_(entry)
+            , terms_(terms)
+            , inv_word_count_(inv_word_count) {
+        }
+
+        value_type operator*() const {
+            return {terms_[entry_->term_id], entry_->count * inv_word_count_};
+        }
+
+        Iterator& operator++() {
+            ++entry_;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator result = *this;
+            ++entry_;
+            return result;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return entry_ == other.entry_;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return entry_ != other.entry_;
+        }
+
+    private:
+        const TermFrequency* entry_ = nullptr;
+        const std::string_view* terms_ = nullptr;
+        double inv_word_count_ = 0.0;
+    };
+
+    WordFrequencies() = default;
+
+    WordFrequencies(const TermFrequency* begin, const TermFrequency* end,
+                    const std::string_view* terms, double inv_word_count)
+        : begin_(begin)
+        , end_(end)
+        , terms_(terms)
+        , inv_word_count_(inv_word_count) {
+    }
+
+    Iterator begin() const {
+        return {begin_, terms_, inv_word_count_};
+    }
+
+    Iterator end() const {
+        return {end_, terms_, inv_word_count_};
+    }
+
+    size_t size() const {
+        return end_ - begin_;
+    }
+
+    bool empty() const {
+        return begin_ == end_;
+    }
+
+private:
+    const TermFrequency* begin_ = nullptr;
+    const TermFrequency* end_ = nullptr;
+    const std::string_view* terms_ = nullptr;
+    double inv_word_count_ = 0.0;
+};
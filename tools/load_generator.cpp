@@ -0,0 +1,153 @@
+// Closed-loop load on a SearchFrontend: every connection keeps up to <depth> requests in flight.
+// Requests are the lines of the queries file prefixed with "FIND ", cycled through.
+// Prints throughput and latency percentiles.
+// Usage: load_generator <port> <queries file> [connections] [depth] [seconds] [address]
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "socket_util.h"
+
+using namespace std;
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+struct ConnectionResult {
+    vector<double> latencies_us;
+    size_t errors = 0;
+};
+
+void WaitFor(const UniqueFd& socket, short events) {
+    pollfd poll_fd{socket.Get(), events, 0};
+    while (poll(&poll_fd, 1, -1) < 0) {
+        if (errno != EINTR) {
+            throw system_error(errno, generic_category(), "poll"s);
+        }
+    }
+}
+
+ConnectionResult RunConnection(const string& address, uint16_t port, const vector<string>& queries, size_t first_query,
+                               size_t depth, Clock::time_point end) {
+    UniqueFd socket = ConnectTcpSocket(address, port);
+    ConnectionResult result;
+    deque<Clock::time_point> sent;
+    string input;
+    size_t next_query = first_query;
+    while (Clock::now() < end || !sent.empty()) {
+        // All requests fitting into the window go out with one send
+        string output;
+        while (Clock::now() < end && sent.size() < depth) {
+            output += "FIND "s + queries[next_query++ % queries.size()] + "\n"s;
+            sent.push_back(Clock::now());
+        }
+        for (size_t offset = 0; offset < output.size();) {
+            const ssize_t size = send(socket.Get(), output.data() + offset, output.size() - offset, MSG_NOSIGNAL);
+            if (size >= 0) {
+                offset += size;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOTCONN) {
+                WaitFor(socket, POLLOUT);
+            } else if (errno != EINTR) {
+                throw system_error(errno, generic_category(), "send"s);
+            }
+        }
+
+        WaitFor(socket, POLLIN);
+        char buffer[64 * 1024];
+        const ssize_t size = read(socket.Get(), buffer, sizeof(buffer));
+        if (size == 0) {
+            throw runtime_error("Server closed the connection"s);
+        }
+        if (size < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                continue;
+            }
+            throw system_error(errno, generic_category(), "read"s);
+        }
+        input.append(buffer, size);
+        const Clock::time_point now = Clock::now();
+        size_t line_start = 0;
+        for (size_t line_end = input.find('\n'); line_end != string::npos; line_end = input.find('\n', line_start)) {
+            result.latencies_us.push_back(chrono::duration<double, micro>(now - sent.front()).count());
+            sent.pop_front();
+            result.errors += input.compare(line_start, 5, "ERROR"s) == 0;
+            line_start = line_end + 1;
+        }
+        input.erase(0, line_start);
+    }
+    return result;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 3 || argc > 7) {
+        cerr << "Usage: " << argv[0] << " <port> <queries file> [connections] [depth] [seconds] [address]" << endl;
+        return 2;
+    }
+    const auto port = static_cast<uint16_t>(stoi(argv[1]));
+    const size_t connection_count = argc > 3 ? stoul(argv[3]) : 4;
+    const size_t depth = argc > 4 ? stoul(argv[4]) : 16;
+    const double seconds = argc > 5 ? stod(argv[5]) : 5.0;
+    const string address = argc > 6 ? argv[6] : "127.0.0.1"s;
+    vector<string> queries;
+    ifstream queries_file(argv[2]);
+    for (string query; getline(queries_file, query);) {
+        queries.push_back(move(query));
+    }
+    if (queries.empty() || connection_count == 0 || depth == 0) {
+        cerr << "Nothing to send" << endl;
+        return 2;
+    }
+
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point end = start + chrono::duration_cast<Clock::duration>(chrono::duration<double>(seconds));
+    vector<ConnectionResult> results(connection_count);
+    vector<thread> connections;
+    for (size_t i = 0; i < connection_count; ++i) {
+        connections.emplace_back([&, i] {
+            try {
+                results[i] = RunConnection(address, port, queries, i * queries.size() / connection_count, depth, end);
+            } catch (const exception& e) {
+                cerr << "Connection " << i << ": " << e.what() << endl;
+            }
+        });
+    }
+    for (thread& connection : connections) {
+        connection.join();
+    }
+    const double elapsed = chrono::duration<double>(Clock::now() - start).count();
+
+    vector<double> latencies;
+    size_t errors = 0;
+    for (const ConnectionResult& result : results) {
+        latencies.insert(latencies.end(), result.latencies_us.begin(), result.latencies_us.end());
+        errors += result.errors;
+    }
+    if (latencies.empty()) {
+        cerr << "No responses" << endl;
+        return 1;
+    }
+    sort(latencies.begin(), latencies.end());
+    const auto percentile = [&latencies](double p) {
+        return latencies[min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))];
+    };
+    cout << "requests: " << latencies.size() << ", errors: " << errors << endl;
+    cout << "throughput: " << latencies.size() / elapsed << " requests/s" << endl;
+    cout << "latency, us: p50 " << percentile(0.5) << ", p90 " << percentile(0.9) << ", p99 " << percentile(0.99)
+         << ", max " << latencies.back() << endl;
+}
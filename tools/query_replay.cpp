@@ -0,0 +1,133 @@
+// Replays a query log against a SearchServer built from a documents file, from several threads.
+// The rate is a fixed number of queries per second (open loop: a query starts at its scheduled
+// time whether earlier ones have finished or not, and its latency counts from that time),
+// "log" to keep the intervals of the log, or "max" to send the next query as soon as a thread is free.
+// Every line of the documents file is an ACTUAL document, its id is the line number from 0.
+// Queries logged with a custom predicate are replayed without a filter. Truncated queries are skipped
+// and counted, since their results cannot be compared with the log.
+// Prints throughput, latency percentiles and the queries whose result count differs from the log.
+// Usage: query_replay <documents file> <query log> [rate] [threads] [stop words]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <execution>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "query_log.h"
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+struct ThreadResult {
+    vector<double> latencies_us;
+    size_t mismatches = 0;
+};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 3 || argc > 6) {
+        cerr << "Usage: " << argv[0] << " <documents file> <query log> [queries per second|log|max] [threads] [stop words]"
+             << endl;
+        return 2;
+    }
+    try {
+        SearchServer server(argc > 5 ? string(argv[5]) : string());
+        ifstream documents(argv[1]);
+        ifstream log(argv[2], ios::binary);
+        if (!documents || !log) {
+            cerr << "Cannot open " << (documents ? argv[2] : argv[1]) << endl;
+            return 1;
+        }
+        int document_id = 0;
+        for (string document; getline(documents, document);) {
+            server.AddDocument(document_id++, document, DocumentStatus::ACTUAL, {});
+        }
+        vector<QueryLogRecord> records;
+        size_t truncated_count = 0;
+        for (QueryLogRecord& record : ReadQueryLog(log)) {
+            if (record.is_query_truncated) {
+                ++truncated_count;
+            } else {
+                records.push_back(move(record));
+            }
+        }
+        if (records.empty()) {
+            cerr << "The log has no complete queries" << endl;
+            return 1;
+        }
+
+        // Start of every query relative to the start of the replay; empty for "max"
+        const string rate = argc > 3 ? argv[3] : "max"s;
+        vector<Clock::duration> schedule;
+        if (rate == "log"s) {
+            for (const QueryLogRecord& record : records) {
+                schedule.push_back(chrono::microseconds(record.timestamp_us - records.front().timestamp_us));
+            }
+        } else if (rate != "max"s) {
+            const double interval = 1.0 / stod(rate);
+            for (size_t i = 0; i < records.size(); ++i) {
+                schedule.push_back(chrono::duration_cast<Clock::duration>(chrono::duration<double>(i * interval)));
+            }
+        }
+        const size_t thread_count = argc > 4 ? stoul(argv[4]) : max(1u, thread::hardware_concurrency());
+
+        atomic<size_t> next_record = 0;
+        vector<ThreadResult> results(thread_count);
+        vector<thread> threads;
+        const Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < thread_count; ++i) {
+            threads.emplace_back([&, i] {
+                ThreadResult& result = results[i];
+                for (size_t index = next_record++; index < records.size(); index = next_record++) {
+                    Clock::time_point scheduled = Clock::now();
+                    if (!schedule.empty()) {
+                        scheduled = start + schedule[index];
+                        this_thread::sleep_until(scheduled);
+                    }
+                    const QueryLogRecord& record = records[index];
+                    size_t result_count = 0;
+                    try {
+                        result_count = server.FindTopDocuments(execution::seq, record.query, record.filter).size();
+                    } catch (const exception&) {
+                    }
+                    result.latencies_us.push_back(chrono::duration<double, micro>(Clock::now() - scheduled).count());
+                    result.mismatches += result_count != record.result_count;
+                }
+            });
+        }
+        for (thread& t : threads) {
+            t.join();
+        }
+        const double elapsed = chrono::duration<double>(Clock::now() - start).count();
+
+        vector<double> latencies;
+        size_t mismatches = 0;
+        for (const ThreadResult& result : results) {
+            latencies.insert(latencies.end(), result.latencies_us.begin(), result.latencies_us.end());
+            mismatches += result.mismatches;
+        }
+        sort(latencies.begin(), latencies.end());
+        const auto percentile = [&latencies](double p) {
+            return latencies[min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))];
+        };
+        cout << "documents: " << document_id << ", queries: " << latencies.size() << ", truncated queries skipped: "
+             << truncated_count << ", result count differs from the log: " << mismatches << endl;
+        cout << "throughput: " << latencies.size() / elapsed << " queries/s" << endl;
+        cout << "latency, us: p50 " << percentile(0.5) << ", p90 " << percentile(0.9) << ", p99 " << percentile(0.99)
+             << ", p99.9 " << percentile(0.999) << ", max " << latencies.back() << endl;
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
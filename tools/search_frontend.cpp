@@ -0,0 +1,56 @@
+// Serves documents over the line protocol of SearchFrontend until SIGINT or SIGTERM.
+// Every line of the documents file is a document, its id is the line number from 0.
+// Usage: search_frontend <documents file> [port] [workers] [stop words]
+
+#include <csignal>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "search_frontend.h"
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+SearchFrontend* frontend = nullptr;
+
+void HandleSignal(int) {
+    frontend->Stop();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 5) {
+        cerr << "Usage: " << argv[0] << " <documents file> [port] [workers] [stop words]" << endl;
+        return 2;
+    }
+    try {
+        SearchServer server(argc > 4 ? string(argv[4]) : string());
+        ifstream documents(argv[1]);
+        if (!documents) {
+            cerr << "Cannot open " << argv[1] << endl;
+            return 1;
+        }
+        int document_id = 0;
+        for (string document; getline(documents, document);) {
+            server.AddDocument(document_id++, document, DocumentStatus::ACTUAL, {});
+        }
+
+        FrontendOptions options;
+        options.port = argc > 2 ? static_cast<uint16_t>(stoi(argv[2])) : 0;
+        options.worker_count = argc > 3 ? stoul(argv[3]) : 0;
+        SearchFrontend search_frontend(server, options);
+        frontend = &search_frontend;
+        signal(SIGINT, HandleSignal);
+        signal(SIGTERM, HandleSignal);
+        cout << "Serving " << document_id << " documents on port " << search_frontend.GetPort() << endl;
+        search_frontend.Serve();
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
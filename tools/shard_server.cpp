@@ -0,0 +1,41 @@
+// Serves one shard of a collection over a Unix-domain socket until SIGINT or SIGTERM.
+// Documents are added through ShardBroker.
+// Usage: shard_server <socket path> [stop words]
+
+#include <csignal>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "search_server.h"
+#include "shard_server.h"
+
+using namespace std;
+
+namespace {
+
+ShardServer* shard_server = nullptr;
+
+void HandleSignal(int) {
+    shard_server->Stop();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 3) {
+        cerr << "Usage: " << argv[0] << " <socket path> [stop words]" << endl;
+        return 2;
+    }
+    try {
+        SearchServer server(argc == 3 ? string(argv[2]) : string());
+        ShardServer shard(server, argv[1]);
+        shard_server = &shard;
+        signal(SIGINT, HandleSignal);
+        signal(SIGTERM, HandleSignal);
+        shard.Serve();
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}